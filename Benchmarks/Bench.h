@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// shared bits of the micro-benchmarks: a best-of timer and a deterministic test signal. each
+// benchmark is its own executable that prints a small table; none of them run as part of a
+// normal build (see MSDAW_BUILD_BENCHMARKS)
+
+namespace Bench {
+	constexpr double kPi = 3.14159265358979323846;
+
+	// milliseconds of the fastest of `runs` calls to `body`. the best run is the one least
+	// disturbed by the rest of the machine, which is what a kernel comparison wants
+	template <typename Body>
+	double BestOfMs(int runs, Body&& body) {
+		double best = 1e30;
+		for (int r = 0; r < runs; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			body();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+
+	// interleaved frames of a few detuned partials with a decaying click every half second, so
+	// the tonal modes have something to align and the transient paths something to find
+	inline std::vector<float> MakeSignal(double sampleRate, double seconds, int channels) {
+		size_t frames = (size_t)(sampleRate * seconds);
+		std::vector<float> out(frames * channels);
+		for (size_t i = 0; i < frames; ++i) {
+			double t = (double)i / sampleRate;
+			double click = std::exp(-std::fmod(t, 0.5) * 60.0);
+			for (int c = 0; c < channels; ++c) {
+				double detune = 1.0 + 0.002 * c;
+				double v = 0.3 * std::sin(2.0 * kPi * 220.0 * detune * t) + 0.2 * std::sin(2.0 * kPi * 331.0 * detune * t) +
+						   0.1 * std::sin(2.0 * kPi * 1250.0 * detune * t) + 0.3 * click * std::sin(2.0 * kPi * 3000.0 * t);
+				out[i * channels + c] = (float)v;
+			}
+		}
+		return out;
+	}
+
+	// sums a buffer so the work behind it can't be optimized away, and so two runs that should
+	// match can be seen to
+	inline double Checksum(const std::vector<float>& buffer) {
+		double sum = 0.0;
+		for (size_t i = 0; i < buffer.size(); ++i)
+			sum += buffer[i] * (double)((i % 7) + 1);
+		return sum;
+	}
+}
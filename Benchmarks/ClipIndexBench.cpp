@@ -0,0 +1,80 @@
+#include "PrecompHeader.h"
+#include "Bench.h"
+#include "Track.h"
+
+// finding the clips a block overlaps on a track of 10k clips: ClipIntervalIndex::Find against
+// the linear scan over every clip it replaced, for 512-frame blocks at 120 bpm spread over the
+// whole arrangement, plus the cost of building the index when a snapshot is captured
+
+namespace {
+	constexpr int kClips = 10000;
+	constexpr double kSampleRate = 48000.0;
+	constexpr double kBpm = 120.0;
+	constexpr int kBlock = 512;
+	constexpr int kBlockStride = 64; // every 64th block: the scan over all of them takes minutes
+	constexpr int kRuns = 5;
+}
+
+int main() {
+	// clips of 1..8 beats with 0..3 beat gaps, and every 16th one long enough to overlap the
+	// next few, which is what makes the index keep a running max of the end beats
+	std::vector<ClipRenderState> clips(kClips);
+	uint32_t seed = 1;
+	auto next = [&seed](int range) {
+		seed = seed * 1664525u + 1013904223u;
+		return (int)((seed >> 8) % (uint32_t)range);
+	};
+	double beat = 0.0;
+	for (int i = 0; i < kClips; ++i) {
+		double length = 1.0 + next(8);
+		if (i % 16 == 0)
+			length += 24.0;
+		clips[i].startBeat = beat;
+		clips[i].endBeat = beat + length;
+		beat += 1.0 + next(8) + next(4);
+	}
+	double songEnd = beat;
+
+	// the index is built over the clips in capture order, which needn't be start order
+	for (int i = kClips - 1; i > 0; --i)
+		std::swap(clips[i], clips[next(i + 1)]);
+
+	ClipIntervalIndex index;
+	double buildMs = Bench::BestOfMs(kRuns, [&] { index.Build(clips); });
+
+	double beatsPerBlock = kBlock / kSampleRate * kBpm / 60.0;
+	int64_t blocks = (int64_t)(songEnd / beatsPerBlock) / kBlockStride + 1;
+
+	auto overlaps = [](const ClipRenderState& clip, double begin, double end) {
+		return clip.startBeat < end && clip.endBeat > begin;
+	};
+
+	int64_t foundLinear = 0;
+	double linearMs = Bench::BestOfMs(kRuns, [&] {
+		foundLinear = 0;
+		for (int64_t b = 0; b < blocks; ++b) {
+			double begin = b * kBlockStride * beatsPerBlock, end = begin + beatsPerBlock;
+			for (const ClipRenderState& clip : clips)
+				foundLinear += overlaps(clip, begin, end);
+		}
+	});
+
+	int64_t foundIndexed = 0;
+	double indexedMs = Bench::BestOfMs(kRuns, [&] {
+		foundIndexed = 0;
+		for (int64_t b = 0; b < blocks; ++b) {
+			double begin = b * kBlockStride * beatsPerBlock, end = begin + beatsPerBlock;
+			auto [first, last] = index.Find(begin, end);
+			for (size_t k = first; k < last; ++k)
+				foundIndexed += overlaps(clips[index.order[k]], begin, end);
+		}
+	});
+
+	printf("%d clips over %.0f beats, %lld blocks of %d frames at %.0f bpm, best of %d\n", kClips, songEnd,
+		   (long long)blocks, kBlock, kBpm, kRuns);
+	printf("index build        %10.3f ms\n", buildMs);
+	printf("linear scan        %10.3f us a block\n", linearMs * 1000.0 / blocks);
+	printf("index              %10.3f us a block\n", indexedMs * 1000.0 / blocks);
+	printf("clips found        %s (%lld)\n", foundLinear == foundIndexed ? "same" : "DIFFERENT", (long long)foundIndexed);
+	return foundLinear == foundIndexed ? 0 : 1;
+}
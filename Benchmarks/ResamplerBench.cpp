@@ -0,0 +1,53 @@
+#include "PrecompHeader.h"
+#include "Bench.h"
+#include "Clips/Resampler.h"
+
+// what each ResampleQuality costs unwarped and Re-Pitch playback: 10 s of stereo output in
+// 512-frame blocks, at the step of a 44.1 kHz file on a 48 kHz device and at +7 semitones
+
+namespace {
+	constexpr double kSampleRate = 48000.0;
+	constexpr double kSeconds = 10.0;
+	constexpr int kChannels = 2;
+	constexpr int kBlock = 512;
+	constexpr int kRuns = 5;
+}
+
+int main() {
+	const struct {
+		double step;
+		const char* name;
+	} steps[] = {
+		{44100.0 / 48000.0, "44.1k on 48k"},
+		{std::pow(2.0, 7.0 / 12.0), "+7 st"},
+	};
+	const ResampleQuality qualities[] = {ResampleQuality::Linear, ResampleQuality::Cubic, ResampleQuality::Sinc};
+
+	int64_t total = (int64_t)(kSampleRate * kSeconds);
+	std::vector<float> out((size_t)total * kChannels);
+
+	printf("%.0f s of stereo output in %d-frame blocks, best of %d\n", kSeconds, kBlock, kRuns);
+	printf("%-14s %8s", "step", "");
+	for (ResampleQuality quality : qualities)
+		printf(" %10s", GetResampleQualityName(quality));
+	printf("\n");
+	for (const auto& s : steps) {
+		// enough source for the whole output, and the filters' reach past its end
+		std::vector<float> source = Bench::MakeSignal(kSampleRate, kSeconds * s.step + 1.0, kChannels);
+		printf("%-14s %8.3f", s.name, s.step);
+		for (ResampleQuality quality : qualities) {
+			double ms = Bench::BestOfMs(kRuns, [&] {
+				std::fill(out.begin(), out.end(), 0.0f);
+				for (int64_t frame = 0; frame < total; frame += kBlock) {
+					int count = (int)std::min<int64_t>(kBlock, total - frame);
+					ResampleBlock(source.data(), source.size(), kChannels, 0, (double)frame * s.step, s.step, count,
+								  kChannels, out.data() + frame * kChannels, quality);
+				}
+			});
+			printf(" %7.1f ms", ms);
+		}
+		printf("\n");
+	}
+	printf("(checksum %.3f)\n", Bench::Checksum(out));
+	return 0;
+}
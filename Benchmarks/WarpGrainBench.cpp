@@ -0,0 +1,79 @@
+#include "PrecompHeader.h"
+#include "Bench.h"
+#include "Clips/WarpEngine.h"
+
+// the granular warp modes' grain lay-down (RenderWarpedBlock without a vocoder): 10 s of stereo
+// at 48 kHz in 512-frame blocks, per mode, with the alignment table warm. compares evaluating
+// the window per grain, the window table with the scalar kernel, and the window table with the
+// fastest kernel the cpu runs, and checks all three render the same bits
+
+namespace {
+	constexpr double kSampleRate = 48000.0;
+	constexpr double kSeconds = 10.0;
+	constexpr int kChannels = 2;
+	constexpr int kBlock = 512;
+	constexpr int kRuns = 5;
+
+	struct Result {
+		double ms = 0.0;
+		double checksum = 0.0;
+	};
+
+	Result Render(const std::vector<float>& source, const WarpRenderParams& params, WarpAlignmentTable* alignment,
+				  const WarpWindowTable* window, bool scalarOnly) {
+		SetWarpScalarKernelOnly(scalarOnly);
+		int64_t total = (int64_t)(kSampleRate * kSeconds);
+		std::vector<float> out((size_t)total * kChannels);
+		Result result;
+		result.ms = Bench::BestOfMs(kRuns, [&] {
+			std::fill(out.begin(), out.end(), 0.0f);
+			for (int64_t frame = 0; frame < total; frame += kBlock) {
+				int count = (int)std::min<int64_t>(kBlock, total - frame);
+				RenderWarpedBlock(source.data(), source.size(), kChannels, 0, frame, count, kChannels,
+								  out.data() + frame * kChannels, params, alignment, window);
+			}
+		});
+		result.checksum = Bench::Checksum(out);
+		SetWarpScalarKernelOnly(false);
+		return result;
+	}
+}
+
+int main() {
+	// a little longer than the output, so a slower-than-real-time stretch never runs off the end
+	std::vector<float> source = Bench::MakeSignal(kSampleRate, kSeconds * 1.25, kChannels);
+	uint64_t sourceFrames = source.size() / kChannels;
+
+	const struct {
+		WarpMode mode;
+		const char* name;
+	} modes[] = {
+		{WarpMode::Beats, "Beats"},
+		{WarpMode::Tones, "Tones"},
+		{WarpMode::Texture, "Texture"},
+		{WarpMode::Complex, "Complex"},
+		{WarpMode::ComplexPro, "ComplexPro"},
+	};
+
+	printf("grain lay-down, %.0f s of stereo at %.0f Hz in %d-frame blocks, best of %d\n", kSeconds, kSampleRate, kBlock, kRuns);
+	printf("%-11s %14s %14s %14s  %s\n", "mode", "no table", "table+scalar", "table+fastest", "output");
+	for (const auto& m : modes) {
+		WarpRenderParams params;
+		params.mode = m.mode;
+		params.sampleRate = kSampleRate;
+		params.speed = 0.9; // a tempo a little slower than the file's
+		params.pitchRead = 1.0;
+		params.fluctuation = 0.3;
+
+		auto alignment = std::make_shared<WarpAlignmentTable>(params, sourceFrames);
+		WarpWindowTable window(params);
+		Render(source, params, alignment.get(), &window, false); // warms the alignment table
+
+		Result none = Render(source, params, alignment.get(), nullptr, true);
+		Result scalar = Render(source, params, alignment.get(), &window, true);
+		Result fastest = Render(source, params, alignment.get(), &window, false);
+		bool same = none.checksum == scalar.checksum && scalar.checksum == fastest.checksum;
+		printf("%-11s %11.1f ms %11.1f ms %11.1f ms  %s\n", m.name, none.ms, scalar.ms, fastest.ms, same ? "identical" : "DIFFERS");
+	}
+	return 0;
+}
@@ -11,7 +11,7 @@ AppConfig& AppConfig::Instance() {
 	return instance;
 }
 
-std::string AppConfig::ConfigPath() const {
+std::string AppConfig::ConfigDirectory() const {
 #ifdef _WIN32
 	const char* appData = std::getenv("APPDATA");
 	std::filesystem::path base = appData ? std::filesystem::path(appData) : std::filesystem::current_path();
@@ -21,7 +21,11 @@ std::string AppConfig::ConfigPath() const {
 	std::filesystem::path base = home ? std::filesystem::path(home) : std::filesystem::current_path();
 	base /= ".config/MSDAW";
 #endif
-	return (base / "config.txt").string();
+	return base.string();
+}
+
+std::string AppConfig::ConfigPath() const {
+	return (std::filesystem::path(ConfigDirectory()) / "config.txt").string();
 }
 
 void AppConfig::Load() {
@@ -38,6 +42,54 @@ void AppConfig::Load() {
 			int v = 1;
 			ss >> v;
 			pluginEditorsNative = (v != 0);
+		} else if (key == "export_format") {
+			int v = 0;
+			ss >> v;
+			if (v >= (int)WavSampleFormat::Int16 && v <= (int)WavSampleFormat::Float64)
+				exportFormat = (WavSampleFormat)v;
+		} else if (key == "export_dither") {
+			int v = 0;
+			ss >> v;
+			if (v >= (int)WavDither::None && v <= (int)WavDither::NoiseShaped)
+				exportDither = (WavDither)v;
+		} else if (key == "stream_threshold_mb") {
+			int v = 0;
+			ss >> v;
+			if (v >= 0)
+				streamThresholdMB = v;
+		} else if (key == "map_audio_files") {
+			int v = 0;
+			ss >> v;
+			mapAudioFiles = (v != 0);
+		} else if (key == "autosave_interval_s") {
+			int v = 0;
+			ss >> v;
+			if (v >= 0)
+				autosaveIntervalSeconds = v;
+		} else if (key == "freeze_warped_clips") {
+			int v = 1;
+			ss >> v;
+			freezeWarpedClips = (v != 0);
+		} else if (key == "warp_freeze_mb") {
+			int v = 0;
+			ss >> v;
+			if (v >= 0)
+				warpFreezeMemoryMB = v;
+		} else if (key == "resample_quality") {
+			int v = -1;
+			ss >> v;
+			if (v >= (int)ResampleQuality::Linear && v <= (int)ResampleQuality::Sinc)
+				resampleQuality = (ResampleQuality)v;
+		} else if (key == "export_resample_quality") {
+			int v = -1;
+			ss >> v;
+			if (v >= (int)ResampleQuality::Linear && v <= (int)ResampleQuality::Sinc)
+				exportResampleQuality = (ResampleQuality)v;
+		} else if (key == "playback_fps") {
+			int v = 0;
+			ss >> v;
+			if (v >= 1)
+				playbackFrameRate = v;
 		}
 	}
 }
@@ -52,4 +104,14 @@ void AppConfig::Save() const {
 		return;
 
 	out << "plugin_editors_native " << (pluginEditorsNative ? 1 : 0) << "\n";
+	out << "export_format " << (int)exportFormat << "\n";
+	out << "export_dither " << (int)exportDither << "\n";
+	out << "stream_threshold_mb " << streamThresholdMB << "\n";
+	out << "map_audio_files " << (mapAudioFiles ? 1 : 0) << "\n";
+	out << "autosave_interval_s " << autosaveIntervalSeconds << "\n";
+	out << "freeze_warped_clips " << (freezeWarpedClips ? 1 : 0) << "\n";
+	out << "warp_freeze_mb " << warpFreezeMemoryMB << "\n";
+	out << "resample_quality " << (int)resampleQuality << "\n";
+	out << "export_resample_quality " << (int)exportResampleQuality << "\n";
+	out << "playback_fps " << playbackFrameRate << "\n";
 }
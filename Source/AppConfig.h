@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include "WavWriter.h"
+#include "Clips/Resampler.h"
 
 // small app-wide configuration that persists across sessions (separate from the
 // per-project file). Stored as a tiny key/value text file under %APPDATA%/MSDAW
@@ -15,8 +17,41 @@ public:
 	// EditorScalingMode on AudioProcessor)
 	bool pluginEditorsNative = true;
 
+	// sample format and dither used by File > Export Audio
+	WavSampleFormat exportFormat = WavSampleFormat::Int16;
+	WavDither exportDither = WavDither::Triangular;
+
+	// how unwarped and Re-Pitch clips are resampled while playing, and in File > Export Audio,
+	// which has no deadline and so defaults to the best
+	ResampleQuality resampleQuality = ResampleQuality::Cubic;
+	ResampleQuality exportResampleQuality = ResampleQuality::Sinc;
+
+	// audio files at least this big (in MB) play from disk instead of being decoded into
+	// memory on load; 0 decodes everything
+	int streamThresholdMB = 256;
+
+	// map audio files instead of decoding them: float wavs play in place from the os page
+	// cache and integer pcm is converted as it plays. takes precedence over streaming
+	bool mapAudioFiles = false;
+
+	// seconds between crash-recovery autosaves of an edited project; 0 turns them off
+	int autosaveIntervalSeconds = 120;
+
+	// warped clips whose warp settings and tempo hold still are rendered ahead of time in the
+	// background and played back as a copy. up to this many MB of those renders stay in memory;
+	// the rest go to scratch files and stream back from disk
+	bool freezeWarpedClips = true;
+	int warpFreezeMemoryMB = 1024;
+
+	// frames per second the ui redraws at while following playback (or meters, or an open
+	// plugin editor). idle, it only redraws on input
+	int playbackFrameRate = 30;
+
 	void Load();
 	void Save() const;
+
+	// %APPDATA%/MSDAW (~/.config/MSDAW elsewhere): the config file, and the autosave under it
+	std::string ConfigDirectory() const;
 private:
 	AppConfig() = default;
 	std::string ConfigPath() const;
@@ -2,6 +2,7 @@
 #include "AudioEngine.h"
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 
 static int AudioCallbackWrapper(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames,
 								double streamTime, RtAudioStreamStatus status, void* userData) {
@@ -11,6 +12,7 @@ static int AudioCallbackWrapper(void* outputBuffer, void* inputBuffer, unsigned
 
 AudioEngine::AudioEngine()
 	: dac(RtAudio::UNSPECIFIED) {
+	mBlockMIDIEvents.reserve(kMaxLiveMIDIEventsPerBlock);
 }
 
 AudioEngine::~AudioEngine() {
@@ -37,11 +39,17 @@ bool AudioEngine::Init() {
 	// initialize project
 	mProject = std::make_unique<Project>();
 	mProject->Initialize();
-	mProject->PrepareToPlay(sampleRate);
+	// the one project with a deadline: its workers get the audio thread's treatment
+	mProject->SetRenderThreadCount(-1, true);
+	mProject->PrepareToPlay(sampleRate, (int)bufferFrames);
 
 	try {
+		unsigned int requestedFrames = bufferFrames;
 		dac.openStream(&parameters, nullptr, RTAUDIO_FLOAT32, (unsigned int)sampleRate, &bufferFrames, &AudioCallbackWrapper, (void*)this);
 		isStreamOpen = true;
+		// the device may have picked another buffer size; size the mixing buffers for it
+		if (bufferFrames != requestedFrames)
+			mProject->PrepareToPlay(sampleRate, (int)bufferFrames);
 	} catch (std::exception& e) {
 		std::cout << '\n'
 				  << e.what() << '\n';
@@ -77,14 +85,20 @@ bool AudioEngine::IsStreamRunning() const {
 	return isStreamOpen && dac.isStreamRunning();
 }
 
+double AudioEngine::Now() {
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
 void AudioEngine::SendMIDIEvent(int status, int note, int velocity) {
-	std::lock_guard<std::mutex> lock(mMIDIMutex);
-	MIDIMessage msg;
-	msg.status = (uint8_t)status;
-	msg.data1 = (uint8_t)note;
-	msg.data2 = (uint8_t)velocity;
-	msg.frameIndex = 0;
-	mPendingMIDIMessages.push_back(msg);
+	LiveMIDIEvent ev;
+	ev.message.status = (uint8_t)status;
+	ev.message.data1 = (uint8_t)note;
+	ev.message.data2 = (uint8_t)velocity;
+	ev.message.frameIndex = 0; // resolved from captureTime by the callback
+	ev.captureTime = Now();
+	if (!mMIDIQueue.Push(ev))
+		std::cout << "Live MIDI queue full, dropped event\n";
 }
 
 int AudioEngine::OnAudioCallback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames,
@@ -96,14 +110,21 @@ int AudioEngine::OnAudioCallback(void* outputBuffer, void* inputBuffer, unsigned
 	(void)status;
 	(void)userData;
 
-	// 1. retrieve pending live MIDI events
-	std::vector<MIDIMessage> blockMIDIEvents;
-	{
-		std::lock_guard<std::mutex> lock(mMIDIMutex);
-		if (!mPendingMIDIMessages.empty()) {
-			blockMIDIEvents = mPendingMIDIMessages;
-			mPendingMIDIMessages.clear();
-		}
+	// 1. retrieve pending live MIDI events. this block stands for the audio captured over the
+	// last nBufferFrames of wall time, so an event is placed at its offset into that window:
+	// live input gets a constant one-buffer latency instead of up to one buffer of jitter.
+	// events stamped after the callback started wait for the next block
+	double blockEndTime = Now();
+	double blockStartTime = blockEndTime - (double)nBufferFrames / sampleRate;
+	mBlockMIDIEvents.clear();
+	while (const LiveMIDIEvent* ev = mMIDIQueue.Front()) {
+		if (ev->captureTime > blockEndTime)
+			break;
+		MIDIMessage msg = ev->message;
+		int64_t frame = (int64_t)((ev->captureTime - blockStartTime) * sampleRate);
+		msg.frameIndex = (int)std::clamp<int64_t>(frame, 0, (int64_t)nBufferFrames - 1);
+		mBlockMIDIEvents.push_back(msg);
+		mMIDIQueue.Pop();
 	}
 
 	// 2. clear output buffer
@@ -111,7 +132,7 @@ int AudioEngine::OnAudioCallback(void* outputBuffer, void* inputBuffer, unsigned
 
 	// 3. process project
 	if (mProject) {
-		mProject->ProcessBlock(out, nBufferFrames, 2, blockMIDIEvents);
+		mProject->ProcessBlock(out, nBufferFrames, 2, mBlockMIDIEvents);
 	}
 
 	// 4. hard clip output to prevent OS limiter ducking
@@ -1,10 +1,17 @@
 #pragma once
 #include <RtAudio.h>
 #include <vector>
-#include <mutex>
 #include <memory>
 #include "Project.h"
 #include "MIDITypes.h"
+#include "SpscQueue.h"
+
+// a live MIDI event stamped with when it was captured, so the callback can place it at the
+// matching frame of the next block instead of piling everything onto frame 0
+struct LiveMIDIEvent {
+	MIDIMessage message;
+	double captureTime = 0.0; // AudioEngine::Now() seconds
+};
 
 class AudioEngine {
 public:
@@ -20,9 +27,12 @@ public:
 
 	Project* GetProject() { return mProject.get(); }
 
-	// inject live MIDI event
+	// inject live MIDI event (UI thread only: the queue has a single producer)
 	void SendMIDIEvent(int status, int note, int velocity);
 
+	// monotonic clock shared by MIDI capture and the audio callback, in seconds
+	static double Now();
+
 	int OnAudioCallback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames,
 						double streamTime, RtAudioStreamStatus status, void* userData);
 private:
@@ -33,7 +43,8 @@ private:
 	// the current loaded project
 	std::unique_ptr<Project> mProject;
 
-	// thread safety for realtime MIDI injection
-	std::mutex mMIDIMutex;
-	std::vector<MIDIMessage> mPendingMIDIMessages;
+	// lock-free realtime MIDI injection: UI thread pushes, audio callback pops
+	SpscQueue<LiveMIDIEvent, kMaxLiveMIDIEventsPerBlock> mMIDIQueue;
+	// the block's live events, reserved up front so the callback never grows it
+	std::vector<MIDIMessage> mBlockMIDIEvents;
 };
@@ -29,6 +29,12 @@ struct ProcessContext {
 	// a note lined up with the playhead still fires. must stay false during contiguous
 	// playback, or notes landing on a block boundary would double-trigger
 	bool playheadJumped = false;
+	// true when rendering to a file: streamed clips then read from disk synchronously
+	// instead of playing whatever the disk thread has prefetched
+	bool isOffline = false;
+	// how unwarped and Re-Pitch clips interpolate their source: the user's playback setting, or
+	// the export's
+	ResampleQuality resampleQuality = ResampleQuality::Linear;
 };
 
 // base class for audio processors
@@ -45,8 +51,9 @@ public:
 	// check if processor is instrument
 	virtual bool IsInstrument() const { return false; }
 
-	// setup
-	virtual void PrepareToPlay(double sampleRate) = 0;
+	// setup. no Process call will get more than maxBlockFrames frames until the next prepare:
+	// the device buffer while playing, an export's block size while rendering
+	virtual void PrepareToPlay(double sampleRate, int maxBlockFrames) = 0;
 
 	// reset state: a hard panic that also clears reverb/delay tails and internal buffers.
 	// used on transport stop and seek, where a clean restart is wanted
@@ -0,0 +1,294 @@
+#include "PrecompHeader.h"
+#include "Autosave.h"
+#include "AppConfig.h"
+#include "AudioProcessor.h"
+#include "Project.h"
+#include "ProjectFile.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	constexpr const char* kManifestName = "manifest";
+	constexpr int kCapturesPerRefresh = 5; // every fifth autosave asks every plugin again
+
+	uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+		// fnv-1a: names the chunk files, so only has to tell chunks apart, not resist anyone
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool IsPlugin(const AudioProcessor& proc) {
+		std::string id = proc.GetProcessorId();
+		return id == "VST" || id == "VST3";
+	}
+
+	// writes `path` and flushes it to the disk before returning, so a manifest renamed in
+	// afterwards never names a file the os was still holding in its cache
+	bool WriteFileDurably(const std::filesystem::path& path, const void* data, size_t size) {
+#ifdef _WIN32
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		const uint8_t* bytes = (const uint8_t*)data;
+		bool ok = true;
+		while (ok && size > 0) {
+			DWORD chunk = (DWORD)std::min<size_t>(size, 1u << 30);
+			DWORD written = 0;
+			ok = WriteFile(file, bytes, chunk, &written, nullptr) && written == chunk;
+			bytes += written;
+			size -= written;
+		}
+		ok = ok && FlushFileBuffers(file);
+		CloseHandle(file);
+		return ok;
+#else
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			return false;
+		const uint8_t* bytes = (const uint8_t*)data;
+		bool ok = true;
+		while (ok && size > 0) {
+			ssize_t written = write(fd, bytes, size);
+			ok = written > 0;
+			if (ok) {
+				bytes += written;
+				size -= (size_t)written;
+			}
+		}
+		ok = ok && fsync(fd) == 0;
+		close(fd);
+		return ok;
+#endif
+	}
+
+	// makes a rename inside `directory` durable. windows commits renames with the file's own
+	// metadata, posix needs the directory itself synced
+	void SyncDirectory(const std::filesystem::path& directory) {
+#ifndef _WIN32
+		int fd = open(directory.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			fsync(fd);
+			close(fd);
+		}
+#else
+		(void)directory;
+#endif
+	}
+}
+
+const std::string& ProcessorStateCache::GetState(const std::shared_ptr<AudioProcessor>& proc) {
+	// built-in processors are a handful of parameters; caching them would cost more than it saves
+	if (!IsPlugin(*proc)) {
+		std::ostringstream state;
+		proc->Save(state);
+		mScratch = state.str();
+		return mScratch;
+	}
+
+	bool bypassed = proc->IsBypassed();
+	uint64_t hash = HashBytes(&bypassed, sizeof(bypassed));
+	for (const auto& param : proc->GetParameters())
+		hash = HashBytes(&param->value, sizeof(param->value), hash);
+
+	Entry& entry = mEntries[proc.get()];
+	if (mRefreshAll || entry.proc.lock() != proc || entry.parameterHash != hash) {
+		std::ostringstream state;
+		proc->Save(state);
+		entry.proc = proc;
+		entry.parameterHash = hash;
+		entry.state = state.str();
+	}
+	entry.seen = true;
+	return entry.state;
+}
+
+void ProcessorStateCache::BeginCapture(bool refreshAll) {
+	mRefreshAll = refreshAll;
+	for (auto& [key, entry] : mEntries)
+		entry.seen = false;
+}
+
+void ProcessorStateCache::EndCapture() {
+	std::erase_if(mEntries, [](const auto& item) { return !item.second.seen; });
+	mScratch.clear();
+	mScratch.shrink_to_fit();
+}
+
+Autosaver::Autosaver(std::string directory, uint64_t revision)
+	: mDirectory(std::move(directory)), mSavedRevision(revision) {}
+
+Autosaver::~Autosaver() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mCondition.notify_all();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+void Autosaver::Reset(uint64_t revision) {
+	mSavedRevision = revision;
+	mLastSaveTime = -1.0;
+	mCapturesSinceRefresh = 0;
+}
+
+void Autosaver::Update(Project& project, uint64_t revision) {
+	int interval = AppConfig::Instance().autosaveIntervalSeconds;
+	if (interval <= 0)
+		return;
+
+	double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (mLastSaveTime < 0.0)
+		mLastSaveTime = now; // the first autosave is one interval in, not at startup
+	if (now - mLastSaveTime < interval)
+		return;
+	if (revision == mSavedRevision)
+		return;
+
+	{
+		// still writing the last one: try again next frame rather than queue up
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mWriting || mHasPending)
+			return;
+	}
+
+	bool refresh = ++mCapturesSinceRefresh >= kCapturesPerRefresh;
+	if (refresh)
+		mCapturesSinceRefresh = 0;
+
+	ChunkWriter writer;
+	mCache.BeginCapture(refresh);
+	project.Save(writer, &mCache);
+	mCache.EndCapture();
+
+	mLastSaveTime = now;
+	mSavedRevision = revision;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPending = std::move(writer.GetData());
+		mHasPending = true;
+		if (!mThread.joinable())
+			mThread = std::thread(&Autosaver::Run, this);
+	}
+	mCondition.notify_all();
+}
+
+void Autosaver::Run() {
+	std::vector<uint8_t> snapshot;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mQuit || mHasPending; });
+			if (!mHasPending)
+				return; // quitting with nothing left to write
+			snapshot = std::move(mPending);
+			mPending.clear();
+			mHasPending = false;
+			mWriting = true;
+		}
+
+		Write(snapshot);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mWriting = false;
+	}
+}
+
+void Autosaver::Write(const std::vector<uint8_t>& snapshot) {
+	namespace fs = std::filesystem;
+	fs::path directory(mDirectory);
+	std::error_code ec;
+	fs::create_directories(directory, ec);
+
+	ChunkReader chunks;
+	if (!ChunkReader::OpenFile(snapshot.data(), snapshot.size(), chunks))
+		return;
+
+	// the chunks as they sit in the snapshot: header, id, size, payload back to back
+	std::vector<std::string> names;
+	const uint8_t* chunkStart = snapshot.data() + 8;
+	ChunkReader payload;
+	uint32_t id = 0;
+	while (chunks.Next(id, payload)) {
+		size_t size = 8 + payload.GetRemaining();
+		char name[32];
+		snprintf(name, sizeof(name), "%016" PRIx64 ".chunk", HashBytes(chunkStart, size));
+		names.push_back(name);
+
+		// same bytes, same name: a chunk already on disk is skipped without being rewritten
+		if (!mWritten.count(name) || !fs::exists(directory / name, ec)) {
+			if (!WriteFileDurably(directory / name, chunkStart, size))
+				return; // leave the previous manifest in charge
+			mWritten.insert(name);
+		}
+		chunkStart += size;
+	}
+
+	std::string manifest;
+	for (const auto& name : names)
+		manifest += name + "\n";
+	fs::path manifestPath = directory / kManifestName;
+	fs::path tempPath = directory / (std::string(kManifestName) + ".tmp");
+	if (!WriteFileDurably(tempPath, manifest.data(), manifest.size()))
+		return;
+	fs::rename(tempPath, manifestPath, ec);
+	if (ec)
+		return;
+	SyncDirectory(directory);
+
+	// chunks the new manifest no longer names are garbage now
+	std::set<std::string> live(names.begin(), names.end());
+	for (const auto& entry : fs::directory_iterator(directory, ec)) {
+		std::string name = entry.path().filename().string();
+		if (entry.path().extension() == ".chunk" && !live.count(name)) {
+			fs::remove(entry.path(), ec);
+			mWritten.erase(name);
+		}
+	}
+}
+
+bool Autosaver::HasAutosave() const {
+	std::error_code ec;
+	return std::filesystem::exists(std::filesystem::path(mDirectory) / kManifestName, ec);
+}
+
+bool Autosaver::BeginRecover(Project& project, ProjectLoader& loader) const {
+	namespace fs = std::filesystem;
+	fs::path directory(mDirectory);
+	std::ifstream manifest(directory / kManifestName);
+	if (!manifest.is_open())
+		return false;
+
+	// reassemble the file the chunks came from
+	ChunkWriter file;
+	file.WriteHeader();
+	std::string name;
+	while (std::getline(manifest, name)) {
+		if (name.empty())
+			continue;
+		std::ifstream chunk(directory / name, std::ios::binary);
+		if (!chunk.is_open())
+			return false;
+		std::vector<char> bytes((std::istreambuf_iterator<char>(chunk)), std::istreambuf_iterator<char>());
+		file.WriteBytes(bytes.data(), bytes.size());
+	}
+	return project.BeginLoad(file.GetData().data(), file.GetData().size(), loader);
+}
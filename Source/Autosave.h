@@ -0,0 +1,89 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class AudioProcessor;
+class Project;
+class ProjectLoader;
+
+// plugin state as of the last capture. asking a plugin for its chunk is the one expensive part
+// of serializing a project, so an autosave reuses the last one while none of the plugin's
+// parameters moved. state a plugin changes without touching a parameter (a preset picked in
+// its own editor) is picked up by the next refresh capture
+class ProcessorStateCache {
+public:
+	// what proc->Save writes, for the capture in progress
+	const std::string& GetState(const std::shared_ptr<AudioProcessor>& proc);
+
+	// refreshAll saves every plugin again. EndCapture forgets processors the capture didn't see
+	void BeginCapture(bool refreshAll);
+	void EndCapture();
+private:
+	struct Entry {
+		std::weak_ptr<AudioProcessor> proc; // a new processor at a freed address isn't a hit
+		uint64_t parameterHash = 0;
+		std::string state;
+		bool seen = false;
+	};
+
+	std::unordered_map<const AudioProcessor*, Entry> mEntries;
+	std::string mScratch; // state of a built-in processor, never cached
+	bool mRefreshAll = false;
+};
+
+// periodic crash-recovery saves. the ui thread captures the project in the binary format, which
+// holds the project lock only for the in-memory serialization (see ProcessorStateCache); a
+// writer thread does the disk work.
+//
+// the autosave is a directory of chunk files, one per top-level chunk (a track, the settings),
+// named by a hash of their bytes, plus a manifest listing them in order. a save writes only the
+// chunks whose bytes are new, fsyncs them, then swaps in the manifest, so an edit to one track
+// rewrites one file and a crash at any point leaves the previous autosave whole
+class Autosaver {
+public:
+	// `revision` is the project's as it starts out, which needs no autosave
+	Autosaver(std::string directory, uint64_t revision);
+	~Autosaver(); // finishes the save in flight
+
+	Autosaver(const Autosaver&) = delete;
+	Autosaver& operator=(const Autosaver&) = delete;
+
+	// ui thread, once per frame: autosaves when the interval in AppConfig has passed and
+	// `revision` (anything that changes with every edit) moved since the last autosave, or since
+	// the project started out. an untouched project is never saved over the last session's
+	// autosave, which is what File > Recover Autosave restores after a crash
+	void Update(Project& project, uint64_t revision);
+
+	// a new or freshly opened project, at `revision`: nothing is saved until it moves past it
+	void Reset(uint64_t revision);
+
+	bool HasAutosave() const;
+	// starts loading the last autosave into `project`, as Project::BeginLoad
+	bool BeginRecover(Project& project, ProjectLoader& loader) const;
+private:
+	void Run();
+	void Write(const std::vector<uint8_t>& snapshot);
+
+	std::string mDirectory;
+	ProcessorStateCache mCache; // ui thread
+	uint64_t mSavedRevision = 0; // as of the last autosave, or the project's start
+	double mLastSaveTime = -1.0;
+	int mCapturesSinceRefresh = 0;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::vector<uint8_t> mPending; // captured, not yet picked up by the writer
+	bool mHasPending = false;
+	bool mWriting = false;
+	bool mQuit = false;
+	std::thread mThread;
+
+	std::set<std::string> mWritten; // writer thread: chunk files known to be on disk
+};
@@ -1,11 +1,27 @@
 #pragma once
 #include <string>
 #include <iostream>
+#include <memory>
+#include "ProjectFile.h"
+
+// what a clip is, checked in place of rtti: the audio thread looks at every clip it plays
+enum class ClipKind {
+	Audio,
+	MIDI
+};
 
 class Clip {
 public:
 	virtual ~Clip() = default;
 
+	ClipKind GetKind() const { return mKind; }
+
+	// tag-checked downcast to AudioClip or MIDIClip; nullptr for the other kind
+	template <typename T>
+	T* As() { return mKind == T::kKind ? static_cast<T*>(this) : nullptr; }
+	template <typename T>
+	const T* As() const { return mKind == T::kKind ? static_cast<const T*>(this) : nullptr; }
+
 	void SetStartBeat(double beat) { mStartBeat = beat; }
 	double GetStartBeat() const { return mStartBeat; }
 
@@ -39,7 +55,37 @@ public:
 	virtual void Load(std::istream& in) {
 		// parsing handled in subclasses
 	}
+
+	// binary project format: the CHDR chunk here, a subclass's own chunks after it, all inside
+	// the CLIP chunk the track opened. Load gets that chunk's payload
+	virtual void Save(ChunkWriter& out) {
+		out.Begin(ProjectChunk::ClipHeader);
+		out.Write<uint8_t>((uint8_t)mKind);
+		out.Write<int32_t>(mGridNumerator);
+		out.Write<int32_t>(mGridDenominator);
+		out.WriteString(mName);
+		out.Write<double>(mStartBeat);
+		out.Write<double>(mDuration);
+		out.Write<double>(mOffset);
+		out.End();
+	}
+
+	virtual void Load(const ChunkReader& in) {
+		ChunkReader header;
+		if (!in.Find(ProjectChunk::ClipHeader, header))
+			return;
+		header.Read<uint8_t>(); // kind, read by whoever created the clip
+		mGridNumerator = header.Read<int32_t>(mGridNumerator);
+		mGridDenominator = header.Read<int32_t>(mGridDenominator);
+		mName = header.ReadString(mName);
+		mStartBeat = header.Read<double>(mStartBeat);
+		mDuration = header.Read<double>(mDuration);
+		mOffset = header.Read<double>(mOffset);
+	}
 protected:
+	explicit Clip(ClipKind kind) : mKind(kind) {}
+
+	ClipKind mKind;
 	double mStartBeat = 0.0;
 	double mDuration = 4.0; // 1 bar
 	double mOffset = 0.0;	// content offset
@@ -48,3 +94,9 @@ protected:
 	int mGridNumerator = 1;
 	int mGridDenominator = 4;
 };
+
+// Clip::As for code that holds on to the clip
+template <typename T>
+std::shared_ptr<T> ClipCast(const std::shared_ptr<Clip>& clip) {
+	return clip && clip->GetKind() == T::kKind ? std::static_pointer_cast<T>(clip) : nullptr;
+}
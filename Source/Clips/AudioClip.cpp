@@ -1,176 +1,170 @@
 #include "PrecompHeader.h"
 #include "AudioClip.h"
-#include <fstream>
+#include "SamplePool.h"
+#include "WaveformPeaks.h"
+#include "WarpEngine.h"
+#include "WarpVocoder.h"
+#include "WarpFreeze.h"
+#include "AppConfig.h"
+#include <filesystem>
 #include <cmath>
-#include <cstring>
 #include <algorithm>
 #include <iostream>
 
-AudioClip::AudioClip() {
+AudioClip::AudioClip() : Clip(kKind) {
 	mName = "Audio Clip";
 }
 
-struct ChunkHeader {
-	char id[4];
-	uint32_t size;
-};
-
-// riff header
-struct RiffHeader {
-	char riff[4];		  // "RIFF"
-	uint32_t overallSize; //
-	char wave[4];		  // "WAVE"
-};
-
 bool AudioClip::LoadFromFile(const std::string& path) {
-
 	mFilePath = path; // store for serialization
-	std::ifstream file(path, std::ios::binary);
-	if (!file.is_open()) {
-		std::cout << "Failed to open audio file: " << path << "\n";
+	AudioClipSource source;
+	if (!OpenSource(path, source))
 		return false;
-	}
+	SetSource(std::move(source));
+	return true;
+}
 
-	// 1. read riff header
-	RiffHeader riffHeader;
-	file.read((char*)&riffHeader, sizeof(RiffHeader));
+bool AudioClip::OpenSource(const std::string& path, AudioClipSource& source) {
+	const AppConfig& config = AppConfig::Instance();
 
-	if (std::strncmp(riffHeader.riff, "RIFF", 4) != 0 || std::strncmp(riffHeader.wave, "WAVE", 4) != 0) {
-		std::cout << "Invalid WAV file format: " << path << "\n";
-		return false;
-	}
+	// the waveform is drawn from a peak pyramid, made (or read from its .peaks) in the background
+	source.peaks = WaveformPeakCache::Instance().Request(path);
 
-	// 2. iterate chunks to find 'fmt ' and 'data'
-	ChunkHeader chunk;
-	bool foundFmt = false;
-	bool foundData = false;
-
-	uint16_t formatType = 0;
-	uint16_t bitsPerSample = 0;
-	uint16_t blockAlign = 0;
-
-	while (file.read((char*)&chunk, sizeof(ChunkHeader))) {
-		if (std::strncmp(chunk.id, "fmt ", 4) == 0) {
-			// read format chunk
-			struct WavFmt {
-				uint16_t wFormatTag;
-				uint16_t nChannels;
-				uint32_t nSamplesPerSec;
-				uint32_t nAvgBytesPerSec;
-				uint16_t nBlockAlign;
-				uint16_t wBitsPerSample;
-			} fmt;
-
-			if (chunk.size < 16) {
-				std::cout << "Error: fmt chunk too small\n";
-				return false;
-			}
+	// mapped: float files play from the page cache in place, integer pcm is converted per
+	// block as it's read, so no file costs its decoded size in ram whatever its length
+	if (config.mapAudioFiles) {
+		auto mapped = SamplePool::Instance().Map(path);
+		if (!mapped)
+			return false;
+		if (mapped->data)
+			source.data = std::move(mapped);
+		else
+			source.stream = SampleStream::OpenMapped(std::move(mapped));
+		return true;
+	}
 
-			file.read((char*)&fmt, 16);
+	// long files would cost their whole decoded size in ram and decode time on open; read the
+	// header only and let the disk thread feed them around the play position instead
+	std::error_code ec;
+	uintmax_t fileSize = std::filesystem::file_size(path, ec);
+	if (!ec && config.streamThresholdMB > 0 && fileSize >= (uintmax_t)config.streamThresholdMB * 1024 * 1024) {
+		WavInfo info;
+		if (!ReadWavInfo(path, info))
+			return false;
+		source.stream = SampleStream::Open(path, info);
+		return true;
+	}
 
-			formatType = fmt.wFormatTag;
-			mChannels = fmt.nChannels;
-			mSampleRate = (double)fmt.nSamplesPerSec;
-			bitsPerSample = fmt.wBitsPerSample;
-			blockAlign = fmt.nBlockAlign;
+	source.data = SamplePool::Instance().Load(path);
+	return source.data != nullptr;
+}
 
-			foundFmt = true;
+std::shared_ptr<const WaveformPeaks> AudioClip::GetPeaks() const {
+	return WaveformPeakCache::Instance().Get(mPeaks);
+}
 
-			if (chunk.size > 16) {
-				file.seekg(chunk.size - 16, std::ios::cur);
-			}
-		} else if (std::strncmp(chunk.id, "data", 4) == 0) {
-			foundData = true;
-			break; // stop at the start of data
-		} else {
-			file.seekg(chunk.size, std::ios::cur);
-		}
+void AudioClip::UpdateWarpTables(double sampleRate, double bpm) {
+	if (!UsesGranularEngine() || sampleRate <= 0.0 || bpm <= 0.0) {
+		mAlignment.reset();
+		mWindow.reset();
+		mVocoder.Set(nullptr);
+		return;
+	}
+	WarpRenderParams params = MakeWarpParams(*this, sampleRate, bpm);
+	if (!mWindow || !mWindow->Matches(params))
+		mWindow = std::make_shared<const WarpWindowTable>(params);
+
+	// decoded or streamed alike: the vocoder reads whatever span the block gathered
+	bool spectral = mWarpMode == WarpMode::Complex || mWarpMode == WarpMode::ComplexPro;
+	const std::shared_ptr<WarpVocoder>& vocoder = mVocoder.Get();
+	if (!spectral)
+		mVocoder.Set(nullptr);
+	else if (!vocoder || !vocoder->Matches(params) || vocoder->GetNumChannels() != std::clamp(mChannels, 1, 2))
+		mVocoder.Set(std::make_shared<WarpVocoder>(params, mChannels));
+
+	if (mWarpMode != WarpMode::Tones || !mData || !mData->data) {
+		mAlignment.reset();
+		return;
 	}
+	if (mAlignment && mAlignment->Matches(params))
+		return;
+	mAlignment = std::make_shared<WarpAlignmentTable>(params, mTotalFileFrames);
+	WarpAlignmentTable::FillInBackground(mAlignment, mData);
+}
 
-	if (!foundFmt) {
-		std::cout << "Error: No 'fmt ' chunk found in WAV.\n";
-		return false;
+void AudioClip::UpdateFreeze(double sampleRate, double bpm) {
+	bool hasSource = (mData && mData->data) || mStream.Get();
+	if (!AppConfig::Instance().freezeWarpedClips || !UsesGranularEngine() || !hasSource || sampleRate <= 0.0 || bpm <= 0.0) {
+		mFreeze.reset();
+		mFreezeStream = SampleStreamHandle();
+		return;
 	}
-	if (!foundData) {
-		std::cout << "Error: No 'data' chunk found in WAV.\n";
-		return false;
+	// as many output frames as Track::Process plays of the clip
+	WarpRenderParams params = MakeWarpParams(*this, sampleRate, bpm);
+	int64_t numFrames = (int64_t)(mDuration * (sampleRate * 60.0 / bpm)) + 1;
+	if (mFreeze && mFreeze->Matches(params) && mFreeze->GetNumFrames() >= numFrames) {
+		if (!mFreezeStream.Get() && mFreeze->IsSpilled())
+			mFreezeStream = SampleStreamHandle(mFreeze->OpenSpill());
+		return;
 	}
+	mFreeze.reset();
+	mFreezeStream = SampleStreamHandle();
+	if ((double)numFrames > WarpFreeze::kMaxSeconds * sampleRate)
+		return;
+	mFreeze = std::make_shared<WarpFreeze>(params, numFrames);
+	WarpFreeze::RenderInBackground(mFreeze, mData, mStream.Get(), mChannels, mAlignment, mWindow);
+}
 
-	uint32_t bytesPerSample = bitsPerSample / 8;
-	if (bytesPerSample == 0)
-		bytesPerSample = 1;
-
-	uint32_t numSamples = chunk.size / bytesPerSample;
-	mSamples.resize(numSamples);
-
-	if (formatType == 1 || formatType == 0xFFFE) { // pcm
-		if (bitsPerSample == 16) {
-			std::vector<int16_t> temp(numSamples);
-			file.read((char*)temp.data(), chunk.size);
-			for (size_t i = 0; i < numSamples; ++i) {
-				mSamples[i] = temp[i] / 32768.0f;
-			}
-		} else if (bitsPerSample == 24) {
-			uint32_t numFrames = numSamples;
-			size_t byteCount = numFrames * 3;
-			std::vector<uint8_t> raw(byteCount);
-			file.read((char*)raw.data(), byteCount);
-
-			for (size_t i = 0; i < numFrames; ++i) {
-				size_t idx = i * 3;
-				int32_t val = (raw[idx + 0]) | (raw[idx + 1] << 8) | (raw[idx + 2] << 16);
-				if (val & 0x800000)
-					val |= 0xFF000000;
-				mSamples[i] = val / 8388608.0f;
-			}
-		} else if (bitsPerSample == 8) {
-			std::vector<uint8_t> temp(numSamples);
-			file.read((char*)temp.data(), chunk.size);
-			for (size_t i = 0; i < numSamples; ++i) {
-				mSamples[i] = (temp[i] - 128) / 128.0f;
-			}
-		} else {
-			std::cout << "Unsupported PCM bit depth: " << bitsPerSample << "\n";
-			return false;
-		}
-	} else if (formatType == 3) { // ieee float
-		if (bitsPerSample == 32) {
-			file.read((char*)mSamples.data(), chunk.size);
-		} else {
-			std::cout << "Unsupported float bit depth: " << bitsPerSample << "\n";
-			return false;
-		}
-	} else {
-		std::cout << "Unsupported WAV format type: " << formatType << "\n";
-		return false;
-	}
+void AudioClip::SetSource(AudioClipSource source) {
+	mPeaks = std::move(source.peaks);
+	if (source.stream)
+		SetStream(std::move(source.stream));
+	else if (source.data)
+		SetData(std::move(source.data));
+}
 
-	if (mChannels > 0)
-		mTotalFileFrames = numSamples / mChannels;
-	else
-		mTotalFileFrames = 0;
+void AudioClip::SetData(std::shared_ptr<const SampleData> data) {
+	mData = std::move(data);
+	mStream = SampleStreamHandle();
+	mFreeze.reset();
+	mFreezeStream = SampleStreamHandle();
+	mChannels = mData ? mData->channels : 2;
+	mSampleRate = mData ? mData->sampleRate : 48000.0;
+	mTotalFileFrames = mData ? mData->numFrames : 0;
+}
 
-	return true;
+void AudioClip::SetStream(std::shared_ptr<SampleStream> stream) {
+	mData.reset();
+	mFreeze.reset();
+	mFreezeStream = SampleStreamHandle();
+	mChannels = stream->GetChannels();
+	mSampleRate = stream->GetSampleRate();
+	mTotalFileFrames = stream->GetNumFrames();
+	mStream = SampleStreamHandle(std::move(stream));
 }
 
 void AudioClip::GenerateTestSignal(double sampleRate, double durationSecs) {
 
-	mSampleRate = sampleRate;
-	mChannels = 2;
+	auto data = std::make_shared<SampleData>();
+	data->sampleRate = sampleRate;
+	data->channels = 2;
 	size_t numFrames = (size_t)(durationSecs * sampleRate);
-	mSamples.resize(numFrames * mChannels);
+	data->samples.resize(numFrames * data->channels);
+	data->numFrames = numFrames;
+	data->data = data->samples.data();
+	data->numSamples = data->samples.size();
 
 	for (size_t i = 0; i < numFrames; ++i) {
 		double t = (double)i / sampleRate;
 		double freq = 220.0 + (660.0 * t / durationSecs);
 		float val = (float)(0.5 * std::sin(2.0 * 3.14159 * freq * t));
 
-		mSamples[i * 2 + 0] = val;
-		mSamples[i * 2 + 1] = val;
+		data->samples[i * 2 + 0] = val;
+		data->samples[i * 2 + 1] = val;
 	}
 
+	SetData(std::move(data));
 	mDuration = durationSecs * 2.0; // approx beats assumption
-	mTotalFileFrames = numFrames;
 }
 
 double AudioClip::GetMaxDurationInBeats(double projectBpm) const {
@@ -338,10 +332,9 @@ void AudioClip::Load(std::istream& in) {
 			size_t q1 = line.find('"');
 			size_t q2 = line.find('"', q1 + 1);
 			if (q1 != std::string::npos && q2 != std::string::npos) {
+				// the file itself is opened by whoever loads the track (Track::Load), which
+				// may hand it to a worker
 				mFilePath = line.substr(q1 + 1, q2 - q1 - 1);
-				if (!mFilePath.empty()) {
-					LoadFromFile(mFilePath);
-				}
 			}
 		} else if (line.rfind("WARP_MODE ", 0) == 0) {
 			int mode = std::stoi(line.substr(10));
@@ -367,3 +360,39 @@ void AudioClip::Load(std::istream& in) {
 		}
 	}
 }
+
+void AudioClip::Save(ChunkWriter& out) {
+	Clip::Save(out);
+	out.Begin(ProjectChunk::AudioClip);
+	out.WriteString(mFilePath);
+	out.Write<uint8_t>(mWarpingEnabled ? 1 : 0);
+	out.Write<int32_t>((int32_t)mWarpMode);
+	out.Write<double>(mSegmentBpm);
+	out.Write<double>(mTransposeSemitones);
+	out.Write<double>(mTransposeCents);
+	out.Write<double>(mGrainSizeMs);
+	out.Write<double>(mFluctuation);
+	out.Write<double>(mTransientEnvelope);
+	out.Write<double>(mFormants);
+	out.End();
+}
+
+void AudioClip::Load(const ChunkReader& in) {
+	Clip::Load(in);
+	ChunkReader audio;
+	if (!in.Find(ProjectChunk::AudioClip, audio))
+		return;
+	// as with the text format, the file itself is opened by Track::Load
+	mFilePath = audio.ReadString();
+	mWarpingEnabled = audio.Read<uint8_t>(mWarpingEnabled ? 1 : 0) != 0;
+	int32_t mode = audio.Read<int32_t>((int32_t)mWarpMode);
+	if (mode >= 0 && mode <= 5)
+		mWarpMode = (WarpMode)mode;
+	mSegmentBpm = audio.Read<double>(mSegmentBpm);
+	mTransposeSemitones = audio.Read<double>(mTransposeSemitones);
+	mTransposeCents = audio.Read<double>(mTransposeCents);
+	mGrainSizeMs = audio.Read<double>(mGrainSizeMs);
+	mFluctuation = audio.Read<double>(mFluctuation);
+	mTransientEnvelope = audio.Read<double>(mTransientEnvelope);
+	mFormants = audio.Read<double>(mFormants);
+}
@@ -1,8 +1,16 @@
 #pragma once
 #include "Clip.h"
+#include "SamplePool.h"
+#include "SampleStream.h"
+#include "WaveformPeaks.h"
 #include <vector>
 #include <string>
 
+class WarpAlignmentTable;
+class WarpWindowTable;
+class WarpVocoder;
+class WarpFreeze;
+
 enum class WarpMode {
 	Beats = 0,
 	Tones,
@@ -29,23 +37,73 @@ struct AudioClipWarpState {
 	double offset = 0.0;
 };
 
+// what a clip plays from once its file is open: decoded (or mapped float) data, or a stream
+struct AudioClipSource {
+	std::shared_ptr<const SampleData> data;
+	std::shared_ptr<SampleStream> stream;
+	std::shared_ptr<WaveformPeakEntry> peaks; // the file version opened, which the waveform is drawn from
+};
+
+// how a clip holds its vocoder. a vocoder carries one clip's playback state, so like a stream
+// it isn't shared: a copied clip (split, duplicate, paste) starts without one and is given its
+// own by the next UpdateWarpTables
+class WarpVocoderHandle {
+public:
+	WarpVocoderHandle() = default;
+	WarpVocoderHandle(const WarpVocoderHandle&) {}
+	WarpVocoderHandle& operator=(const WarpVocoderHandle& other) {
+		if (this != &other)
+			mVocoder.reset();
+		return *this;
+	}
+	WarpVocoderHandle(WarpVocoderHandle&&) = default;
+	WarpVocoderHandle& operator=(WarpVocoderHandle&&) = default;
+
+	const std::shared_ptr<WarpVocoder>& Get() const { return mVocoder; }
+	void Set(std::shared_ptr<WarpVocoder> vocoder) { mVocoder = std::move(vocoder); }
+private:
+	std::shared_ptr<WarpVocoder> mVocoder;
+};
+
 class AudioClip : public Clip {
 public:
+	static constexpr ClipKind kKind = ClipKind::Audio;
+
 	AudioClip();
 	~AudioClip() override = default;
 
-	// simple wav loader (supports 16-bit pcm and 32-bit float)
+	// simple wav loader (supports 16-bit pcm and 32-bit float). files past the streaming
+	// threshold in AppConfig only have their header read and play from disk, and with
+	// mapping enabled every file is mapped instead of decoded
 	bool LoadFromFile(const std::string& path);
 
+	// LoadFromFile in two halves, for the project loader: OpenSource does the file work and
+	// touches no clip, so it can run on a worker thread; SetSource installs the result
+	static bool OpenSource(const std::string& path, AudioClipSource& source);
+	void SetSource(AudioClipSource source);
+	const std::string& GetFilePath() const { return mFilePath; }
+
 	// generate a test tone for demonstration
 	void GenerateTestSignal(double sampleRate, double durationSecs);
 
-	// access raw interleaved samples
-	const std::vector<float>& GetSamples() const { return mSamples; }
+	// decoded audio, shared with every clip split or duplicated from this one and with any
+	// clip that loaded the same file (see SamplePool). null for a streamed clip
+	const std::shared_ptr<const SampleData>& GetData() const { return mData; }
+
+	// the disk stream of a file too long to decode (or of mapped integer pcm), else null.
+	// exactly one of this and GetData() is set after a successful load
+	const std::shared_ptr<SampleStream>& GetStream() const { return mStream.Get(); }
+
+	// access raw interleaved samples (null for a streamed clip)
+	const float* GetSamples() const { return mData ? mData->data : nullptr; }
+	size_t GetNumSamples() const { return mData ? mData->numSamples : 0; }
 	int GetNumChannels() const { return mChannels; }
 	double GetSampleRate() const { return mSampleRate; }
 	uint64_t GetTotalFileFrames() const { return mTotalFileFrames; }
 
+	// the file's waveform pyramid, or null until the peak cache has it (and for a generated clip)
+	std::shared_ptr<const WaveformPeaks> GetPeaks() const;
+
 	// warping and pitch properties
 	void SetWarpingEnabled(bool enabled) { mWarpingEnabled = enabled; }
 	bool IsWarpingEnabled() const { return mWarpingEnabled; }
@@ -99,18 +157,55 @@ public:
 	// rate inside a grain shifts pitch without touching the clip's length on the grid
 	double ComputePitchReadRate(double deviceSampleRate) const;
 
+	// Tones' memoized grain alignment (see WarpAlignmentTable), null when the clip isn't warped
+	// in Tones or doesn't play from decoded data
+	const std::shared_ptr<WarpAlignmentTable>& GetAlignmentTable() const { return mAlignment; }
+
+	// the granular modes' precomputed grain window (see WarpWindowTable), null when not warped
+	const std::shared_ptr<const WarpWindowTable>& GetWindowTable() const { return mWindow; }
+
+	// the phase vocoder Complex/ComplexPro play through (see WarpVocoder), null in other modes
+	const std::shared_ptr<WarpVocoder>& GetVocoder() const { return mVocoder.Get(); }
+
+	// ui thread: replaces any of the three when the clip's params at this rate and tempo no
+	// longer match it, starting a background pass to fill a new alignment table
+	void UpdateWarpTables(double sampleRate, double bpm);
+
+	// the clip's output rendered ahead of time (see WarpFreeze), null when not warped or frozen
+	const std::shared_ptr<WarpFreeze>& GetFreeze() const { return mFreeze; }
+	// this clip's stream of the freeze's scratch file, when it was spilled (see WarpFreeze)
+	const std::shared_ptr<SampleStream>& GetFreezeStream() const { return mFreezeStream.Get(); }
+
+	// ui thread, after UpdateWarpTables: replaces the freeze when the params at this rate and
+	// tempo, or the clip's length, moved past it, queueing the new one's render. opens the
+	// freeze stream once a spilled freeze is ready
+	void UpdateFreeze(double sampleRate, double bpm);
+
 	// warp/pitch state snapshot for undo and for grabbing a drag's "before"
 	AudioClipWarpState CaptureWarpState() const;
 	void ApplyWarpState(const AudioClipWarpState& state);
 
 	void Save(std::ostream& out) override;
 	void Load(std::istream& in) override;
+	void Save(ChunkWriter& out) override;
+	void Load(const ChunkReader& in) override;
 private:
-	std::vector<float> mSamples; // interleaved data
+	// both also refresh the scalars below
+	void SetData(std::shared_ptr<const SampleData> data);
+	void SetStream(std::shared_ptr<SampleStream> stream);
+
+	std::shared_ptr<const SampleData> mData;
+	SampleStreamHandle mStream;
 	int mChannels = 2;
 	double mSampleRate = 48000.0;
 	uint64_t mTotalFileFrames = 0;
 	std::string mFilePath;
+	std::shared_ptr<WaveformPeakEntry> mPeaks;
+	std::shared_ptr<WarpAlignmentTable> mAlignment;
+	std::shared_ptr<const WarpWindowTable> mWindow;
+	WarpVocoderHandle mVocoder;
+	std::shared_ptr<WarpFreeze> mFreeze;
+	SampleStreamHandle mFreezeStream;
 
 	// warping state
 	bool mWarpingEnabled = false;
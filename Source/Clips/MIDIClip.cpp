@@ -3,14 +3,46 @@
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <map>
 
-MIDIClip::MIDIClip() {
+MIDIClip::MIDIClip() : Clip(kKind) {
 	mName = "MIDI Clip";
 	// allocate a fresh sequence
 	mSequence = std::make_shared<MIDISequence>();
 }
 
+std::shared_ptr<const MIDINoteSchedule> MIDINoteSchedule::Compile(const std::vector<MIDINote>& notes, uint64_t revision) {
+	auto schedule = std::make_shared<MIDINoteSchedule>();
+	schedule->notes = notes;
+	schedule->revision = revision;
+
+	auto sortedView = [&notes](std::vector<int>& order, std::vector<double>& beats, auto beatOf) {
+		order.resize(notes.size());
+		for (size_t i = 0; i < notes.size(); ++i)
+			order[i] = (int)i;
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return beatOf(notes[a]) < beatOf(notes[b]); });
+		beats.resize(order.size());
+		for (size_t k = 0; k < order.size(); ++k)
+			beats[k] = beatOf(notes[order[k]]);
+	};
+	sortedView(schedule->byStart, schedule->startBeats, [](const MIDINote& n) { return n.startBeat; });
+	sortedView(schedule->byEnd, schedule->endBeats, [](const MIDINote& n) { return n.startBeat + n.durationBeats; });
+	return schedule;
+}
+
+void MIDIClip::NotesChanged() {
+	// one counter for every sequence, so a schedule never matches another sequence's revision
+	static std::atomic<uint64_t> sNextRevision{0};
+	mSequence->revision = ++sNextRevision;
+}
+
+std::shared_ptr<const MIDINoteSchedule> MIDIClip::GetSchedule() const {
+	if (!mSchedule || mSchedule->revision != mSequence->revision)
+		mSchedule = MIDINoteSchedule::Compile(GetNotes(), mSequence->revision);
+	return mSchedule;
+}
+
 // helpers for big-endian parsing
 static uint16_t ReadBE16(std::ifstream& f) {
 	uint8_t b[2];
@@ -74,6 +106,7 @@ bool MIDIClip::LoadFromFile(const std::string& path) {
 	}
 
 	mSequence->notes.clear();
+	NotesChanged();
 	double maxBeat = 0.0;
 
 	// 2. read tracks (mtrk)
@@ -206,6 +239,7 @@ void MIDIClip::Load(std::istream& in) {
 	if (!mSequence)
 		mSequence = std::make_shared<MIDISequence>();
 	mSequence->notes.clear();
+	NotesChanged();
 
 	std::string line;
 	while (std::getline(in, line)) {
@@ -236,3 +270,39 @@ void MIDIClip::Load(std::istream& in) {
 		}
 	}
 }
+
+void MIDIClip::Save(ChunkWriter& out) {
+	Clip::Save(out);
+	// one block of fixed-size records: a big clip loads with no per-note parsing at all
+	out.Begin(ProjectChunk::Notes);
+	out.Write<uint32_t>((uint32_t)mSequence->notes.size());
+	for (const auto& n : mSequence->notes) {
+		out.Write<int32_t>(n.noteNumber);
+		out.Write<int32_t>(n.velocity);
+		out.Write<double>(n.startBeat);
+		out.Write<double>(n.durationBeats);
+	}
+	out.End();
+}
+
+void MIDIClip::Load(const ChunkReader& in) {
+	Clip::Load(in);
+	if (!mSequence)
+		mSequence = std::make_shared<MIDISequence>();
+	mSequence->notes.clear();
+	NotesChanged();
+
+	ChunkReader notes;
+	if (!in.Find(ProjectChunk::Notes, notes))
+		return;
+	constexpr size_t kNoteBytes = 2 * sizeof(int32_t) + 2 * sizeof(double);
+	uint32_t count = notes.Read<uint32_t>();
+	count = (uint32_t)std::min<size_t>(count, notes.GetRemaining() / kNoteBytes);
+	mSequence->notes.resize(count);
+	for (auto& n : mSequence->notes) {
+		n.noteNumber = notes.Read<int32_t>();
+		n.velocity = notes.Read<int32_t>();
+		n.startBeat = notes.Read<double>();
+		n.durationBeats = notes.Read<double>();
+	}
+}
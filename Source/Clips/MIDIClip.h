@@ -14,13 +14,30 @@ struct MIDINote {
 	bool operator==(const MIDINote&) const = default;
 };
 
+// a clip's notes compiled for playback: two sorted views, so a block finds its note-ons and
+// note-offs by binary search instead of walking the whole clip. in note beats (before the
+// clip's offset), so moving, trimming or retiming the clip leaves it valid
+struct MIDINoteSchedule {
+	std::vector<MIDINote> notes;
+	uint64_t revision = 0; // the MIDISequence revision it was compiled from
+	std::vector<int> byStart; // note indices, by startBeat
+	std::vector<double> startBeats;
+	std::vector<int> byEnd; // note indices, by startBeat + durationBeats
+	std::vector<double> endBeats;
+
+	static std::shared_ptr<const MIDINoteSchedule> Compile(const std::vector<MIDINote>& notes, uint64_t revision);
+};
+
 // sequence container
 struct MIDISequence {
 	std::vector<MIDINote> notes;
+	uint64_t revision = 0; // moves with every edit, unique across sequences (MIDIClip::NotesChanged)
 };
 
 class MIDIClip : public Clip {
 public:
+	static constexpr ClipKind kKind = ClipKind::MIDI;
+
 	MIDIClip();
 	~MIDIClip() override = default;
 
@@ -28,12 +45,17 @@ public:
 
 	// notes accessors
 	void AddNote(const MIDINote& note) {
-		if (mSequence)
+		if (mSequence) {
 			mSequence->notes.push_back(note);
+			NotesChanged();
+		}
 	}
 
 	const std::vector<MIDINote>& GetNotes() const { return mSequence->notes; }
+	// edits in place: call NotesChanged once done (project mutex held), or playback keeps the
+	// notes as they were
 	std::vector<MIDINote>& GetNotesEx() { return mSequence->notes; }
+	void NotesChanged();
 
 	// check if clips share data
 	bool IsLinkedTo(const MIDIClip& other) const {
@@ -43,9 +65,16 @@ public:
 	// break links and create unique notes
 	void MakeUnique();
 
+	// the notes compiled for playback (UI thread). recompiled only when NotesChanged was called
+	// since the last call, so an unchanged clip costs a compare, however many notes it has
+	std::shared_ptr<const MIDINoteSchedule> GetSchedule() const;
+
 	void Save(std::ostream& out) override;
 	void Load(std::istream& in) override;
+	void Save(ChunkWriter& out) override;
+	void Load(const ChunkReader& in) override;
 private:
 	// replaced mnotes with a shared pointer
 	std::shared_ptr<MIDISequence> mSequence;
+	mutable std::shared_ptr<const MIDINoteSchedule> mSchedule;
 };
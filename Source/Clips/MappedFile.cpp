@@ -0,0 +1,63 @@
+#include "PrecompHeader.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string& path) {
+	std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+								FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+	file->mFile = handle;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+		return nullptr;
+	file->mSize = (uint64_t)size.QuadPart;
+
+	file->mMapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!file->mMapping)
+		return nullptr;
+	file->mData = (const uint8_t*)MapViewOfFile(file->mMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return nullptr;
+	}
+	file->mSize = (uint64_t)st.st_size;
+	void* data = mmap(nullptr, (size_t)file->mSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // the mapping keeps the file referenced
+	if (data != MAP_FAILED)
+		file->mData = (const uint8_t*)data;
+#endif
+	if (!file->mData)
+		return nullptr;
+	return file;
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile)
+		CloseHandle(mFile);
+#else
+	if (mData)
+		munmap((void*)mData, (size_t)mSize);
+#endif
+}
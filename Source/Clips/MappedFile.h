@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// a whole file mapped read-only. the pages are the os page cache itself: nothing is copied,
+// every clip and process mapping the same file shares them, and only what gets touched is
+// ever read from disk. a first touch can fault to disk, on whatever thread makes it
+class MappedFile {
+public:
+	// nullptr if the file can't be opened or mapped
+	static std::shared_ptr<const MappedFile> Open(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* GetData() const { return mData; }
+	uint64_t GetSize() const { return mSize; }
+private:
+	MappedFile() = default;
+
+	const uint8_t* mData = nullptr;
+	uint64_t mSize = 0;
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#endif
+};
@@ -0,0 +1,269 @@
+#include "PrecompHeader.h"
+#include "Resampler.h"
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RESAMPLE_SSE2 1
+#endif
+
+namespace {
+	// fractional positions each filter is tabulated at; a read between two blends them
+	constexpr int kPhases = 256;
+
+	// filters for reads up to 2^(b/4) times the source rate, b = 0..8. a faster read than the
+	// last band takes its filter, which then lets some aliasing through
+	constexpr int kBands = 9;
+
+	// each filter passes this fraction of the slower rate's nyquist, leaving the rest for the
+	// window's transition band
+	constexpr double kPassband = 0.92;
+	constexpr double kKaiserBeta = 7.5;
+
+	double BesselI0(double x) {
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; ++k) {
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// the sinc filters, one per band, built once at startup. a band's filter has taps frames,
+	// centered between the tap offsets taps/2 - 1 and taps/2 from the read's first one
+	struct SincBank {
+		struct Band {
+			double maxStep = 1.0;
+			int taps = 0;			   // a multiple of 8
+			std::vector<float> coeffs; // (kPhases + 1) rows of taps
+		};
+		Band bands[kBands];
+
+		SincBank() {
+			const double pi = 3.14159265358979323846;
+			for (int b = 0; b < kBands; ++b) {
+				Band& band = bands[b];
+				band.maxStep = std::pow(2.0, b / 4.0);
+				band.taps = 8 * (int)std::ceil(2.0 * band.maxStep - 1e-9);
+				double cutoff = kPassband / band.maxStep; // of the source's nyquist
+				int half = band.taps / 2;
+				band.coeffs.resize((size_t)(kPhases + 1) * band.taps);
+				for (int p = 0; p <= kPhases; ++p) {
+					double frac = (double)p / kPhases;
+					float* row = &band.coeffs[(size_t)p * band.taps];
+					double sum = 0.0;
+					std::vector<double> h((size_t)band.taps);
+					for (int k = 0; k < band.taps; ++k) {
+						double x = (double)(k - (half - 1)) - frac; // tap's distance from the read
+						double arg = pi * cutoff * x;
+						double sinc = std::abs(arg) < 1e-12 ? 1.0 : std::sin(arg) / arg;
+						double r = x / (double)half;
+						double window = std::abs(r) >= 1.0 ? 0.0 : BesselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) / BesselI0(kKaiserBeta);
+						h[(size_t)k] = sinc * window;
+						sum += h[(size_t)k];
+					}
+					// unity gain at dc for every phase, or the blend would ripple with position
+					for (int k = 0; k < band.taps; ++k)
+						row[k] = (float)(h[(size_t)k] / sum);
+				}
+			}
+		}
+
+		const Band& ForStep(double step) const {
+			step = std::abs(step);
+			for (const Band& band : bands) {
+				if (step <= band.maxStep * (1.0 + 1e-9))
+					return band;
+			}
+			return bands[kBands - 1];
+		}
+	};
+
+	const SincBank sBank;
+
+	// taps frames of one channel at stride `channels` times the blended filter. the sums run in
+	// the vector kernel's order (even and odd taps apart, mono four ways), so a read near the
+	// span's edges, which comes this way, rounds like the same read away from them
+	float SincDotScalar(const float* samples, int64_t numFrames, int channels, int channel, int64_t first,
+						const float* row0, const float* row1, float blend, int taps) {
+		float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		for (int k = 0; k < taps; ++k) {
+			int64_t frame = first + k;
+			float s = frame >= 0 && frame < numFrames ? samples[frame * channels + channel] : 0.0f;
+			float c = row0[k] + blend * (row1[k] - row0[k]);
+			lanes[channels == 1 ? (k & 3) : (k & 1) * 2] += c * s;
+		}
+		if (channels == 1)
+			return (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+		return lanes[0] + lanes[2];
+	}
+
+#ifdef RESAMPLE_SSE2
+	// mono: four taps a step
+	float SincDotMono(const float* s, const float* row0, const float* row1, float blend, int taps) {
+		__m128 vBlend = _mm_set1_ps(blend);
+		__m128 acc = _mm_setzero_ps();
+		for (int k = 0; k < taps; k += 4) {
+			__m128 r0 = _mm_loadu_ps(row0 + k);
+			__m128 c = _mm_add_ps(r0, _mm_mul_ps(vBlend, _mm_sub_ps(_mm_loadu_ps(row1 + k), r0)));
+			acc = _mm_add_ps(acc, _mm_mul_ps(c, _mm_loadu_ps(s + k)));
+		}
+		__m128 pairs = _mm_add_ps(acc, _mm_movehl_ps(acc, acc)); // lanes 0+2, 1+3
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+	}
+
+	// interleaved stereo: four taps a step, each coefficient paired up to meet a frame's two samples
+	void SincDotStereo(const float* s, const float* row0, const float* row1, float blend, int taps, float& left, float& right) {
+		__m128 vBlend = _mm_set1_ps(blend);
+		__m128 acc = _mm_setzero_ps(); // l r of the even taps, l r of the odd ones
+		for (int k = 0; k < taps; k += 4) {
+			__m128 r0 = _mm_loadu_ps(row0 + k);
+			__m128 c = _mm_add_ps(r0, _mm_mul_ps(vBlend, _mm_sub_ps(_mm_loadu_ps(row1 + k), r0)));
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_unpacklo_ps(c, c), _mm_loadu_ps(s + 2 * k)));
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_unpackhi_ps(c, c), _mm_loadu_ps(s + 2 * k + 4)));
+		}
+		__m128 sum = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+		left = _mm_cvtss_f32(sum);
+		right = _mm_cvtss_f32(_mm_shuffle_ps(sum, sum, 1));
+	}
+#endif
+
+	// catmull-rom through the four frames around the read
+	inline float Cubic(float a, float b, float c, float d, float t) {
+		return b + 0.5f * t * ((c - a) + t * ((2.0f * a - 5.0f * b + 4.0f * c - d) + t * (3.0f * (b - c) + d - a)));
+	}
+} // namespace
+
+const char* GetResampleQualityName(ResampleQuality quality) {
+	switch (quality) {
+	case ResampleQuality::Linear:
+		return "Linear";
+	case ResampleQuality::Cubic:
+		return "Cubic";
+	case ResampleQuality::Sinc:
+		return "Sinc";
+	}
+	return "";
+}
+
+void GetResampleReach(ResampleQuality quality, double step, int& before, int& after) {
+	switch (quality) {
+	case ResampleQuality::Linear:
+		before = 0;
+		after = 1;
+		return;
+	case ResampleQuality::Cubic:
+		before = 1;
+		after = 2;
+		return;
+	case ResampleQuality::Sinc: {
+		int taps = sBank.ForStep(step).taps;
+		before = taps / 2 - 1;
+		after = taps / 2;
+		return;
+	}
+	}
+	before = 0;
+	after = 1;
+}
+
+void ResampleBlock(const float* samples, size_t numSamples, int clipChannels, int64_t firstFrame,
+				   double startPos, double step, int count, int destChannels, float* dest, ResampleQuality quality) {
+	if (!samples || clipChannels <= 0 || destChannels <= 0)
+		return;
+	const int64_t numFrames = (int64_t)(numSamples / (size_t)clipChannels);
+
+	if (quality == ResampleQuality::Linear) {
+		for (int i = 0; i < count; ++i) {
+			double framePos = startPos + ((double)i * step);
+			int64_t frameIndex = (int64_t)framePos;
+
+			// bounds check
+			if (frameIndex < firstFrame)
+				continue;
+			size_t idx = (size_t)(frameIndex - firstFrame) * clipChannels;
+			if (idx + clipChannels >= numSamples)
+				break; // end of file
+
+			double alpha = framePos - frameIndex;
+
+			for (int c = 0; c < destChannels; ++c) {
+				int srcC = c % clipChannels;
+				size_t idx1 = idx + srcC;
+				size_t idx2 = idx1 + clipChannels;
+
+				float val = samples[idx1] + (float)alpha * (samples[idx2] - samples[idx1]);
+				dest[i * destChannels + c] += val;
+			}
+		}
+		return;
+	}
+
+	if (quality == ResampleQuality::Cubic) {
+		for (int i = 0; i < count; ++i) {
+			double framePos = startPos + ((double)i * step);
+			int64_t frameIndex = (int64_t)std::floor(framePos); // the curve takes a fraction in [0, 1)
+			if (frameIndex < firstFrame)
+				continue;
+			int64_t local = frameIndex - firstFrame;
+			if (local + 1 >= numFrames)
+				break; // end of file
+			float t = (float)(framePos - frameIndex);
+
+			float* out = dest + i * destChannels;
+			if (local >= 1 && local + 2 < numFrames) {
+				const float* s = samples + (local - 1) * clipChannels;
+				for (int c = 0; c < destChannels; ++c) {
+					int srcC = c % clipChannels;
+					out[c] += Cubic(s[srcC], s[clipChannels + srcC], s[2 * clipChannels + srcC], s[3 * clipChannels + srcC], t);
+				}
+				continue;
+			}
+			auto at = [&](int64_t frame, int channel) {
+				return frame >= 0 && frame < numFrames ? samples[frame * clipChannels + channel] : 0.0f;
+			};
+			for (int c = 0; c < destChannels; ++c) {
+				int srcC = c % clipChannels;
+				out[c] += Cubic(at(local - 1, srcC), at(local, srcC), at(local + 1, srcC), at(local + 2, srcC), t);
+			}
+		}
+		return;
+	}
+
+	const SincBank::Band& band = sBank.ForStep(step);
+	const int half = band.taps / 2;
+	for (int i = 0; i < count; ++i) {
+		double framePos = startPos + ((double)i * step);
+		int64_t frameIndex = (int64_t)std::floor(framePos); // the filters take a fraction in [0, 1)
+		if (frameIndex < firstFrame)
+			continue;
+		int64_t local = frameIndex - firstFrame;
+		if (local + 1 >= numFrames)
+			break; // end of file
+
+		double phase = (framePos - frameIndex) * kPhases;
+		int row = (int)phase;
+		float blend = (float)(phase - (double)row);
+		const float* row0 = &band.coeffs[(size_t)row * band.taps];
+		const float* row1 = row0 + band.taps;
+		int64_t first = local - (half - 1);
+
+		float* out = dest + i * destChannels;
+#ifdef RESAMPLE_SSE2
+		// a mono or stereo read away from the edges takes the vector kernel, its channels at once
+		if (first >= 0 && first + band.taps <= numFrames && clipChannels <= 2) {
+			float value[2] = {0.0f, 0.0f};
+			if (clipChannels == 2)
+				SincDotStereo(samples + first * 2, row0, row1, blend, band.taps, value[0], value[1]);
+			else
+				value[0] = SincDotMono(samples + first, row0, row1, blend, band.taps);
+			for (int c = 0; c < destChannels; ++c)
+				out[c] += value[c % clipChannels];
+			continue;
+		}
+#endif
+		for (int c = 0; c < destChannels; ++c)
+			out[c] += SincDotScalar(samples, numFrames, clipChannels, c % clipChannels, first, row0, row1, blend, band.taps);
+	}
+}
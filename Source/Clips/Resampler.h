@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// how unwarped and Re-Pitch clips read their source between its frames
+enum class ResampleQuality {
+	Linear = 0, // 2 points: cheapest, aliases and dulls the highs
+	Cubic,		// 4-point catmull-rom: smoother, still not band-limited
+	Sinc		// polyphase windowed sinc, band-limited to the slower of the two rates
+};
+
+const char* GetResampleQualityName(ResampleQuality quality);
+
+// source frames a read at frame position p touches, either side of floor(p), when stepping
+// `step` source frames per output frame. the sinc's filter widens as it band-limits a faster read
+void GetResampleReach(ResampleQuality quality, double step, int& before, int& after);
+
+// mixes `count` output frames into `dest` (interleaved, destChannels wide, `+=`), output frame i
+// reading source position startPos + i * step. `samples` holds source frames from `firstFrame` on,
+// clipChannels wide. a position before the span is skipped and the block stops once a position
+// reaches the span's last frame, as the linear reader always has; within that, a tap off the span
+// reads silence. the sinc filter for a step is precomputed, so nothing here allocates
+void ResampleBlock(const float* samples, size_t numSamples, int clipChannels, int64_t firstFrame,
+				   double startPos, double step, int count, int destChannels, float* dest, ResampleQuality quality);
@@ -0,0 +1,305 @@
+#include "PrecompHeader.h"
+#include "SamplePool.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+struct ChunkHeader {
+	char id[4];
+	uint32_t size;
+};
+
+// riff header
+struct RiffHeader {
+	char riff[4];		  // "RIFF", or "RF64" for a file past 4 GB
+	uint32_t overallSize; // 0xFFFFFFFF in rf64, where ds64 has it
+	char wave[4];		  // "WAVE"
+};
+
+bool ReadWavInfo(const std::string& path, WavInfo& info) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Failed to open audio file: " << path << "\n";
+		return false;
+	}
+	return ReadWavInfo(file, path, info);
+}
+
+bool ReadWavInfo(std::istream& file, const std::string& path, WavInfo& info) {
+	// 1. read riff header
+	RiffHeader riffHeader;
+	file.read((char*)&riffHeader, sizeof(RiffHeader));
+
+	bool rf64 = file && std::strncmp(riffHeader.riff, "RF64", 4) == 0;
+	if (!file || (!rf64 && std::strncmp(riffHeader.riff, "RIFF", 4) != 0) || std::strncmp(riffHeader.wave, "WAVE", 4) != 0) {
+		std::cout << "Invalid WAV file format: " << path << "\n";
+		return false;
+	}
+
+	// 2. iterate chunks to find 'fmt ' and 'data'
+	ChunkHeader chunk;
+	bool foundFmt = false;
+	bool foundData = false;
+	uint64_t ds64DataBytes = 0; // rf64's real data size, which the data chunk's own pins at -1
+
+	while (file.read((char*)&chunk, sizeof(ChunkHeader))) {
+		if (rf64 && std::strncmp(chunk.id, "ds64", 4) == 0) {
+			uint64_t sizes[2] = {}; // riff, data
+			if (chunk.size < 28 || !file.read((char*)sizes, sizeof(sizes))) {
+				std::cout << "Error: ds64 chunk too small\n";
+				return false;
+			}
+			ds64DataBytes = sizes[1];
+			file.seekg(chunk.size - sizeof(sizes), std::ios::cur);
+		} else if (std::strncmp(chunk.id, "fmt ", 4) == 0) {
+			// read format chunk
+			struct WavFmt {
+				uint16_t wFormatTag;
+				uint16_t nChannels;
+				uint32_t nSamplesPerSec;
+				uint32_t nAvgBytesPerSec;
+				uint16_t nBlockAlign;
+				uint16_t wBitsPerSample;
+			} fmt;
+
+			if (chunk.size < 16) {
+				std::cout << "Error: fmt chunk too small\n";
+				return false;
+			}
+
+			file.read((char*)&fmt, 16);
+
+			info.formatType = fmt.wFormatTag;
+			info.channels = fmt.nChannels;
+			info.sampleRate = (double)fmt.nSamplesPerSec;
+			info.bitsPerSample = fmt.wBitsPerSample;
+			uint32_t fmtRead = 16;
+
+			// WAVE_FORMAT_EXTENSIBLE: the real format is the first two bytes of the subformat guid
+			if (info.formatType == 0xFFFE && chunk.size >= 40) {
+				struct WavFmtExtension {
+					uint16_t cbSize;
+					uint16_t wValidBitsPerSample;
+					uint32_t dwChannelMask;
+					uint8_t subFormat[16];
+				} ext;
+				file.read((char*)&ext, sizeof(ext));
+				info.formatType = (uint16_t)(ext.subFormat[0] | (ext.subFormat[1] << 8));
+				fmtRead += sizeof(ext);
+			} else if (info.formatType == 0xFFFE) {
+				info.formatType = 1; // too short to say: taken as pcm
+			}
+
+			foundFmt = true;
+
+			if (chunk.size > fmtRead) {
+				file.seekg(chunk.size - fmtRead, std::ios::cur);
+			}
+		} else if (std::strncmp(chunk.id, "data", 4) == 0) {
+			foundData = true;
+			break; // stop at the start of data
+		} else {
+			file.seekg(chunk.size, std::ios::cur);
+		}
+	}
+
+	if (!foundFmt) {
+		std::cout << "Error: No 'fmt ' chunk found in WAV.\n";
+		return false;
+	}
+	if (!foundData) {
+		std::cout << "Error: No 'data' chunk found in WAV.\n";
+		return false;
+	}
+
+	if (info.formatType == 1) { // pcm
+		if (info.bitsPerSample != 8 && info.bitsPerSample != 16 && info.bitsPerSample != 24 && info.bitsPerSample != 32) {
+			std::cout << "Unsupported PCM bit depth: " << info.bitsPerSample << "\n";
+			return false;
+		}
+	} else if (info.formatType == 3) { // ieee float
+		if (info.bitsPerSample != 32 && info.bitsPerSample != 64) {
+			std::cout << "Unsupported float bit depth: " << info.bitsPerSample << "\n";
+			return false;
+		}
+	} else {
+		std::cout << "Unsupported WAV format type: " << info.formatType << "\n";
+		return false;
+	}
+
+	info.dataOffset = (uint64_t)file.tellg();
+	info.dataBytes = rf64 && chunk.size == 0xFFFFFFFFu ? ds64DataBytes : chunk.size;
+	int bytesPerFrame = info.BytesPerFrame();
+	info.numFrames = bytesPerFrame > 0 ? info.dataBytes / bytesPerFrame : 0;
+	return true;
+}
+
+void ConvertWavSamples(const WavInfo& info, const uint8_t* raw, size_t numSamples, float* out) {
+	switch (info.bitsPerSample) {
+	case 8:
+		for (size_t i = 0; i < numSamples; ++i)
+			out[i] = (raw[i] - 128) / 128.0f;
+		break;
+	case 16:
+		for (size_t i = 0; i < numSamples; ++i) {
+			int16_t val;
+			std::memcpy(&val, raw + i * 2, 2);
+			out[i] = val / 32768.0f;
+		}
+		break;
+	case 24:
+		for (size_t i = 0; i < numSamples; ++i) {
+			size_t idx = i * 3;
+			int32_t val = (raw[idx + 0]) | (raw[idx + 1] << 8) | (raw[idx + 2] << 16);
+			if (val & 0x800000)
+				val |= 0xFF000000;
+			out[i] = val / 8388608.0f;
+		}
+		break;
+	case 32:
+		if (info.formatType == 3) {
+			std::memcpy(out, raw, numSamples * sizeof(float));
+		} else {
+			for (size_t i = 0; i < numSamples; ++i) {
+				int32_t val;
+				std::memcpy(&val, raw + i * 4, 4);
+				out[i] = (float)(val / 2147483648.0);
+			}
+		}
+		break;
+	case 64: // float
+		for (size_t i = 0; i < numSamples; ++i) {
+			double val;
+			std::memcpy(&val, raw + i * 8, 8);
+			out[i] = (float)val;
+		}
+		break;
+	}
+}
+
+static bool DecodeWav(const std::string& path, SampleData& out) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Failed to open audio file: " << path << "\n";
+		return false;
+	}
+
+	WavInfo info;
+	if (!ReadWavInfo(file, path, info))
+		return false;
+
+	size_t numSamples = (size_t)info.numFrames * info.channels;
+	std::vector<uint8_t> raw(numSamples * (info.bitsPerSample / 8));
+	file.read((char*)raw.data(), raw.size());
+
+	out.channels = info.channels;
+	out.sampleRate = info.sampleRate;
+	out.numFrames = info.numFrames;
+	out.samples.resize(numSamples);
+	ConvertWavSamples(info, raw.data(), numSamples, out.samples.data());
+	out.data = out.samples.data();
+	out.numSamples = numSamples;
+	return true;
+}
+
+static bool MapWav(const std::string& path, SampleData& out) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Failed to open audio file: " << path << "\n";
+		return false;
+	}
+
+	WavInfo info;
+	if (!ReadWavInfo(file, path, info))
+		return false;
+	file.close();
+
+	out.mapping = MappedFile::Open(path);
+	if (!out.mapping || out.mapping->GetSize() < info.dataOffset + (uint64_t)info.numFrames * info.BytesPerFrame()) {
+		std::cout << "Failed to map audio file: " << path << "\n";
+		return false;
+	}
+
+	out.wav = info;
+	out.channels = info.channels;
+	out.sampleRate = info.sampleRate;
+	out.numFrames = info.numFrames;
+
+	// 32-bit float samples are played straight out of the mapping; the data chunk of a normal wav
+	// sits 4-byte aligned, anything odd falls back to converting like integer pcm
+	if (info.formatType == 3 && info.bitsPerSample == 32 && info.dataOffset % alignof(float) == 0) {
+		out.data = (const float*)(out.mapping->GetData() + info.dataOffset);
+		out.numSamples = (size_t)info.numFrames * info.channels;
+	}
+	return true;
+}
+
+SamplePool& SamplePool::Instance() {
+	static SamplePool instance;
+	return instance;
+}
+
+bool SamplePool::Key::operator<(const Key& other) const {
+	return std::tie(path, size, modified, mapped) < std::tie(other.path, other.size, other.modified, other.mapped);
+}
+
+std::shared_ptr<const SampleData> SamplePool::Load(const std::string& path) {
+	return Get(path, false);
+}
+
+std::shared_ptr<const SampleData> SamplePool::Map(const std::string& path) {
+	return Get(path, true);
+}
+
+std::shared_ptr<const SampleData> SamplePool::Get(const std::string& path, bool mapped) {
+	std::error_code ec;
+	Key key;
+	key.mapped = mapped;
+	key.path = std::filesystem::absolute(path, ec).lexically_normal().string();
+	if (ec)
+		key.path = path;
+	key.size = std::filesystem::file_size(path, ec);
+	if (!ec)
+		key.modified = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	if (ec) {
+		std::cout << "Failed to open audio file: " << path << "\n";
+		return nullptr;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mEntries.find(key);
+		if (it != mEntries.end()) {
+			if (auto data = it->second.lock())
+				return data;
+			mEntries.erase(it); // its audio is gone; the load below adds it back
+		}
+	}
+
+	// load without the lock. two threads racing on one file both load, and the first to
+	// publish wins
+	auto data = std::make_shared<SampleData>();
+	if (!(mapped ? MapWav(path, *data) : DecodeWav(path, *data)))
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto& entry = mEntries[key];
+	if (auto existing = entry.lock())
+		return existing;
+	entry = data;
+
+	// drop entries whose audio is gone, including older versions of files edited on disk, once
+	// the map has doubled since the last sweep: loading n files then costs O(n) sweeping, not O(n^2)
+	if (mEntries.size() >= 2 * mEntriesAfterPrune + 16) {
+		for (auto it = mEntries.begin(); it != mEntries.end();) {
+			if (it->second.expired())
+				it = mEntries.erase(it);
+			else
+				++it;
+		}
+		mEntriesAfterPrune = mEntries.size();
+	}
+	return data;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "MappedFile.h"
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// a wav's layout, read from its header alone: enough to decode any span of the data chunk
+struct WavInfo {
+	int channels = 2;
+	double sampleRate = 48000.0;
+	uint16_t formatType = 1; // 1 pcm, 3 ieee float (extensible files give their subformat's)
+	uint16_t bitsPerSample = 16;
+	uint64_t dataOffset = 0; // file offset of the first sample
+	uint64_t dataBytes = 0;
+	uint64_t numFrames = 0;
+
+	int BytesPerFrame() const { return channels * (bitsPerSample / 8); }
+};
+
+// a file's audio, shared by every clip that plays it. never written after loading, so clips,
+// render snapshots and the audio thread all hold the same copy without locking
+struct SampleData {
+	std::vector<float> samples; // interleaved, when decoded into memory
+	int channels = 2;
+	double sampleRate = 48000.0;
+	uint64_t numFrames = 0;
+
+	// the interleaved floats to play: samples.data(), or for a mapped 32-bit float file its data
+	// chunk in place. null for mapped integer pcm, which SampleStream converts as it's read
+	const float* data = nullptr;
+	size_t numSamples = 0;
+
+	// set when the file is mapped rather than decoded, along with its layout
+	std::shared_ptr<const MappedFile> mapping;
+	WavInfo wav;
+};
+
+// parses the riff header and leaves `file` at the start of the data chunk. false (and logs)
+// if it isn't a wav this reader can decode: 8/16/24/32-bit pcm or 32/64-bit float, plain,
+// WAVE_FORMAT_EXTENSIBLE or rf64, so everything WavWriter writes reads back
+bool ReadWavInfo(std::istream& file, const std::string& path, WavInfo& info);
+// the same for the file at `path`, which is opened and closed again
+bool ReadWavInfo(const std::string& path, WavInfo& info);
+
+// converts `numSamples` raw samples in the file's encoding to floats
+void ConvertWavSamples(const WavInfo& info, const uint8_t* raw, size_t numSamples, float* out);
+
+// process-wide cache of decoded (or mapped) files, keyed by path, size and modification time,
+// so a file changed on disk is loaded afresh. entries are weak: audio no clip uses is freed, not kept.
+// safe to call from any thread (a background render job loads its own project copy)
+class SamplePool {
+public:
+	static SamplePool& Instance();
+
+	// the decoded file, decoding it only if nothing alive holds this version yet. nullptr if
+	// the file can't be read or isn't a supported wav
+	std::shared_ptr<const SampleData> Load(const std::string& path);
+
+	// the same, but mapping the file instead of decoding it (see SampleData::data)
+	std::shared_ptr<const SampleData> Map(const std::string& path);
+private:
+	SamplePool() = default;
+	std::shared_ptr<const SampleData> Get(const std::string& path, bool mapped);
+
+	struct Key {
+		std::string path;
+		uintmax_t size = 0;
+		int64_t modified = 0;
+		bool mapped = false;
+		bool operator<(const Key& other) const;
+	};
+
+	std::mutex mMutex;
+	std::map<Key, std::weak_ptr<const SampleData>> mEntries;
+	size_t mEntriesAfterPrune = 0; // how many the last sweep for expired entries left
+};
@@ -0,0 +1,227 @@
+#include "PrecompHeader.h"
+#include "SampleStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+std::shared_ptr<SampleStream> SampleStream::Open(const std::string& path, const WavInfo& info,
+												 std::shared_ptr<const void> owner) {
+	auto stream = std::make_shared<SampleStream>(path, info);
+	stream->mOwner = std::move(owner);
+	DiskStreamer::Instance().Register(stream);
+	return stream;
+}
+
+SampleStream::SampleStream(const std::string& path, const WavInfo& info, bool withRing) : mPath(path), mInfo(info) {
+	if (withRing) {
+		mNumChunks = (int64_t)((mInfo.numFrames + kChunkFrames - 1) / kChunkFrames);
+		mSlots = std::make_unique<Slot[]>(kNumChunks);
+		for (int i = 0; i < kNumChunks; ++i)
+			mSlots[i].data.resize((size_t)(kChunkFrames * mInfo.channels));
+	}
+	mScratch.resize((size_t)(kScratchFrames * mInfo.channels));
+}
+
+std::shared_ptr<SampleStream> SampleStream::ReopenDirect() const {
+	if (mMapped)
+		return OpenMapped(mMapped);
+	return std::make_shared<SampleStream>(mPath, mInfo, false);
+}
+
+std::shared_ptr<SampleStream> SampleStream::OpenMapped(std::shared_ptr<const SampleData> mapped) {
+	return std::make_shared<SampleStream>(std::move(mapped));
+}
+
+SampleStream::SampleStream(std::shared_ptr<const SampleData> mapped) : mInfo(mapped->wav), mMapped(std::move(mapped)) {
+	mScratch.resize((size_t)(kScratchFrames * mInfo.channels));
+}
+
+void SampleStream::ReadMapped(int64_t firstFrame, int64_t numFrames, float* out) const {
+	int channels = mInfo.channels;
+	int64_t lo = std::clamp<int64_t>(firstFrame, 0, (int64_t)mInfo.numFrames);
+	int64_t hi = std::clamp<int64_t>(firstFrame + numFrames, 0, (int64_t)mInfo.numFrames);
+
+	if (hi <= lo) {
+		std::fill(out, out + numFrames * channels, 0.0f);
+		return;
+	}
+
+	// convert only the span asked for; the mapping pages in whatever it covers
+	const uint8_t* raw = mMapped->mapping->GetData() + mInfo.dataOffset + (uint64_t)lo * mInfo.BytesPerFrame();
+	std::fill(out, out + (lo - firstFrame) * channels, 0.0f);
+	ConvertWavSamples(mInfo, raw, (size_t)(hi - lo) * channels, out + (lo - firstFrame) * channels);
+	std::fill(out + (hi - firstFrame) * channels, out + numFrames * channels, 0.0f);
+}
+
+bool SampleStream::Read(int64_t firstFrame, int64_t numFrames, float* out) const {
+	if (mMapped) {
+		ReadMapped(firstFrame, numFrames, out);
+		return true;
+	}
+
+	int channels = mInfo.channels;
+	int64_t fileFrames = (int64_t)mInfo.numFrames;
+	bool complete = true;
+
+	int64_t frame = firstFrame;
+	int64_t end = firstFrame + numFrames;
+	while (frame < end) {
+		float* dst = out + (frame - firstFrame) * channels;
+		if (frame < 0 || frame >= fileFrames) {
+			// before or past the file: silence up to the next edge
+			int64_t run = frame < 0 ? std::min(end, (int64_t)0) - frame : end - frame;
+			std::fill(dst, dst + run * channels, 0.0f);
+			frame += run;
+			continue;
+		}
+
+		int64_t chunk = frame / kChunkFrames;
+		int64_t offset = frame - chunk * kChunkFrames;
+		int64_t run = std::min(end, std::min(fileFrames, (chunk + 1) * kChunkFrames)) - frame;
+		const Slot& slot = mSlots[chunk % kNumChunks];
+
+		// seqlock read: copy, then make sure the writer didn't take the slot meanwhile
+		bool valid = slot.chunk.load(std::memory_order_acquire) == chunk;
+		if (valid) {
+			std::memcpy(dst, slot.data.data() + offset * channels, (size_t)(run * channels) * sizeof(float));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			valid = slot.chunk.load(std::memory_order_relaxed) == chunk;
+		}
+		if (!valid) {
+			std::fill(dst, dst + run * channels, 0.0f);
+			complete = false;
+		}
+		frame += run;
+	}
+	return complete;
+}
+
+bool SampleStream::ReadDirect(int64_t firstFrame, int64_t numFrames, float* out) {
+	if (mMapped) {
+		ReadMapped(firstFrame, numFrames, out);
+		return true;
+	}
+
+	int channels = mInfo.channels;
+	int64_t lo = std::clamp<int64_t>(firstFrame, 0, (int64_t)mInfo.numFrames);
+	int64_t hi = std::clamp<int64_t>(firstFrame + numFrames, 0, (int64_t)mInfo.numFrames);
+
+	std::fill(out, out + numFrames * channels, 0.0f);
+	if (hi <= lo)
+		return true;
+
+	if (!mDirectFile.is_open())
+		mDirectFile.open(mPath, std::ios::binary);
+	return LoadFrames(mDirectFile, mDirectRaw, lo, hi - lo, out + (lo - firstFrame) * channels);
+}
+
+bool SampleStream::LoadFrames(std::ifstream& file, std::vector<uint8_t>& raw, int64_t firstFrame, int64_t numFrames, float* out) {
+	size_t bytes = (size_t)(numFrames * mInfo.BytesPerFrame());
+	raw.resize(bytes);
+
+	file.clear();
+	file.seekg((std::streamoff)(mInfo.dataOffset + (uint64_t)firstFrame * mInfo.BytesPerFrame()));
+	file.read((char*)raw.data(), (std::streamsize)bytes);
+	size_t got = file ? bytes : (size_t)std::max<std::streamsize>(0, file.gcount());
+
+	size_t samples = got / (mInfo.bitsPerSample / 8);
+	ConvertWavSamples(mInfo, raw.data(), samples, out);
+	std::fill(out + samples, out + numFrames * mInfo.channels, 0.0f); // truncated file
+	return got == bytes;
+}
+
+bool SampleStream::FillNext() {
+	int64_t cue = mCueFrame.load(std::memory_order_acquire);
+	if (cue < 0 || mNumChunks == 0 || mMapped)
+		return false;
+
+	// the window is the cued chunk, the ones after it, and one behind it. load the cued
+	// chunk first, then forward in play order, and the one behind last
+	int64_t cueChunk = std::min(cue / kChunkFrames, mNumChunks - 1);
+	int64_t first = std::max<int64_t>(0, cueChunk - 1);
+	int64_t last = std::min(first + kNumChunks, mNumChunks);
+
+	int64_t want = -1;
+	for (int64_t chunk = cueChunk; chunk < last && want < 0; ++chunk) {
+		if (mSlots[chunk % kNumChunks].chunk.load(std::memory_order_relaxed) != chunk)
+			want = chunk;
+	}
+	if (want < 0 && first < cueChunk && mSlots[first % kNumChunks].chunk.load(std::memory_order_relaxed) != first)
+		want = first;
+	if (want < 0)
+		return false;
+
+	if (!mFile.is_open()) {
+		mFile.open(mPath, std::ios::binary);
+		if (!mFile.is_open())
+			return false;
+	}
+
+	// seqlock write: mark the slot empty before touching its data, publish the index after
+	Slot& slot = mSlots[want % kNumChunks];
+	slot.chunk.store(-1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	int64_t firstFrame = want * kChunkFrames;
+	int64_t numFrames = std::min<int64_t>(kChunkFrames, (int64_t)mInfo.numFrames - firstFrame);
+	LoadFrames(mFile, mRaw, firstFrame, numFrames, slot.data.data());
+	slot.chunk.store(want, std::memory_order_release);
+	return true;
+}
+
+DiskStreamer& DiskStreamer::Instance() {
+	static DiskStreamer instance;
+	return instance;
+}
+
+DiskStreamer::~DiskStreamer() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mCondition.notify_all();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+void DiskStreamer::Register(const std::shared_ptr<SampleStream>& stream) {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStreams.push_back(stream);
+		if (!mThread.joinable())
+			mThread = std::thread(&DiskStreamer::Run, this);
+	}
+	mCondition.notify_all();
+}
+
+void DiskStreamer::Run() {
+	std::vector<std::shared_ptr<SampleStream>> streams;
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mQuit)
+				return;
+			streams.clear();
+			std::erase_if(mStreams, [&](const std::weak_ptr<SampleStream>& weak) {
+				auto stream = weak.lock();
+				if (!stream)
+					return true;
+				streams.push_back(std::move(stream));
+				return false;
+			});
+		}
+
+		// one chunk per stream per round until every window is full
+		bool busy = true;
+		while (busy) {
+			busy = false;
+			for (auto& stream : streams)
+				busy |= stream->FillNext();
+		}
+		streams.clear(); // don't keep a deleted clip's stream alive through the nap
+
+		// cues are plain atomics written by the audio thread, which must not take a lock to
+		// wake us, so poll. a few ms is far inside the ~10 s each ring holds
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCondition.wait_for(lock, std::chrono::milliseconds(4), [this] { return mQuit; });
+	}
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "SamplePool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a long file played from disk instead of decoded up front. the file is split into fixed
+// chunks, and a ring of chunk slots holds the few around the play position: the disk thread
+// loads the chunk the clip is cued to plus the ones after it (and one before, for grains
+// reaching back), evicting whatever fell out of that window. memory per clip is fixed.
+//
+// one clip owns one stream. the audio thread is the only reader and DiskStreamer the only
+// writer of the ring; each slot is a seqlock (chunk index, data), so neither side ever waits.
+// a chunk not resident yet reads as silence rather than stalling the block.
+//
+// a stream can also front a mapped integer-pcm file (SamplePool::Map). it then has no ring
+// and no disk thread: reads convert the requested span straight out of the mapping.
+//
+// a stream may hold an owner for its file (a WarpFreeze's scratch file), which it keeps alive
+// until it has closed the file
+class SampleStream {
+public:
+	static constexpr int64_t kChunkFrames = 32768; // ~0.7 s at 48 kHz
+	static constexpr int kNumChunks = 16;		   // 4 MB of stereo float per clip, ~10 s ahead
+
+	// a stream of the file `info` was read from, already handed to the disk thread
+	static std::shared_ptr<SampleStream> Open(const std::string& path, const WavInfo& info,
+											  std::shared_ptr<const void> owner = nullptr);
+	// a stream reading a mapped file in place
+	static std::shared_ptr<SampleStream> OpenMapped(std::shared_ptr<const SampleData> mapped);
+	std::shared_ptr<SampleStream> Reopen() const { return mMapped ? OpenMapped(mMapped) : Open(mPath, mInfo, mOwner); }
+	// another stream of the file for a reader off the audio thread: only ReadDirect works on it,
+	// and it has no ring for the disk thread to fill
+	std::shared_ptr<SampleStream> ReopenDirect() const;
+
+	// `withRing` false makes a ReadDirect-only stream (see ReopenDirect)
+	SampleStream(const std::string& path, const WavInfo& info, bool withRing = true);
+	explicit SampleStream(std::shared_ptr<const SampleData> mapped);
+
+	SampleStream(const SampleStream&) = delete;
+	SampleStream& operator=(const SampleStream&) = delete;
+
+	int GetChannels() const { return mInfo.channels; }
+	double GetSampleRate() const { return mInfo.sampleRate; }
+	uint64_t GetNumFrames() const { return mInfo.numFrames; }
+
+	// audio thread: ask the disk thread to have `frame` and the frames after it resident
+	void Cue(int64_t frame) { mCueFrame.store(frame < 0 ? 0 : frame, std::memory_order_release); }
+
+	// audio thread: copies source frames [firstFrame, firstFrame + numFrames) into `out`
+	// (interleaved). frames outside the file or not resident come back as silence; returns
+	// false if any frame inside the file was missing
+	bool Read(int64_t firstFrame, int64_t numFrames, float* out) const;
+
+	// offline render: the same copy, read straight from disk on the calling thread so an
+	// export never drops audio. bypasses the ring, so it is safe next to the disk thread
+	bool ReadDirect(int64_t firstFrame, int64_t numFrames, float* out);
+
+	// gather buffer for the audio thread's reads, sized once here so playback never
+	// allocates; Track::Process clamps its read span to it
+	float* GetScratch() { return mScratch.data(); }
+	static constexpr int64_t kScratchFrames = kChunkFrames * 2;
+
+	// disk thread: loads the most urgent missing chunk of the cued window. false when the
+	// window is complete (or nothing was cued yet) and there is nothing to do
+	bool FillNext();
+private:
+	struct Slot {
+		std::atomic<int64_t> chunk{-1}; // chunk held, -1 while empty or being written
+		std::vector<float> data;
+	};
+
+	void ReadMapped(int64_t firstFrame, int64_t numFrames, float* out) const;
+	bool LoadFrames(std::ifstream& file, std::vector<uint8_t>& raw, int64_t firstFrame, int64_t numFrames, float* out);
+
+	std::shared_ptr<const void> mOwner; // declared first, so it outlives the files below
+	std::string mPath;
+	WavInfo mInfo;
+	std::shared_ptr<const SampleData> mMapped;
+	int64_t mNumChunks = 0;
+	std::unique_ptr<Slot[]> mSlots;
+	std::atomic<int64_t> mCueFrame{-1};
+	std::vector<float> mScratch;
+
+	std::ifstream mFile; // disk thread only
+	std::vector<uint8_t> mRaw;
+	std::ifstream mDirectFile; // ReadDirect only
+	std::vector<uint8_t> mDirectRaw;
+};
+
+// how a clip holds its stream. a copied clip (split, duplicate, paste) must not share it, since
+// a stream follows one play position, so copying the handle opens a new stream on the file
+class SampleStreamHandle {
+public:
+	SampleStreamHandle() = default;
+	explicit SampleStreamHandle(std::shared_ptr<SampleStream> stream) : mStream(std::move(stream)) {}
+	SampleStreamHandle(const SampleStreamHandle& other) : mStream(other.mStream ? other.mStream->Reopen() : nullptr) {}
+	SampleStreamHandle& operator=(const SampleStreamHandle& other) {
+		if (this != &other)
+			mStream = other.mStream ? other.mStream->Reopen() : nullptr;
+		return *this;
+	}
+	SampleStreamHandle(SampleStreamHandle&&) = default;
+	SampleStreamHandle& operator=(SampleStreamHandle&&) = default;
+
+	const std::shared_ptr<SampleStream>& Get() const { return mStream; }
+private:
+	std::shared_ptr<SampleStream> mStream;
+};
+
+// the thread that keeps every playing stream's ring topped up. it round-robins one chunk per
+// stream so a single clip far from its cue can't starve the rest, and naps when all are full
+class DiskStreamer {
+public:
+	static DiskStreamer& Instance();
+	~DiskStreamer();
+
+	// starts feeding `stream` (held weakly: a clip that goes away drops out on its own)
+	void Register(const std::shared_ptr<SampleStream>& stream);
+private:
+	DiskStreamer() = default;
+	void Run();
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::vector<std::weak_ptr<SampleStream>> mStreams;
+	std::thread mThread;
+	bool mQuit = false;
+};
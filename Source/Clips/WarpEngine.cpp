@@ -1,7 +1,27 @@
 #include "PrecompHeader.h"
 #include "WarpEngine.h"
+#include "WarpVocoder.h"
 #include <cmath>
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define WARP_KERNEL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// lets one function use avx2 without building the whole file for it; msvc needs no opt-in
+#if defined(WARP_KERNEL_X86) && defined(__GNUC__)
+#define WARP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define WARP_TARGET_AVX2
+#endif
 
 namespace {
 
@@ -21,29 +41,48 @@ namespace {
 	// candidate source offsets tried per grain in the similarity search (odd so 0 is centered)
 	constexpr int kWsolaCandidates = 21;
 
-	// per-mode geometry resolved from the params once per block
+	// search result for a grain the search doesn't run on (no room to shift, no overlap): no offset
+	constexpr int8_t kNoShift = kWsolaCandidates;
+
+	// grains an alignment table holds at most (a byte each); a clip slowed to a crawl past that
+	// searches its remaining grains live
+	constexpr size_t kMaxAlignmentGrains = size_t(1) << 22;
+
+	// per-mode geometry resolved from the params once per block. all of it is whole frames, so
+	// every grain center lands on a frame and samples its window at the same offsets -- which
+	// is what lets a WarpWindowTable hold the window once instead of each grain evaluating it
 	struct ModeConfig {
-		double grainOut = 0.0; // grain length in output frames
-		double hop = 0.0;	   // synthesis hop in output frames (grain / overlap)
-		double halfLen = 0.0;  // half a grain, the window's reach from its center
-		double rampLen = 0.0;  // window rise/fall length; == halfLen gives a full Hann
+		int64_t grainOut = 0; // grain length in output frames, a whole number of hops
+		int64_t hop = 0;	  // synthesis hop in output frames (grain / overlap)
+		int64_t halfLen = 0;  // half a grain, the window's reach from its center
+		int64_t rampLen = 0;  // window rise/fall length; == halfLen gives a full Hann
 		bool useWsola = false;
 		bool useFluct = false;
 		bool useFormants = false;
 	};
 
+	// the source audio a block reads: the whole decoded file, or for a streamed clip just the
+	// span gathered around this block, which starts at source frame firstFrame
+	struct SourceSpan {
+		const float* samples = nullptr;
+		size_t numSamples = 0;
+		int channels = 1;
+		int64_t firstFrame = 0;
+	};
+
 	// linear-interpolated read of one source channel at a fractional frame; out of range is
 	// silence, so grains that run past the file end simply fade out
-	inline float ReadSampleLinear(const float* s, size_t n, int clipChannels, int channel, double pos) {
+	inline float ReadSampleLinear(const SourceSpan& src, int channel, double pos) {
+		pos -= (double)src.firstFrame;
 		if (pos < 0.0)
 			return 0.0f;
 		int64_t i = (int64_t)pos;
 		double frac = pos - (double)i;
-		size_t idx1 = (size_t)(i * clipChannels + channel);
-		size_t idx2 = idx1 + (size_t)clipChannels;
-		if (idx2 >= n)
+		size_t idx1 = (size_t)(i * src.channels + channel);
+		size_t idx2 = idx1 + (size_t)src.channels;
+		if (idx2 >= src.numSamples)
 			return 0.0f;
-		return s[idx1] + (float)frac * (s[idx2] - s[idx1]);
+		return src.samples[idx1] + (float)frac * (src.samples[idx2] - src.samples[idx1]);
 	}
 
 	// raised-cosine window with a flat top: 0 at the edges, ramps over rampLen, then plateaus.
@@ -75,6 +114,126 @@ namespace {
 		return ((double)h / 4294967295.0) * 2.0 - 1.0;
 	}
 
+	// one grain's overlap-add into acc (count frames, destChannels wide): frame i adds window[i]
+	// times the source at anchor + (firstLocal + i) * pitchRead. the vector kernel below does
+	// this same arithmetic per frame, operation for operation, so which one the cpu gets --
+	// and where a block boundary splits a grain -- never changes a bit of the output
+	using GrainKernel = void (*)(const SourceSpan& src, const float* window, double anchor, int64_t firstLocal,
+								 double pitchRead, int count, int destChannels, float* acc);
+
+	void LayGrainScalar(const SourceSpan& src, const float* window, double anchor, int64_t firstLocal,
+						double pitchRead, int count, int destChannels, float* acc) {
+		for (int i = 0; i < count; ++i) {
+			double srcPos = anchor + (double)(firstLocal + i) * pitchRead;
+			for (int c = 0; c < destChannels; ++c)
+				acc[i * destChannels + c] += window[i] * ReadSampleLinear(src, c % src.channels, srcPos);
+		}
+	}
+
+#ifdef WARP_KERNEL_X86
+	// 8 frames at a time, positions and reads included: the frames' source positions are
+	// computed as doubles 4 wide, then both samples of every frame come in with one gather each
+	WARP_TARGET_AVX2 void LayGrainAvx2(const SourceSpan& src, const float* window, double anchor, int64_t firstLocal,
+									   double pitchRead, int count, int destChannels, float* acc) {
+		// v[] below holds one vector per output channel, mono or stereo: anything wider goes
+		// the scalar way whole, whichever caller asked
+		if (destChannels < 1 || destChannels > 2) {
+			LayGrainScalar(src, window, anchor, firstLocal, pitchRead, count, destChannels, acc);
+			return;
+		}
+
+		// the gathers take 32-bit indices and skip the range checks, so a run of 8 frames goes
+		// this way only when every read of it lands inside the span
+		const int channels = src.channels;
+		const int64_t maxFrame = std::min<int64_t>((int64_t)(src.numSamples / channels), INT32_MAX / channels);
+		const __m256d lanes = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+		const __m256d vAnchor = _mm256_set1_pd(anchor);
+		const __m256d vPitch = _mm256_set1_pd(pitchRead);
+		const __m256d vFirst = _mm256_set1_pd((double)src.firstFrame);
+		const __m256i vChannels = _mm256_set1_epi32(channels);
+
+		int i = 0;
+		for (; pitchRead > 0.0 && i + 8 <= count; i += 8) {
+			double first = (double)(firstLocal + i);
+			double posFirst = anchor + first * pitchRead - (double)src.firstFrame;
+			double posLast = anchor + (double)(firstLocal + i + 7) * pitchRead - (double)src.firstFrame;
+			if (!(posFirst >= 0.0) || (int64_t)posLast + 2 > maxFrame) {
+				_mm256_zeroupper();
+				LayGrainScalar(src, window + i, anchor, firstLocal + i, pitchRead, 8, destChannels, acc + i * destChannels);
+				continue;
+			}
+
+			__m256d local0 = _mm256_add_pd(_mm256_set1_pd(first), lanes);
+			__m256d local1 = _mm256_add_pd(local0, _mm256_set1_pd(4.0));
+			__m256d pos0 = _mm256_sub_pd(_mm256_add_pd(vAnchor, _mm256_mul_pd(local0, vPitch)), vFirst);
+			__m256d pos1 = _mm256_sub_pd(_mm256_add_pd(vAnchor, _mm256_mul_pd(local1, vPitch)), vFirst);
+			__m128i frame0 = _mm256_cvttpd_epi32(pos0);
+			__m128i frame1 = _mm256_cvttpd_epi32(pos1);
+			__m128 frac0 = _mm256_cvtpd_ps(_mm256_sub_pd(pos0, _mm256_cvtepi32_pd(frame0)));
+			__m128 frac1 = _mm256_cvtpd_ps(_mm256_sub_pd(pos1, _mm256_cvtepi32_pd(frame1)));
+			__m256 frac = _mm256_insertf128_ps(_mm256_castps128_ps256(frac0), frac1, 1);
+			__m256i base = _mm256_mullo_epi32(_mm256_inserti128_si256(_mm256_castsi128_si256(frame0), frame1, 1), vChannels);
+
+			__m256 w = _mm256_loadu_ps(window + i);
+			__m256 v[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+			for (int c = 0; c < destChannels; ++c) {
+				__m256i idx1 = _mm256_add_epi32(base, _mm256_set1_epi32(c % channels));
+				__m256 s1 = _mm256_i32gather_ps(src.samples, idx1, 4);
+				__m256 s2 = _mm256_i32gather_ps(src.samples, _mm256_add_epi32(idx1, vChannels), 4);
+				v[c] = _mm256_mul_ps(w, _mm256_add_ps(s1, _mm256_mul_ps(frac, _mm256_sub_ps(s2, s1))));
+			}
+
+			float* out = acc + i * destChannels;
+			if (destChannels == 2) {
+				// unpack interleaves within each 128-bit half; the permutes put the frames back in order
+				__m256 lo = _mm256_unpacklo_ps(v[0], v[1]); // frames 0 1 | 4 5
+				__m256 hi = _mm256_unpackhi_ps(v[0], v[1]); // frames 2 3 | 6 7
+				_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_permute2f128_ps(lo, hi, 0x20)));
+				_mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(out + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+			} else {
+				_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), v[0]));
+			}
+		}
+		// gcc doesn't clear the upper halves for a target("avx2") function, and sse code (the
+		// caller's, libm's) running with them dirty stalls on every instruction
+		_mm256_zeroupper();
+		LayGrainScalar(src, window + i, anchor, firstLocal + i, pitchRead, count - i, destChannels, acc + i * destChannels);
+	}
+
+	bool CpuHasAvx2() {
+#ifdef _MSC_VER
+		// avx2 in the cpu, and ymm state saved by the os
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	std::atomic<bool> sScalarKernelOnly{false};
+
+	// the avx2 kernel where the cpu has it, picked on first use. a 4-wide kernel without the
+	// gathers measured no faster than the scalar one: the per-frame reads are the cost
+	GrainKernel GetGrainKernel() {
+		static const GrainKernel kernel = [] {
+#ifdef WARP_KERNEL_X86
+			if (CpuHasAvx2())
+				return &LayGrainAvx2;
+#endif
+			return &LayGrainScalar;
+		}();
+		return sScalarKernelOnly.load(std::memory_order_relaxed) ? &LayGrainScalar : kernel;
+	}
+
 	ModeConfig ResolveMode(const WarpRenderParams& p) {
 		ModeConfig c;
 		double sr = (p.sampleRate > 0.0) ? p.sampleRate : 48000.0;
@@ -115,14 +274,15 @@ namespace {
 			break;
 		}
 
-		c.grainOut = std::max(8.0, grainMs * 0.001 * sr);
-		c.hop = c.grainOut / (double)overlap;
-		c.halfLen = c.grainOut * 0.5;
+		double grainFrames = std::max(8.0, grainMs * 0.001 * sr);
+		c.hop = std::max<int64_t>(2, std::llround(grainFrames / (double)overlap));
+		c.grainOut = c.hop * overlap;
+		c.halfLen = c.grainOut / 2;
 
 		if (p.mode == WarpMode::Beats) {
 			// map 0..1 onto "very short fade" .. "full Hann"; a floor avoids audible clicks
-			double minRamp = std::min(c.halfLen, std::max(2.0, 0.001 * sr)); // ~1 ms
-			c.rampLen = minRamp + (c.halfLen - minRamp) * std::clamp(p.transientEnvelope, 0.0, 1.0);
+			int64_t minRamp = std::min(c.halfLen, std::max<int64_t>(2, std::llround(0.001 * sr))); // ~1 ms
+			c.rampLen = minRamp + std::llround((double)(c.halfLen - minRamp) * std::clamp(p.transientEnvelope, 0.0, 1.0));
 		} else {
 			c.rampLen = c.halfLen; // full Hann
 		}
@@ -135,33 +295,45 @@ namespace {
 		return (cj + p.offsetOutputFrames) * p.speed;
 	}
 
+	// how far a tonal-mode grain may shift: up to half a hop of source content either way
+	inline double WsolaDelta(const ModeConfig& cfg, const WarpRenderParams& p) {
+		return cfg.hop * p.pitchRead * 0.5;
+	}
+
+	// the source offset a search result stands for
+	inline double WsolaAdjust(int8_t candidate, double delta) {
+		if (candidate == kNoShift)
+			return 0.0;
+		return -delta + (2.0 * delta) * ((double)candidate / (double)(kWsolaCandidates - 1));
+	}
+
 	// find the source-offset adjustment (in source frames, within +/- delta) that best lines
 	// this grain up with the previous one, reducing the phasiness plain overlap-add causes on
-	// pitched material. a small center bias makes 0 win on silence so we never chase noise
-	double WsolaSearch(const float* samples, size_t numSamples, int clipChannels,
-					   double cj, double cjPrev, double anchorJ, double prevPlacedAnchor,
+	// pitched material. a small center bias makes 0 win on silence so we never chase noise.
+	// returns the winning candidate (see WsolaAdjust), which is what an alignment table stores
+	int8_t WsolaSearch(const SourceSpan& src, double cj, double cjPrev, double anchorJ, double prevPlacedAnchor,
 					   const ModeConfig& cfg, const WarpRenderParams& p) {
-		double delta = cfg.hop * p.pitchRead * 0.5; // up to half a hop of source content
+		double delta = WsolaDelta(cfg, p);
 		if (delta < 1.0)
-			return 0.0;
+			return kNoShift;
 
 		// the two grains overlap on the output grid between these frames
 		double regionStart = cj - cfg.halfLen;
 		double regionEnd = cjPrev + cfg.halfLen;
 		double regionLen = regionEnd - regionStart;
 		if (regionLen <= 1.0)
-			return 0.0;
+			return kNoShift;
 		double stride = regionLen / (double)kCorrTaps;
 
 		double bestScore = -2.0;
-		double bestAdjust = 0.0;
+		int8_t bestCandidate = kNoShift;
 		for (int ci = 0; ci < kWsolaCandidates; ++ci) {
-			double s = -delta + (2.0 * delta) * ((double)ci / (double)(kWsolaCandidates - 1));
+			double s = WsolaAdjust((int8_t)ci, delta);
 			double corr = 0.0, e1 = 0.0, e2 = 0.0;
 			for (int t = 0; t < kCorrTaps; ++t) {
 				double outPos = regionStart + ((double)t + 0.5) * stride;
-				double sJ = ReadSampleLinear(samples, numSamples, clipChannels, 0, anchorJ + s + (outPos - cj) * p.pitchRead);
-				double sP = ReadSampleLinear(samples, numSamples, clipChannels, 0, prevPlacedAnchor + (outPos - cjPrev) * p.pitchRead);
+				double sJ = ReadSampleLinear(src, 0, anchorJ + s + (outPos - cj) * p.pitchRead);
+				double sP = ReadSampleLinear(src, 0, prevPlacedAnchor + (outPos - cjPrev) * p.pitchRead);
 				corr += sJ * sP;
 				e1 += sJ * sJ;
 				e2 += sP * sP;
@@ -170,26 +342,40 @@ namespace {
 			double score = ncc - 1e-3 * std::abs(s) / delta; // tie-break toward no shift
 			if (score > bestScore) {
 				bestScore = score;
-				bestAdjust = s;
+				bestCandidate = (int8_t)ci;
 			}
 		}
-		return bestAdjust;
+		return bestCandidate;
+	}
+
+	// grain j's alignment. it compares against the previous grain's *unadjusted* anchor rather
+	// than chaining grain-to-grain: a grain's offset is then a pure function of the source and
+	// its own index, so whichever block renders it computes the identical offset. that keeps
+	// the engine position-addressable (bit-exact regardless of how the caller splits the
+	// range), and is what lets an alignment table remember it
+	int8_t AlignGrain(const SourceSpan& src, int64_t j, const ModeConfig& cfg, const WarpRenderParams& p) {
+		double cj = (double)j * cfg.hop;
+		double cjPrev = (double)(j - 1) * cfg.hop;
+		return WsolaSearch(src, cj, cjPrev, GrainAnchor(cj, p), GrainAnchor(cjPrev, p), cfg, p);
 	}
 
 	// renders output frames [a, a+n) for one clip, mixing into dest (n frames, destChannels
 	// wide). a guard sample at frame a-1 is rendered too, so ComplexPro's one-zero formant
-	// filter has a real previous input and introduces no click at tile boundaries
-	void RenderTile(const float* samples, size_t numSamples, int clipChannels,
-					int64_t a, int n, int destChannels, float* dest,
-					const WarpRenderParams& p, const ModeConfig& cfg) {
+	// filter has a real previous input and introduces no click at tile boundaries.
+	// `window`, when given, matches cfg; without it each grain's window is evaluated here
+	void RenderTile(const SourceSpan& src, int64_t a, int n, int destChannels, float* dest,
+					const WarpRenderParams& p, const ModeConfig& cfg, WarpAlignmentTable* alignment,
+					const WarpWindowTable* window) {
 		// buffer index bi in [0, n] maps to output frame (a - 1 + bi); bi 0 is the guard
 		float acc[(kMaxTile + 1) * 2];
 		double wgt[kMaxTile + 1];
 		int bufFrames = n + 1;
 		for (int i = 0; i < bufFrames * destChannels; ++i)
 			acc[i] = 0.0f;
-		for (int i = 0; i < bufFrames; ++i)
-			wgt[i] = 0.0;
+		if (!window) {
+			for (int i = 0; i < bufFrames; ++i)
+				wgt[i] = 0.0;
+		}
 
 		int64_t loFrame = a - 1;
 		int64_t hiFrame = a + n - 1;
@@ -208,18 +394,18 @@ namespace {
 			grainCount = kMaxGrains; // safety clamp; clamps on grain size keep this unreached
 
 		if (cfg.useWsola) {
-			// align each grain to the previous grain's *unadjusted* anchor. this deliberately
-			// does not chain grain-to-grain: a grain's offset is then a pure function of the
-			// source and its own index, so whichever block renders it computes the identical
-			// offset. that keeps the engine position-addressable (bit-exact regardless of how
-			// the caller splits the range) -- a recursive chain drifts with block phase instead
+			// a grain the table already knows costs a load instead of a search; one it doesn't
+			// is searched once and recorded for every later block (see AlignGrain)
+			double delta = WsolaDelta(cfg, p);
 			for (int gi = 0; gi < grainCount; ++gi) {
 				int64_t j = jStart + gi;
-				double cj = (double)j * cfg.hop;
-				double cjPrev = (double)(j - 1) * cfg.hop;
-				double anchorJ = GrainAnchor(cj, p);
-				double prevAnchor = GrainAnchor(cjPrev, p);
-				adjust[gi] = WsolaSearch(samples, numSamples, clipChannels, cj, cjPrev, anchorJ, prevAnchor, cfg, p);
+				int8_t candidate = alignment ? alignment->Get(j) : WarpAlignmentTable::kUnknown;
+				if (candidate == WarpAlignmentTable::kUnknown) {
+					candidate = AlignGrain(src, j, cfg, p);
+					if (alignment)
+						alignment->Set(j, candidate);
+				}
+				adjust[gi] = WsolaAdjust(candidate, delta);
 			}
 		} else if (cfg.useFluct) {
 			double maxJitter = cfg.hop * p.pitchRead * std::clamp(p.fluctuation, 0.0, 1.0);
@@ -230,41 +416,52 @@ namespace {
 				adjust[gi] = 0.0;
 		}
 
-		// lay down the grains
+		// lay down the grains. a grain covers the frames strictly inside its window's edges,
+		// where the window is nonzero
+		GrainKernel layGrain = GetGrainKernel();
+		float grainWindow[kMaxTile + 1];
 		for (int gi = 0; gi < grainCount; ++gi) {
-			int64_t j = jStart + gi;
-			double cj = (double)j * cfg.hop;
-			double anchor = GrainAnchor(cj, p) + adjust[gi];
-
-			int64_t kStart = std::max(loFrame, (int64_t)std::ceil(cj - cfg.halfLen));
-			int64_t kEnd = std::min(hiFrame, (int64_t)std::floor(cj + cfg.halfLen));
-			for (int64_t k = kStart; k <= kEnd; ++k) {
-				double local = (double)k - cj;
-				double w = GrainWindow(local, cfg.halfLen, cfg.rampLen);
-				if (w <= 0.0)
-					continue;
-				double srcPos = anchor + local * p.pitchRead;
-				int bi = (int)(k - loFrame);
-				for (int c = 0; c < destChannels; ++c) {
-					int sc = c % clipChannels;
-					acc[bi * destChannels + c] += (float)w * ReadSampleLinear(samples, numSamples, clipChannels, sc, srcPos);
+			int64_t cj = (jStart + gi) * cfg.hop;
+			double anchor = GrainAnchor((double)cj, p) + adjust[gi];
+
+			int64_t kStart = std::max(loFrame, cj - cfg.halfLen + 1);
+			int64_t kEnd = std::min(hiFrame, cj + cfg.halfLen - 1);
+			if (kStart > kEnd)
+				continue;
+			int count = (int)(kEnd - kStart + 1);
+			int64_t firstLocal = kStart - cj;
+			int bi = (int)(kStart - loFrame);
+
+			const float* w = nullptr;
+			if (window) {
+				w = window->GetWindow() + (firstLocal + cfg.halfLen);
+			} else {
+				// the values a table would hold, plus the weights a table's gains are made of
+				for (int i = 0; i < count; ++i) {
+					double value = GrainWindow((double)(firstLocal + i), cfg.halfLen, cfg.rampLen);
+					grainWindow[i] = (float)value;
+					wgt[bi + i] += value;
 				}
-				wgt[bi] += w;
+				w = grainWindow;
 			}
+			layGrain(src, w, anchor, firstLocal, p.pitchRead, count, destChannels, acc + bi * destChannels);
 		}
 
 		// normalize by the summed window so the plateau/overlap and clip edges stay unity gain
 		for (int bi = 0; bi < bufFrames; ++bi) {
-			if (wgt[bi] > 1e-6) {
-				double inv = 1.0 / wgt[bi];
-				for (int c = 0; c < destChannels; ++c)
-					acc[bi * destChannels + c] *= (float)inv;
-			}
+			float gain = 1.0f;
+			if (window)
+				gain = window->GetGain(loFrame + bi);
+			else if (wgt[bi] > 1e-6)
+				gain = (float)(1.0 / wgt[bi]);
+			for (int c = 0; c < destChannels; ++c)
+				acc[bi * destChannels + c] *= gain;
 		}
 
-		// ComplexPro: a one-zero tilt that counteracts the formant shift a pitch change causes
-		// (pitch up brightens/thins, so darken, and vice-versa). stateless: it reads the guard
-		// sample, never carrying state across blocks. crude but honest, not FFT formants
+		// ComplexPro without its vocoder: a one-zero tilt that counteracts the formant shift a
+		// pitch change causes (pitch up brightens/thins, so darken, and vice-versa). stateless:
+		// it reads the guard sample, never carrying state across blocks. crude, unlike the
+		// vocoder's cepstral envelope
 		double kco = 0.0;
 		if (cfg.useFormants && p.pitchRatio > 0.0) {
 			kco = std::clamp(0.4 * std::clamp(p.formants, 0.0, 1.0) * std::log2(p.pitchRatio), -0.9, 0.9);
@@ -284,26 +481,220 @@ namespace {
 		}
 	}
 
+	// the thread background alignment passes run on, one table at a time
+	class AlignmentWorker {
+	public:
+		static AlignmentWorker& Instance() {
+			static AlignmentWorker instance;
+			return instance;
+		}
+
+		~AlignmentWorker() {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mQuit = true;
+			}
+			mCondition.notify_all();
+			if (mThread.joinable())
+				mThread.join();
+		}
+
+		void Add(const std::shared_ptr<WarpAlignmentTable>& table, std::shared_ptr<const SampleData> data, const WarpRenderParams& params) {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mJobs.push_back({table, std::move(data), params});
+				if (!mThread.joinable())
+					mThread = std::thread(&AlignmentWorker::Run, this);
+			}
+			mCondition.notify_all();
+		}
+	private:
+		struct Job {
+			std::weak_ptr<WarpAlignmentTable> table;
+			std::shared_ptr<const SampleData> data;
+			WarpRenderParams params;
+		};
+
+		void Run() {
+			while (true) {
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mCondition.wait(lock, [this] { return mQuit || !mJobs.empty(); });
+					if (mQuit)
+						return;
+					job = std::move(mJobs.front());
+					mJobs.pop_front();
+				}
+				Fill(job);
+			}
+		}
+
+		void Fill(const Job& job) {
+			constexpr int kGrainsPerCheck = 64; // how often a pass checks it's still wanted
+			ModeConfig cfg = ResolveMode(job.params);
+			SourceSpan src{job.data->data, job.data->numSamples, job.data->channels, 0};
+			for (int64_t batch = 0;; ++batch) {
+				auto table = job.table.lock();
+				if (!table || mQuit)
+					return;
+				int64_t first = table->GetFirstGrain() + batch * kGrainsPerCheck;
+				int64_t last = std::min(first + kGrainsPerCheck, table->GetFirstGrain() + (int64_t)table->GetNumGrains());
+				if (first >= last)
+					return;
+				for (int64_t grain = first; grain < last; ++grain) {
+					if (table->Get(grain) == WarpAlignmentTable::kUnknown)
+						table->Set(grain, AlignGrain(src, grain, cfg, job.params));
+				}
+			}
+		}
+
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::deque<Job> mJobs;
+		bool mQuit = false;
+		std::thread mThread;
+	};
+
 } // namespace
 
-void RenderWarpedBlock(const float* samples, size_t numSamples, int clipChannels,
+WarpRenderParams MakeWarpParams(const AudioClip& clip, double sampleRate, double bpm) {
+	WarpRenderParams wp;
+	wp.mode = clip.GetWarpMode();
+	wp.sampleRate = sampleRate;
+	wp.speed = clip.ComputeTimeStretchRate(sampleRate, bpm);
+	wp.pitchRead = clip.ComputePitchReadRate(sampleRate);
+	double totalSemis = clip.GetTransposeSemitones() + clip.GetTransposeCents() / 100.0;
+	wp.pitchRatio = std::pow(2.0, totalSemis / 12.0);
+	double offsetSeconds = clip.GetOffset() * (60.0 / bpm);
+	wp.offsetOutputFrames = offsetSeconds * sampleRate;
+	wp.grainSizeMs = clip.GetGrainSizeMs();
+	wp.fluctuation = clip.GetFluctuation();
+	wp.transientEnvelope = clip.GetTransientEnvelope();
+	wp.formants = clip.GetFormants();
+	return wp;
+}
+
+WarpWindowTable::WarpWindowTable(const WarpRenderParams& params) {
+	ModeConfig cfg = ResolveMode(params);
+	mHop = cfg.hop;
+	mHalfLen = cfg.halfLen;
+	mRampLen = cfg.rampLen;
+
+	mWindow.resize((size_t)(2 * mHalfLen + 1));
+	for (int64_t local = -mHalfLen; local <= mHalfLen; ++local)
+		mWindow[(size_t)(local + mHalfLen)] = (float)GrainWindow((double)local, (double)mHalfLen, (double)mRampLen);
+
+	// grain centers are multiples of the hop, so the windows overlapping a frame -- and their
+	// sum -- repeat every hop. summed in grain order, as RenderTile sums them without a table
+	mGains.resize((size_t)mHop);
+	for (int64_t phase = 0; phase < mHop; ++phase) {
+		double sum = 0.0;
+		for (int64_t j = (phase - mHalfLen) / mHop - 1; j * mHop < phase + mHalfLen; ++j) {
+			int64_t local = phase - j * mHop;
+			if (local > -mHalfLen && local < mHalfLen)
+				sum += GrainWindow((double)local, (double)mHalfLen, (double)mRampLen);
+		}
+		mGains[(size_t)phase] = sum > 1e-6 ? (float)(1.0 / sum) : 1.0f;
+	}
+}
+
+bool WarpWindowTable::Matches(const WarpRenderParams& params) const {
+	ModeConfig cfg = ResolveMode(params);
+	return cfg.hop == mHop && cfg.halfLen == mHalfLen && cfg.rampLen == mRampLen;
+}
+
+WarpAlignmentTable::WarpAlignmentTable(const WarpRenderParams& params, uint64_t numSourceFrames) : mParams(params) {
+	ModeConfig cfg = ResolveMode(params);
+	if (!cfg.useWsola || params.speed <= 0.0)
+		return;
+
+	// from the grains reaching the clip's first output frame (and its guard frame) to the
+	// last one whose anchor still lands in the source
+	double lastCenter = (double)numSourceFrames / params.speed - params.offsetOutputFrames;
+	mFirstGrain = (int64_t)std::floor((-1.0 - cfg.halfLen) / cfg.hop);
+	int64_t lastGrain = (int64_t)std::ceil((lastCenter + cfg.halfLen) / cfg.hop) + 1;
+	if (lastGrain < mFirstGrain)
+		return;
+	mNumGrains = std::min((size_t)(lastGrain - mFirstGrain + 1), kMaxAlignmentGrains);
+	mCandidates = std::make_unique<std::atomic<int8_t>[]>(mNumGrains);
+	for (size_t i = 0; i < mNumGrains; ++i)
+		mCandidates[i].store(kUnknown, std::memory_order_relaxed);
+}
+
+bool WarpAlignmentTable::Matches(const WarpRenderParams& params) const {
+	return params.mode == mParams.mode && params.sampleRate == mParams.sampleRate &&
+		   params.speed == mParams.speed && params.pitchRead == mParams.pitchRead &&
+		   params.offsetOutputFrames == mParams.offsetOutputFrames && params.grainSizeMs == mParams.grainSizeMs;
+}
+
+int8_t WarpAlignmentTable::Get(int64_t grain) const {
+	uint64_t i = (uint64_t)(grain - mFirstGrain);
+	if (i >= mNumGrains)
+		return kUnknown;
+	return mCandidates[i].load(std::memory_order_relaxed);
+}
+
+void WarpAlignmentTable::Set(int64_t grain, int8_t candidate) {
+	uint64_t i = (uint64_t)(grain - mFirstGrain);
+	if (i < mNumGrains)
+		mCandidates[i].store(candidate, std::memory_order_relaxed);
+}
+
+void WarpAlignmentTable::FillInBackground(const std::shared_ptr<WarpAlignmentTable>& table, std::shared_ptr<const SampleData> data) {
+	if (!table || table->mNumGrains == 0 || !data || !data->data)
+		return;
+	AlignmentWorker::Instance().Add(table, std::move(data), table->mParams);
+}
+
+void RenderWarpedBlock(const float* samples, size_t numSamples, int clipChannels, int64_t firstFrame,
 					   int64_t outStartFrame, int count, int destChannels,
-					   float* dest, const WarpRenderParams& params) {
+					   float* dest, const WarpRenderParams& params, WarpAlignmentTable* alignment,
+					   const WarpWindowTable* window, WarpVocoder* vocoder) {
 	if (!samples || numSamples == 0 || clipChannels <= 0 || count <= 0 || destChannels <= 0)
 		return;
 	if (destChannels > 2)
 		destChannels = 2; // engine scratch is sized for stereo, which is all the DAW mixes
+	if (vocoder && vocoder->Matches(params)) {
+		vocoder->Render(samples, numSamples, clipChannels, firstFrame, outStartFrame, count, destChannels, dest);
+		return;
+	}
 
 	ModeConfig cfg = ResolveMode(params);
-	if (cfg.grainOut <= 0.0 || cfg.hop <= 0.0)
-		return;
+	SourceSpan src{samples, numSamples, clipChannels, firstFrame};
+	if (alignment && !alignment->Matches(params))
+		alignment = nullptr; // made for other params (a tempo ramp, a knob mid-drag): search live
+	if (window && !window->Matches(params))
+		window = nullptr; // likewise, evaluate the window per grain
 
 	// tile the request so scratch stays bounded; each tile is independent and deterministic
 	int done = 0;
 	while (done < count) {
 		int n = std::min(kMaxTile, count - done);
-		RenderTile(samples, numSamples, clipChannels, outStartFrame + done, n, destChannels,
-				   dest + done * destChannels, params, cfg);
+		RenderTile(src, outStartFrame + done, n, destChannels,
+				   dest + done * destChannels, params, cfg, alignment, window);
 		done += n;
 	}
 }
+
+void SetWarpScalarKernelOnly(bool scalarOnly) {
+	sScalarKernelOnly.store(scalarOnly, std::memory_order_relaxed);
+}
+
+void GetWarpedSourceSpan(int64_t outStartFrame, int count, const WarpRenderParams& params,
+						 int64_t& firstFrame, int64_t& endFrame, const WarpVocoder* vocoder) {
+	if (vocoder && vocoder->Matches(params)) {
+		vocoder->GetSourceSpan(outStartFrame, count, firstFrame, endFrame);
+		return;
+	}
+	ModeConfig cfg = ResolveMode(params);
+
+	// grain centers touching the block (plus the guard frame), widened by one hop for the
+	// predecessor WSOLA compares against. a grain reads half a grain either side of its
+	// anchor, shifted by at most a hop of WSOLA or fluctuation offset
+	double cLo = (double)(outStartFrame - 1) - cfg.halfLen - 2.0 * cfg.hop;
+	double cHi = (double)(outStartFrame + count) + cfg.halfLen + cfg.hop;
+	double reach = (cfg.halfLen + cfg.hop) * params.pitchRead + 2.0;
+	firstFrame = (int64_t)std::floor(GrainAnchor(cLo, params) - reach);
+	endFrame = (int64_t)std::ceil(GrainAnchor(cHi, params) + reach) + 1;
+}
@@ -1,7 +1,12 @@
 #pragma once
 #include "AudioClip.h" // for WarpMode
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
+
+class WarpVocoder;
 
 // position-addressable granular time-stretch / pitch-shift for warped audio clips.
 // it decouples time (governed by `speed`) from pitch (governed by `pitchRead`) so a clip
@@ -14,31 +19,113 @@
 // the same graph from transport position alone -- and it means the audio thread never
 // allocates (all scratch is fixed-size and stack-local).
 //
-// honest scope: this is a time-domain granular approximation, not a phase vocoder. the
-// modes differ by grain size / overlap / windowing plus a deterministic WSOLA-style align
-// on the tonal modes (each grain aligns to its predecessor's unadjusted position, so the
-// align stays position-addressable rather than drifting with block phase). Complex/ComplexPro
-// are the smoothest tier, not a spectral engine; ComplexPro's formant control is a cheap
-// spectral tilt, not true FFT formant preservation.
+// Beats/Tones/Texture are time-domain granular: the modes differ by grain size / overlap /
+// windowing plus a deterministic WSOLA-style align on Tones (each grain aligns to its
+// predecessor's unadjusted position, so the align stays position-addressable rather than
+// drifting with block phase). Complex/ComplexPro run a phase vocoder (see WarpVocoder) when the
+// caller passes one; without it they fall back to the granular path with WSOLA, and
+// ComplexPro's formant control to a one-zero spectral tilt.
 
 struct WarpRenderParams {
 	WarpMode mode = WarpMode::Beats;
 	double sampleRate = 48000.0;	 // output/device rate, turns grain milliseconds into frames
 	double speed = 1.0;				 // Rsr*Rwarp: source frames the grain anchor advances per output frame
 	double pitchRead = 1.0;			 // Rsr*Rpitch: source frames read per output frame inside a grain
-	double pitchRatio = 1.0;		 // Rpitch alone: the musical pitch shift, used only for formant tilt
+	double pitchRatio = 1.0;		 // Rpitch alone: the musical pitch shift, used only for formants
 	double offsetOutputFrames = 0.0; // clip file offset, expressed in output frames
 
 	// per-mode knobs, already clamped by the caller
 	double grainSizeMs = 80.0;		// Tones/Texture/Complex/ComplexPro grain length
 	double fluctuation = 0.0;		// Texture only, 0..1 deterministic per-grain source jitter
 	double transientEnvelope = 0.5; // Beats only, 0..1 grain fade shaping (0 keeps transients sharp)
-	double formants = 1.0;			// ComplexPro only, 0..1 approximate formant compensation strength
+	double formants = 1.0;			// ComplexPro only, 0..1 formant compensation strength
+};
+
+// the params a clip renders with at this device rate and tempo. offsetOutputFrames is the
+// clip's file offset as Track::Process derives it, so a table keyed on these matches exactly
+WarpRenderParams MakeWarpParams(const AudioClip& clip, double sampleRate, double bpm);
+
+// the tonal modes' WSOLA alignment, memoized for one clip under one set of params. a grain's
+// alignment is a pure function of the source, its index and the params (see RenderTile), so
+// it's searched for once -- by the first block that needs it, or ahead of time by a background
+// pass over a decoded file -- and every later block looks it up. entries are atomic bytes (the
+// winning candidate), so the audio thread and the background pass can both write one: they
+// store the same value
+class WarpAlignmentTable {
+public:
+	static constexpr int8_t kUnknown = -1;
+
+	// covers every grain that reads the source's numSourceFrames frames under `params`
+	WarpAlignmentTable(const WarpRenderParams& params, uint64_t numSourceFrames);
+
+	// true if the table was made for these params, comparing only what the alignment depends on
+	bool Matches(const WarpRenderParams& params) const;
+
+	int8_t Get(int64_t grain) const; // kUnknown when not searched yet, or outside the table
+	void Set(int64_t grain, int8_t candidate);
+	int64_t GetFirstGrain() const { return mFirstGrain; }
+	size_t GetNumGrains() const { return mNumGrains; }
+
+	// searches every grain of `data` not known yet, on a shared worker thread. the pass is
+	// dropped once nothing else holds the table (the clip's params moved on)
+	static void FillInBackground(const std::shared_ptr<WarpAlignmentTable>& table, std::shared_ptr<const SampleData> data);
+private:
+	WarpRenderParams mParams;
+	int64_t mFirstGrain = 0;
+	size_t mNumGrains = 0;
+	std::unique_ptr<std::atomic<int8_t>[]> mCandidates;
+};
+
+// a granular mode's grain window sampled at every frame offset from a grain's center, and the
+// gain that brings the overlapping windows back to unity at each frame. both follow from the
+// mode's grain geometry alone, so a clip computes them once, off the audio thread, instead of
+// every grain evaluating a cosine per frame
+class WarpWindowTable {
+public:
+	explicit WarpWindowTable(const WarpRenderParams& params);
+
+	// true if `params` resolve to the same grain geometry
+	bool Matches(const WarpRenderParams& params) const;
+
+	// indexed by halfLen + offset from the grain's center
+	const float* GetWindow() const { return mWindow.data(); }
+
+	// the normalizing gain at an output frame; it repeats every hop
+	float GetGain(int64_t frame) const {
+		int64_t phase = frame % mHop;
+		return mGains[(size_t)(phase < 0 ? phase + mHop : phase)];
+	}
+private:
+	int64_t mHop = 1;
+	int64_t mHalfLen = 0;
+	int64_t mRampLen = 0;
+	std::vector<float> mWindow;
+	std::vector<float> mGains; // by frame mod hop
 };
 
 // mixes `count` output frames into `dest` (interleaved, destChannels wide) for the clip
 // segment starting at absolute output frame `outStartFrame` (frames since clip content
 // start). adds into dest like the existing reader's `+=`, so callers zero/own the buffer.
-void RenderWarpedBlock(const float* samples, size_t numSamples, int clipChannels,
+// `samples` holds source frames from `firstFrame` on: 0 for a decoded file, or wherever the
+// span a streamed clip gathered for this block begins.
+// `alignment`, if it matches the params, supplies and records the tonal modes' grain
+// alignment. only pass it with the whole file in `samples`: a streamed span can be missing
+// chunks, and a search over that silence must not be remembered.
+// `window`, if it matches the params, spares the per-grain window evaluation; the output is
+// bit-identical either way.
+// `vocoder`, if it matches the params, renders Complex/ComplexPro instead of the grains
+void RenderWarpedBlock(const float* samples, size_t numSamples, int clipChannels, int64_t firstFrame,
 					   int64_t outStartFrame, int count, int destChannels,
-					   float* dest, const WarpRenderParams& params);
+					   float* dest, const WarpRenderParams& params,
+					   WarpAlignmentTable* alignment = nullptr, const WarpWindowTable* window = nullptr,
+					   WarpVocoder* vocoder = nullptr);
+
+// lays every grain down with the scalar kernel instead of the fastest one the cpu runs. the
+// output is the same bit for bit; benchmarks flip it to measure the vector kernel. not while
+// audio is running
+void SetWarpScalarKernelOnly(bool scalarOnly);
+
+// the source frames [firstFrame, endFrame) RenderWarpedBlock can touch for the same block,
+// so a streamed clip knows what to gather. pass the same vocoder the render will get
+void GetWarpedSourceSpan(int64_t outStartFrame, int count, const WarpRenderParams& params,
+						 int64_t& firstFrame, int64_t& endFrame, const WarpVocoder* vocoder = nullptr);
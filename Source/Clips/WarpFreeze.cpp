@@ -0,0 +1,310 @@
+#include "PrecompHeader.h"
+#include "WarpFreeze.h"
+#include "WarpVocoder.h"
+#include "AppConfig.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+	// how long a clip's params must hold still before its render starts
+	constexpr auto kSettleTime = std::chrono::milliseconds(1500);
+
+	// output frames the worker renders at a time, and checks it's still wanted between
+	constexpr int kBlockFrames = 4096;
+
+	// bytes of frozen output held in memory, across every freeze
+	std::atomic<uint64_t> sResidentBytes{0};
+
+	// the worker only soaks up idle time, so it never competes with the ui or a render worker.
+	// best effort, as with the render workers' promotion
+	void LowerThreadPriority() {
+#ifdef _WIN32
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(SCHED_IDLE)
+		sched_param param{};
+		pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+	}
+
+	// a fresh scratch file name, under the system temp directory
+	std::filesystem::path MakeSpillPath() {
+		static std::atomic<uint32_t> counter{0};
+		static const uint32_t session = std::random_device{}();
+		std::error_code ec;
+		std::filesystem::path dir = std::filesystem::temp_directory_path(ec) / "MSDAW";
+		std::filesystem::create_directories(dir, ec);
+		char name[48];
+		snprintf(name, sizeof(name), "freeze-%08x-%u.raw", session, counter.fetch_add(1));
+		return dir / name;
+	}
+} // namespace
+
+// the thread freezes render on, one at a time and oldest first. a job waits out the settle
+// time, so a freeze replaced in the meantime is dropped before it costs anything
+class WarpFreeze::Worker {
+public:
+	static Worker& Instance() {
+		static Worker instance;
+		return instance;
+	}
+
+	~Worker() {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mCondition.notify_all();
+		if (mThread.joinable())
+			mThread.join();
+	}
+
+	struct Job {
+		std::weak_ptr<WarpFreeze> freeze;
+		std::shared_ptr<const SampleData> data;
+		std::shared_ptr<SampleStream> stream;
+		int clipChannels = 2;
+		std::shared_ptr<WarpAlignmentTable> alignment;
+		std::shared_ptr<const WarpWindowTable> window;
+		uint64_t budgetBytes = 0;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	void Add(Job job) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mJobs.push_back(std::move(job));
+			if (!mThread.joinable())
+				mThread = std::thread(&Worker::Run, this);
+		}
+		mCondition.notify_all();
+	}
+private:
+	void Run() {
+		LowerThreadPriority();
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mCondition.wait(lock, [this] { return mQuit || !mJobs.empty(); });
+				if (mQuit)
+					return;
+				if (mJobs.front().freeze.expired()) {
+					mJobs.pop_front();
+					continue;
+				}
+				auto start = mJobs.front().start;
+				if (mCondition.wait_until(lock, start, [this] { return mQuit.load(); }))
+					return;
+				job = std::move(mJobs.front());
+				mJobs.pop_front();
+			}
+			Fill(job);
+		}
+	}
+
+	void Fill(const Job& job) {
+		auto freeze = job.freeze.lock();
+		if (!freeze)
+			return;
+		const WarpRenderParams params = freeze->mParams;
+		const int64_t numFrames = freeze->mNumFrames;
+		const uint64_t bytes = (uint64_t)numFrames * kChannels * sizeof(float);
+
+		// in memory while the budget has room, else straight to a scratch file as raw floats
+		bool resident = sResidentBytes.fetch_add(bytes) + bytes <= job.budgetBytes;
+		std::filesystem::path spillPath;
+		std::ofstream spill;
+		std::vector<float> block;
+		if (resident) {
+			freeze->mResident.assign((size_t)numFrames * kChannels, 0.0f);
+		} else {
+			sResidentBytes.fetch_sub(bytes);
+			spillPath = MakeSpillPath();
+			spill.open(spillPath, std::ios::binary | std::ios::trunc);
+			if (!spill.is_open())
+				return; // no scratch space: the clip keeps rendering live
+			block.resize((size_t)kBlockFrames * kChannels);
+		}
+		freeze.reset(); // from here only a block at a time holds it, so a replaced freeze goes away
+
+		auto abandon = [&]() {
+			if (spill.is_open()) {
+				spill.close();
+				std::error_code ec;
+				std::filesystem::remove(spillPath, ec);
+			}
+		};
+
+		// the source as the audio thread reads it: decoded data whole, or a stream span by span,
+		// here through a stream of the worker's own read straight from disk
+		std::shared_ptr<SampleStream> stream = job.data ? nullptr : job.stream->ReopenDirect();
+		std::unique_ptr<WarpVocoder> vocoder;
+		if (params.mode == WarpMode::Complex || params.mode == WarpMode::ComplexPro)
+			vocoder = std::make_unique<WarpVocoder>(params, job.clipChannels);
+
+		for (int64_t done = 0; done < numFrames; done += kBlockFrames) {
+			freeze = job.freeze.lock();
+			if (!freeze || mQuit) {
+				abandon(); // a resident freeze that's gone gave its bytes back
+				return;
+			}
+			int count = (int)std::min<int64_t>(kBlockFrames, numFrames - done);
+			float* dest = block.data();
+			if (resident)
+				dest = freeze->mResident.data() + done * kChannels;
+			else
+				std::fill(block.begin(), block.end(), 0.0f);
+
+			if (job.data) {
+				RenderWarpedBlock(job.data->data, job.data->numSamples, job.clipChannels, 0, done, count, kChannels, dest,
+								  params, job.alignment.get(), job.window.get(), vocoder.get());
+			} else {
+				int64_t firstFrame = 0, endFrame = 0;
+				GetWarpedSourceSpan(done, count, params, firstFrame, endFrame, vocoder.get());
+				endFrame = std::min(endFrame, firstFrame + SampleStream::kScratchFrames);
+				float* scratch = stream->GetScratch();
+				if (!stream->ReadDirect(firstFrame, endFrame - firstFrame, scratch)) {
+					freeze->Release(); // the file can't be read back: the clip keeps rendering live
+					abandon();
+					return;
+				}
+				RenderWarpedBlock(scratch, (size_t)(endFrame - firstFrame) * job.clipChannels, job.clipChannels, firstFrame,
+								  done, count, kChannels, dest, params, nullptr, job.window.get(), vocoder.get());
+			}
+
+			if (!resident)
+				spill.write(reinterpret_cast<const char*>(block.data()), (std::streamsize)count * kChannels * sizeof(float));
+			freeze.reset();
+		}
+
+		freeze = job.freeze.lock();
+		if (!freeze || mQuit) {
+			abandon();
+			return;
+		}
+		if (!resident) {
+			spill.close();
+			if (spill.fail()) { // out of disk space: the clip keeps rendering live
+				std::error_code ec;
+				std::filesystem::remove(spillPath, ec);
+				return;
+			}
+			// laid out as the streams expect a float wav's data chunk, from the first byte
+			WavInfo& info = freeze->mSpillInfo;
+			info.channels = kChannels;
+			info.sampleRate = params.sampleRate;
+			info.formatType = 3;
+			info.bitsPerSample = 32;
+			info.dataOffset = 0;
+			info.dataBytes = bytes;
+			info.numFrames = (uint64_t)numFrames;
+			freeze->mSpillPath = spillPath.string();
+		}
+		freeze->mReady.store(true, std::memory_order_release);
+	}
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<Job> mJobs;
+	std::atomic<bool> mQuit{false};
+	std::thread mThread;
+};
+
+WarpFreeze::WarpFreeze(const WarpRenderParams& params, int64_t numFrames)
+	: mParams(params), mNumFrames(std::max<int64_t>(0, numFrames)) {
+}
+
+WarpFreeze::~WarpFreeze() {
+	Release();
+	// the streams reading it hold the freeze, so by now they have all closed it
+	if (!mSpillPath.empty()) {
+		std::error_code ec;
+		std::filesystem::remove(mSpillPath, ec);
+	}
+}
+
+void WarpFreeze::Release() {
+	if (!mResident.empty())
+		sResidentBytes.fetch_sub((uint64_t)mResident.size() * sizeof(float));
+	mResident = std::vector<float>();
+}
+
+bool WarpFreeze::Matches(const WarpRenderParams& params) const {
+	const WarpRenderParams& p = mParams;
+	return params.mode == p.mode && params.sampleRate == p.sampleRate && params.speed == p.speed &&
+		   params.pitchRead == p.pitchRead && params.pitchRatio == p.pitchRatio &&
+		   params.offsetOutputFrames == p.offsetOutputFrames && params.grainSizeMs == p.grainSizeMs &&
+		   params.fluctuation == p.fluctuation && params.transientEnvelope == p.transientEnvelope &&
+		   params.formants == p.formants;
+}
+
+std::shared_ptr<SampleStream> WarpFreeze::OpenSpill() const {
+	if (!IsSpilled())
+		return nullptr;
+	auto stream = SampleStream::Open(mSpillPath, mSpillInfo, shared_from_this());
+	stream->Cue(0);
+	return stream;
+}
+
+bool WarpFreeze::Mix(const WarpRenderParams& params, SampleStream* spill, int64_t outStartFrame, int count,
+					 int destChannels, float* dest) const {
+	if (!IsReady() || destChannels != kChannels || count <= 0 || outStartFrame < 0 || outStartFrame + count > mNumFrames)
+		return false;
+	if (!Matches(params))
+		return false;
+	const float* src = mResident.data() + outStartFrame * kChannels;
+	if (!mSpillPath.empty()) {
+		// out of the ring, which the cue keeps filled ahead. a block it doesn't hold yet (just
+		// after a seek) renders live instead of playing silence
+		if (!spill || count > SampleStream::kScratchFrames)
+			return false;
+		spill->Cue(outStartFrame);
+		if (!spill->Read(outStartFrame, count, spill->GetScratch()))
+			return false;
+		src = spill->GetScratch();
+	}
+	for (int i = 0; i < count * kChannels; ++i)
+		dest[i] += src[i];
+	return true;
+}
+
+void WarpFreeze::RenderInBackground(const std::shared_ptr<WarpFreeze>& freeze, std::shared_ptr<const SampleData> data,
+									const std::shared_ptr<SampleStream>& stream, int clipChannels,
+									std::shared_ptr<WarpAlignmentTable> alignment,
+									std::shared_ptr<const WarpWindowTable> window) {
+	if (!freeze || freeze->mNumFrames == 0 || clipChannels <= 0)
+		return;
+	if (data && !data->data)
+		data.reset(); // mapped integer pcm plays through its stream
+	if (!data && !stream)
+		return;
+
+	Worker::Job job;
+	job.freeze = freeze;
+	job.data = std::move(data);
+	job.stream = stream;
+	job.clipChannels = clipChannels;
+	// the alignment table may only be used over a whole decoded file, as on the audio thread
+	job.alignment = job.data ? std::move(alignment) : nullptr;
+	job.window = std::move(window);
+	job.budgetBytes = (uint64_t)std::max(0, AppConfig::Instance().warpFreezeMemoryMB) * 1024 * 1024;
+	job.start = std::chrono::steady_clock::now() + kSettleTime;
+	Worker::Instance().Add(std::move(job));
+}
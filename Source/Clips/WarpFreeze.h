@@ -0,0 +1,74 @@
+#pragma once
+#include "WarpEngine.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// a warped clip's output rendered ahead of time, so playback is a copy instead of a resynthesis.
+// made on the ui thread for one set of params and filled by a low-priority worker once those
+// have held still for a moment (a knob mid-drag or a tempo ramp is never rendered), then never
+// written again. the audio thread mixes it in while it's ready and still matches the clip, and
+// renders live otherwise: before it's done, past its end, or in the blocks after an edit.
+//
+// the worker renders through the engine itself, so the granular modes come out bit for bit as
+// they would live. Complex/ComplexPro come out as if played from the clip start, through a
+// vocoder of the worker's own: after a seek or loop wrap into the clip, live playback differs
+// from that until the next transient (see WarpVocoder), so freezing one changes what those
+// stretches sound like.
+//
+// freezes share a memory budget (AppConfig::warpFreezeMemoryMB). one that doesn't fit is written
+// to a scratch file as it's rendered, and each clip playing it streams it back like a long file
+// (see SampleStream): the disk thread keeps a ring ahead of the play position, so the audio
+// thread only ever copies resident memory, and renders live for a block the ring doesn't hold yet
+class WarpFreeze : public std::enable_shared_from_this<WarpFreeze> {
+public:
+	static constexpr int kChannels = 2;				// rendered as the graph mixes: stereo
+	static constexpr double kMaxSeconds = 20.0 * 60.0; // longer clips always render live
+
+	WarpFreeze(const WarpRenderParams& params, int64_t numFrames);
+	~WarpFreeze();
+
+	WarpFreeze(const WarpFreeze&) = delete;
+	WarpFreeze& operator=(const WarpFreeze&) = delete;
+
+	// true if the freeze was made for exactly these params
+	bool Matches(const WarpRenderParams& params) const;
+	int64_t GetNumFrames() const { return mNumFrames; }
+	bool IsReady() const { return mReady.load(std::memory_order_acquire); }
+	bool IsSpilled() const { return IsReady() && !mSpillPath.empty(); }
+
+	// ui thread: a stream of the scratch file for one clip to play a spilled freeze through, cued
+	// to the start. it keeps the freeze (and so the file) alive. null unless IsSpilled()
+	std::shared_ptr<SampleStream> OpenSpill() const;
+
+	// audio thread: adds output frames [outStartFrame, outStartFrame + count) to dest. false, and
+	// dest untouched, unless the freeze is ready, was made for `params` and covers the frames, and
+	// if spilled, `spill` (from OpenSpill) has them resident
+	bool Mix(const WarpRenderParams& params, SampleStream* spill, int64_t outStartFrame, int count, int destChannels,
+			 float* dest) const;
+
+	// ui thread: queues the render. the source is the clip's decoded data, or else its stream,
+	// which the worker reopens to read straight from disk on its own. the tables are the clip's, shared as the
+	// audio thread shares them. dropped unrendered once nothing else holds the freeze
+	static void RenderInBackground(const std::shared_ptr<WarpFreeze>& freeze, std::shared_ptr<const SampleData> data,
+								   const std::shared_ptr<SampleStream>& stream, int clipChannels,
+								   std::shared_ptr<WarpAlignmentTable> alignment,
+								   std::shared_ptr<const WarpWindowTable> window);
+private:
+	class Worker;
+
+	// frees the frames and gives their bytes back to the budget. never once ready
+	void Release();
+
+	WarpRenderParams mParams;
+	int64_t mNumFrames = 0;
+
+	// interleaved, kChannels wide: in memory, or else in the scratch file. written by the worker
+	// before mReady
+	std::vector<float> mResident;
+	std::string mSpillPath;
+	WavInfo mSpillInfo;
+	std::atomic<bool> mReady{false};
+};
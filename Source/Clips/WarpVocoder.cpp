@@ -0,0 +1,603 @@
+#include "PrecompHeader.h"
+#include "WarpVocoder.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VOCODER_SSE2 1
+#endif
+
+namespace {
+
+	constexpr double kPi = 3.14159265358979323846;
+
+	// frames cached. a render pass covers at most a hop of output, which five frames overlap
+	// under four-fold overlap, so eight also keeps the previous pass's frames resident
+	constexpr int kSlots = 8;
+
+	// a frame whose spectrum is more than this share new against the reference's is an
+	// onset; the first frame of one restarts the phases, so the attack keeps its shape
+	constexpr float kOnsetThreshold = 0.3f;
+
+	// the formant correction's limit either way, in nepers (~26 dB)
+	constexpr double kMaxFormantGain = 3.0;
+
+	// the formant envelope's spectrum is averaged down this many times first
+	constexpr int kEnvelopeDecimation = 4;
+
+	// the power of two nearest the grain size, in [1024, 8192]
+	int GetFrameSize(const WarpRenderParams& p) {
+		double sr = (p.sampleRate > 0.0) ? p.sampleRate : 48000.0;
+		double frames = std::clamp(p.grainSizeMs, 40.0, 200.0) * 0.001 * sr;
+		return 1 << std::clamp((int)std::lround(std::log2(frames)), 10, 13);
+	}
+
+	inline int64_t FloorDiv(int64_t a, int64_t b) {
+		int64_t q = a / b;
+		return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+	}
+
+	// each peak's turn over a hop, e^(i (arg(q) advance + p pi / 2)) for its deviation q, in place:
+	// q in re/im in, the turn out. count is a multiple of four. the angle is good to a few 1e-6
+	// rad times the advance, well under what a frame's rounding moves a phase by
+	void GetPeakTurns(const int* peaks, int count, float advance, float* re, float* im) {
+		const float halfPi = 1.57079637f;
+#ifdef VOCODER_SSE2
+		const __m128 sign = _mm_set1_ps(-0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 vHalfPi = _mm_set1_ps(halfPi);
+		const __m128 vPi = _mm_set1_ps(2.0f * halfPi);
+		const __m128 vAdvance = _mm_set1_ps(advance);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		auto select = [](__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+		for (int n = 0; n < count; n += 4) {
+			// atan2: a polynomial over the octant, then reflected out to the quadrant
+			__m128 x = _mm_loadu_ps(re + n), y = _mm_loadu_ps(im + n);
+			__m128 ax = _mm_andnot_ps(sign, x), ay = _mm_andnot_ps(sign, y);
+			__m128 hi = _mm_max_ps(ax, ay);
+			__m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(ax, ay), hi), _mm_cmpgt_ps(hi, zero));
+			__m128 a2 = _mm_mul_ps(a, a);
+			__m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.01172120f), a2), _mm_set1_ps(0.05265332f));
+			r = _mm_add_ps(_mm_mul_ps(r, a2), _mm_set1_ps(-0.11643287f));
+			r = _mm_add_ps(_mm_mul_ps(r, a2), _mm_set1_ps(0.19354346f));
+			r = _mm_add_ps(_mm_mul_ps(r, a2), _mm_set1_ps(-0.33262347f));
+			r = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(r, a2), _mm_set1_ps(0.99997726f)), a);
+			r = select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(vHalfPi, r), r);
+			r = select(_mm_cmplt_ps(x, zero), _mm_sub_ps(vPi, r), r);
+			r = _mm_xor_ps(r, _mm_and_ps(_mm_cmplt_ps(y, zero), sign));
+
+			// sine and cosine: the nearest quarter turn off (|t| stays under 8 pi, so the offset
+			// keeps truncation a floor), taylor series over the rest, then the quarters put back
+			__m128 t = _mm_mul_ps(r, vAdvance);
+			__m128i quadrant = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(1.0f / halfPi)), _mm_set1_ps(64.5f))), _mm_set1_epi32(64));
+			__m128 rest = _mm_sub_ps(t, _mm_mul_ps(_mm_cvtepi32_ps(quadrant), vHalfPi));
+			__m128 r2 = _mm_mul_ps(rest, rest);
+			__m128 sp = _mm_sub_ps(_mm_set1_ps(0.00833333333f), _mm_mul_ps(r2, _mm_set1_ps(0.000198412698f)));
+			sp = _mm_add_ps(_mm_set1_ps(-0.166666667f), _mm_mul_ps(r2, sp));
+			__m128 sn = _mm_add_ps(rest, _mm_mul_ps(_mm_mul_ps(rest, r2), sp));
+			__m128 cp = _mm_add_ps(_mm_set1_ps(-0.00138888889f), _mm_mul_ps(r2, _mm_set1_ps(0.0000248015873f)));
+			cp = _mm_add_ps(_mm_set1_ps(0.0416666667f), _mm_mul_ps(r2, cp));
+			cp = _mm_add_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(r2, cp));
+			__m128 cs = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, cp));
+			__m128i q = _mm_add_epi32(quadrant, _mm_loadu_si128((const __m128i*)(peaks + n)));
+			__m128 odd = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+			__m128 negSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+			__m128 negCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+			_mm_storeu_ps(re + n, _mm_xor_ps(select(odd, sn, cs), negCos));
+			_mm_storeu_ps(im + n, _mm_xor_ps(select(odd, cs, sn), negSin));
+		}
+#else
+		for (int n = 0; n < count; ++n) {
+			float t = std::atan2(im[n], re[n]) * advance + halfPi * (float)(peaks[n] & 3);
+			re[n] = std::cos(t);
+			im[n] = std::sin(t);
+		}
+#endif
+	}
+
+	// e^x in place, for x within a few nepers either way: 2^(x / ln 2) split at the nearest
+	// integer, which goes straight into the exponent, with a series over the rest (to ~1e-7)
+	void ExpInPlace(float* x, int count) {
+		int n = 0;
+#ifdef VOCODER_SSE2
+		const __m128 log2e = _mm_set1_ps(1.44269504f);
+		for (; n + 4 <= count; n += 4) {
+			__m128 y = _mm_mul_ps(_mm_loadu_ps(x + n), log2e);
+			__m128i whole = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(y, _mm_set1_ps(64.5f))), _mm_set1_epi32(64));
+			__m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(whole));
+			__m128 p = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(0.000154035304f)), _mm_set1_ps(0.00133335581f));
+			p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(0.00961812911f));
+			p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(0.0555041087f));
+			p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(0.240226507f));
+			p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(0.693147181f));
+			p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(1.0f));
+			_mm_storeu_ps(x + n, _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(whole, 23))));
+		}
+#endif
+		for (; n < count; ++n)
+			x[n] = std::exp(x[n]);
+	}
+
+	// a smoothed log spectrum at a fractional point, held flat past its end
+	inline float SampleEnvelope(const float* envelope, int last, float at) {
+		if (at >= (float)last)
+			return envelope[last];
+		int i = (int)at;
+		return envelope[i] + (at - (float)i) * (envelope[i + 1] - envelope[i]);
+	}
+
+	// the granular engine's read: one channel at a fractional frame of the span, linear
+	// interpolated, silence outside it
+	inline float ReadLinear(const float* samples, size_t numSamples, int channels, int channel, double pos) {
+		if (pos < 0.0)
+			return 0.0f;
+		int64_t i = (int64_t)pos;
+		float frac = (float)(pos - (double)i);
+		size_t idx1 = (size_t)(i * channels + channel);
+		size_t idx2 = idx1 + (size_t)channels;
+		if (idx2 >= numSamples)
+			return 0.0f;
+		return samples[idx1] + frac * (samples[idx2] - samples[idx1]);
+	}
+
+} // namespace
+
+WarpVocoder::WarpVocoder(const WarpRenderParams& params, int clipChannels)
+	: mParams(params), mFFT(GetFrameSize(params)), mEnvelopeFFT(GetFrameSize(params) / kEnvelopeDecimation) {
+	double sr = (params.sampleRate > 0.0) ? params.sampleRate : 48000.0;
+	mChannels = std::clamp(clipChannels, 1, 2);
+	mSize = mFFT.GetSize();
+	mHop = mSize / 4;
+	// frames read mReach apart are close enough to measure frequencies across (a deviation of up
+	// to a bin either way) without being so close that the hop magnifies their error past 8x
+	double reach = (double)mHop * params.speed / params.pitchRead;
+	if (params.pitchRead > 0.0 && reach >= (double)(mSize / 32) && reach <= (double)(mSize / 2)) {
+		mReach = reach;
+		mDelay = 0;
+	} else {
+		mDelay = mSize / 8;
+		mReach = (double)mDelay;
+	}
+	mAdvance = (float)((double)mHop / mReach);
+	mLifter = std::clamp((int)std::lround(0.001 * sr), 4, mEnvelopeFFT.GetSize() / 4); // ~1 ms, under any voice's pitch period
+	if (params.mode == WarpMode::ComplexPro && params.pitchRatio > 0.0 && params.pitchRatio != 1.0)
+		mFormants = std::clamp(params.formants, 0.0, 1.0);
+
+	mWindow.resize((size_t)mSize);
+	for (int j = 0; j < mSize; ++j)
+		mWindow[(size_t)j] = (float)(0.5 - 0.5 * std::cos(2.0 * kPi * j / mSize));
+
+	size_t bins = (size_t)(mSize / 2 + 1);
+	mSlotFrame.assign(kSlots, INT64_MIN);
+	mSlotOutput.assign((size_t)kSlots * mChannels * mSize, 0.0f);
+	for (auto* spectrum : {&mXRe, &mXIm, &mDRe, &mDIm, &mMag, &mDMag, &mYRe, &mYIm, &mPrevRe, &mPrevIm, &mGain})
+		spectrum->assign(bins * mChannels, 0.0f);
+	mExpectedRe.resize(bins);
+	mExpectedIm.resize(bins);
+	for (size_t k = 0; k < bins; ++k) {
+		double angle = -2.0 * kPi * (double)k * mReach / (double)mSize;
+		mExpectedRe[k] = (float)std::cos(angle);
+		mExpectedIm[k] = (float)std::sin(angle);
+	}
+	mRaw.assign((size_t)mChannels * (mSize + mDelay), 0.0f);
+	mRe.assign((size_t)mSize, 0.0f);
+	mIm.assign((size_t)mSize, 0.0f);
+	mEnvelopeRe.assign((size_t)mEnvelopeFFT.GetSize(), 0.0f);
+	mEnvelopeIm.assign((size_t)mEnvelopeFFT.GetSize(), 0.0f);
+	mPeaks.assign(bins + 3, 0); // room to pad the peaks to a multiple of four
+	mRotRe.assign(bins + 3, 0.0f);
+	mRotIm.assign(bins + 3, 0.0f);
+	mPeakFlag.assign(bins, 0);
+	mRegionStart.assign(bins, 0);
+	mMix.assign((size_t)mHop * 2, 0.0f);
+}
+
+bool WarpVocoder::Matches(const WarpRenderParams& params) const {
+	return params.mode == mParams.mode && params.sampleRate == mParams.sampleRate &&
+		   params.speed == mParams.speed && params.pitchRead == mParams.pitchRead &&
+		   params.pitchRatio == mParams.pitchRatio && params.offsetOutputFrames == mParams.offsetOutputFrames &&
+		   params.grainSizeMs == mParams.grainSizeMs && params.formants == mParams.formants;
+}
+
+double WarpVocoder::FrameAnchor(int64_t frame) const {
+	return ((double)(frame * mHop) + mParams.offsetOutputFrames) * mParams.speed;
+}
+
+// the frames overlapping output [outStartFrame, outStartFrame + count). frame m's samples land
+// on output frames m * hop - size / 2 on
+void WarpVocoder::GetFrames(int64_t outStartFrame, int count, int64_t& first, int64_t& last) const {
+	first = FloorDiv(outStartFrame - mSize / 2 + mHop, mHop);
+	last = FloorDiv(outStartFrame + count - 1 + mSize / 2, mHop);
+}
+
+bool WarpVocoder::IsResident(int64_t frame) const {
+	return mSlotFrame[(size_t)(frame & (kSlots - 1))] == frame;
+}
+
+int64_t WarpVocoder::GetStartFrame(int64_t first, int64_t last) const {
+	int64_t missing = first;
+	while (missing <= last && IsResident(missing))
+		++missing;
+	if (missing <= last && mLastFrame != missing - 1)
+		return first;
+	return missing;
+}
+
+void WarpVocoder::GetSourceSpan(int64_t outStartFrame, int count, int64_t& firstFrame, int64_t& endFrame) const {
+	int64_t first, last;
+	GetFrames(outStartFrame, count, first, last);
+	int64_t start = GetStartFrame(first, last);
+	if (start > last) {
+		// nothing to read, but a couple of frames where playback is keep a stream cued there
+		firstFrame = (int64_t)std::floor(FrameAnchor(last));
+		endFrame = firstFrame + 2;
+		return;
+	}
+	double step = std::abs(mParams.pitchRead);
+	firstFrame = (int64_t)std::floor(FrameAnchor(start) - (double)(mSize / 2 + mDelay) * step) - 1;
+	endFrame = (int64_t)std::ceil(FrameAnchor(last) + (double)(mSize / 2) * step) + 2;
+}
+
+void WarpVocoder::Render(const float* samples, size_t numSamples, int clipChannels, int64_t firstFrame,
+						 int64_t outStartFrame, int count, int destChannels, float* dest) {
+	Source src{samples, numSamples, clipChannels, firstFrame};
+	destChannels = std::min(destChannels, 2);
+	for (int done = 0; done < count;) {
+		int n = std::min(mHop, count - done);
+		RenderPass(src, outStartFrame + done, n, destChannels, dest + done * destChannels);
+		done += n;
+	}
+}
+
+void WarpVocoder::RenderPass(const Source& src, int64_t a, int n, int destChannels, float* dest) {
+	// frames are computed in order: on from the newest, or after a jump all of the pass's
+	// afresh, from a restart at its first
+	int64_t first, last;
+	GetFrames(a, n, first, last);
+	for (int64_t frame = GetStartFrame(first, last); frame <= last; ++frame)
+		ComputeFrame(src, frame);
+
+	// overlap-add in frame order, so an output frame sums the same way whichever pass has it
+	float* mix = mMix.data();
+	std::fill(mix, mix + n * destChannels, 0.0f);
+	for (int64_t frame = first; frame <= last; ++frame) {
+		const float* out = &mSlotOutput[(size_t)(frame & (kSlots - 1)) * mChannels * mSize];
+		int64_t frameStart = frame * mHop - mSize / 2;
+		int64_t lo = std::max(a, frameStart);
+		int64_t hi = std::min(a + n, frameStart + mSize);
+		for (int c = 0; c < destChannels; ++c) {
+			const float* from = out + (c % mChannels) * mSize + (lo - frameStart);
+			float* to = mix + (lo - a) * destChannels + c;
+			for (int64_t t = 0; t < hi - lo; ++t)
+				to[t * destChannels] += from[t];
+		}
+	}
+	for (int i = 0; i < n * destChannels; ++i)
+		dest[i] += mix[i];
+}
+
+void WarpVocoder::ReadFrame(const Source& src, double anchor) {
+	// the absolute position first, so a span gathered anywhere interpolates the same. a frame
+	// that's inside the span all the way reads every channel at each position, unchecked
+	const int half = mSize / 2;
+	const int reads = mSize + mDelay;
+	const double step = mParams.pitchRead;
+	const double spanStart = (double)src.firstFrame;
+	const int stride = src.channels;
+	const int lastChannel = (mChannels - 1) % stride;
+	double firstPos = anchor + (double)(-mDelay - half) * step - spanStart;
+	double lastPos = anchor + (double)(mSize - 1 - half) * step - spanStart;
+	if (step > 0.0 && firstPos >= 0.0 && (size_t)(((int64_t)lastPos + 1) * stride + lastChannel) < src.numSamples) {
+		float* raw0 = mRaw.data();
+		float* raw1 = raw0 + reads;
+		for (int i = 0; i < reads; ++i) {
+			double pos = anchor + (double)(i - mDelay - half) * step - spanStart;
+			int64_t at = (int64_t)pos;
+			float frac = (float)(pos - (double)at);
+			const float* s = src.samples + at * stride;
+			raw0[i] = s[0] + frac * (s[stride] - s[0]);
+			if (mChannels > 1)
+				raw1[i] = s[lastChannel] + frac * (s[stride + lastChannel] - s[lastChannel]);
+		}
+		return;
+	}
+	for (int c = 0; c < mChannels; ++c) {
+		float* raw = &mRaw[(size_t)c * reads];
+		for (int i = 0; i < reads; ++i) {
+			double pos = anchor + (double)(i - mDelay - half) * step;
+			raw[i] = ReadLinear(src.samples, src.numSamples, src.channels, c % stride, pos - spanStart);
+		}
+	}
+}
+
+// the two real signals packed into the last transform, taken apart by symmetry: the real part's
+// spectrum into a, the imaginary part's into b
+void WarpVocoder::Unpack(float* ar, float* ai, float* br, float* bi) const {
+	const int size = mSize;
+	const float* re = mRe.data();
+	const float* im = mIm.data();
+	for (int k = 0; k <= size / 2; ++k) {
+		int mirror = (size - k) & (size - 1);
+		float zr = re[k], zi = im[k], wr = re[mirror], wi = im[mirror];
+		ar[k] = 0.5f * (zr + wr);
+		ai[k] = 0.5f * (zi - wi);
+		br[k] = 0.5f * (zi + wi);
+		bi[k] = 0.5f * (wr - zr);
+	}
+}
+
+void WarpVocoder::ComputeFrame(const Source& src, int64_t frame) {
+	const int size = mSize;
+	const int half = size / 2;
+	const int bins = half + 1;
+	const double anchor = FrameAnchor(frame);
+	const bool follows = mLastFrame == frame - 1;
+	const float* window = mWindow.data();
+
+	// analysis. the frequencies come from each channel's spectrum against one read mReach
+	// earlier: with no delay that's the last frame's own, kept from its analysis, and both
+	// channels share a transform as its real and imaginary parts. otherwise it's a frame mDelay
+	// reads before this one, which each channel packs into a transform with its own
+	ReadFrame(src, anchor);
+	const int reads = size + mDelay;
+	if (mDelay == 0) {
+		std::swap(mXRe, mDRe);
+		std::swap(mXIm, mDIm);
+		std::swap(mMag, mDMag);
+		const float* raw0 = mRaw.data();
+		const float* raw1 = raw0 + reads;
+		for (int j = 0; j < size; ++j) {
+			mRe[j] = window[j] * raw0[j];
+			mIm[j] = mChannels > 1 ? window[j] * raw1[j] : 0.0f;
+		}
+		mFFT.Forward(mRe.data(), mIm.data());
+		if (mChannels > 1) {
+			Unpack(&mXRe[0], &mXIm[0], &mXRe[bins], &mXIm[bins]);
+		} else {
+			std::copy(mRe.begin(), mRe.begin() + bins, mXRe.begin());
+			std::copy(mIm.begin(), mIm.begin() + bins, mXIm.begin());
+		}
+	} else {
+		for (int c = 0; c < mChannels; ++c) {
+			const float* raw = &mRaw[(size_t)c * reads];
+			for (int j = 0; j < size; ++j) {
+				mRe[j] = window[j] * raw[j + mDelay];
+				mIm[j] = window[j] * raw[j];
+			}
+			mFFT.Forward(mRe.data(), mIm.data());
+			Unpack(&mXRe[c * bins], &mXIm[c * bins], &mDRe[c * bins], &mDIm[c * bins]);
+			const float* dr = &mDRe[c * bins];
+			const float* di = &mDIm[c * bins];
+			float* dmag = &mDMag[c * bins];
+			for (int k = 0; k < bins; ++k)
+				dmag[k] = std::sqrt(dr[k] * dr[k] + di[k] * di[k]);
+		}
+	}
+	for (int c = 0; c < mChannels; ++c) {
+		const float* xr = &mXRe[c * bins];
+		const float* xi = &mXIm[c * bins];
+		float* mag = &mMag[c * bins];
+		for (int k = 0; k < bins; ++k)
+			mag[k] = std::sqrt(xr[k] * xr[k] + xi[k] * xi[k]);
+	}
+
+	// a restart counts as an onset, so the frame after one goes on from it whatever it measures
+	float onset = 1.0f;
+	if (follows || mDelay > 0) {
+		double rise = 0.0, total = 0.0;
+		for (int c = 0; c < mChannels; ++c) {
+			const float* mag = &mMag[c * bins];
+			const float* dmag = &mDMag[c * bins];
+			float channelRise = 0.0f, channelTotal = 0.0f;
+			for (int k = 0; k < bins; ++k) {
+				channelRise += std::max(0.0f, mag[k] - dmag[k]);
+				channelTotal += mag[k];
+			}
+			rise += channelRise;
+			total += channelTotal;
+		}
+		onset = total > 1e-6 * size ? (float)(rise / total) : 0.0f;
+	}
+	bool reset = !follows || (onset > kOnsetThreshold && mLastOnset <= kOnsetThreshold);
+
+	// the last frame's spectrum becomes the one to go on from
+	std::swap(mPrevRe, mYRe);
+	std::swap(mPrevIm, mYIm);
+	for (int c = 0; c < mChannels; ++c) {
+		const float* xr = &mXRe[c * bins];
+		const float* xi = &mXIm[c * bins];
+		const float* dr = &mDRe[c * bins];
+		const float* di = &mDIm[c * bins];
+		const float* mag = &mMag[c * bins];
+		const float* pr = &mPrevRe[c * bins];
+		const float* pi = &mPrevIm[c * bins];
+		float* yr = &mYRe[c * bins];
+		float* yi = &mYIm[c * bins];
+		std::copy(xr, xr + bins, yr);
+		std::copy(xi, xi + bins, yi);
+		if (reset)
+			continue;
+
+		// identity phase locking: each peak gets the phase its last output phase reaches in a
+		// hop at its measured frequency, and the bins around it (down to the minimum between it
+		// and the next peak) turn by the same angle, keeping its shape. dc and nyquist stay real.
+		// the peak's frequency is its bin's plus the deviation q = X conj(X') e^(-i Omega reach)
+		// shows over the reach; over the hop, a quarter frame, the bin's own part turns it i^p
+		// and the deviation's mHop / mReach times as far. the rotation, last phase times that
+		// turn over the analysis phase, is then u / |u| for u = prev turn conj(X)
+		int numPeaks = 0;
+		int* peaks = mPeaks.data();
+		int* flags = mPeakFlag.data();
+		int k = 2;
+#ifdef VOCODER_SSE2
+		for (; k + 3 <= half - 2; k += 4) {
+			__m128 m = _mm_loadu_ps(mag + k);
+			__m128 above = _mm_and_ps(_mm_cmpgt_ps(m, _mm_loadu_ps(mag + k - 1)), _mm_cmpgt_ps(m, _mm_loadu_ps(mag + k - 2)));
+			__m128 below = _mm_and_ps(_mm_cmpge_ps(m, _mm_loadu_ps(mag + k + 1)), _mm_cmpge_ps(m, _mm_loadu_ps(mag + k + 2)));
+			__m128 isPeak = _mm_and_ps(above, below);
+			_mm_storeu_si128((__m128i*)(flags + k), _mm_srli_epi32(_mm_castps_si128(isPeak), 31));
+			int found = _mm_movemask_ps(isPeak);
+			for (int b = 0; b < 4; ++b) {
+				peaks[numPeaks] = k + b;
+				numPeaks += (found >> b) & 1;
+			}
+		}
+#endif
+		for (; k <= half - 2; ++k) {
+			float m = mag[k];
+			flags[k] = (int)(m > mag[k - 1]) & (int)(m > mag[k - 2]) & (int)(m >= mag[k + 1]) & (int)(m >= mag[k + 2]);
+			peaks[numPeaks] = k;
+			numPeaks += flags[k];
+		}
+
+		float* rotRe = mRotRe.data();
+		float* rotIm = mRotIm.data();
+		for (int n = 0; n < numPeaks; ++n) {
+			int p = peaks[n];
+			float gr = xr[p] * dr[p] + xi[p] * di[p]; // X conj(X')
+			float gi = xi[p] * dr[p] - xr[p] * di[p];
+			rotRe[n] = gr * mExpectedRe[p] - gi * mExpectedIm[p];
+			rotIm[n] = gr * mExpectedIm[p] + gi * mExpectedRe[p];
+		}
+		int padded = (numPeaks + 3) & ~3;
+		for (int n = numPeaks; n < padded; ++n) {
+			peaks[n] = 0;
+			rotRe[n] = 1.0f;
+			rotIm[n] = 0.0f;
+		}
+		GetPeakTurns(peaks, padded, mAdvance, rotRe, rotIm);
+		for (int n = 0; n < numPeaks; ++n) {
+			int p = peaks[n];
+			double vr = (double)pr[p] * rotRe[n] - (double)pi[p] * rotIm[n];
+			double vi = (double)pr[p] * rotIm[n] + (double)pi[p] * rotRe[n];
+			double wr = vr * xr[p] + vi * xi[p], wi = vi * xr[p] - vr * xi[p]; // times conj(X)
+			double length = std::sqrt(wr * wr + wi * wi);
+			rotRe[n] = length > 0.0 ? (float)(wr / length) : 1.0f;
+			rotIm[n] = length > 0.0 ? (float)(wi / length) : 0.0f;
+		}
+
+		if (numPeaks == 0)
+			continue;
+
+		// the regions in two passes over the bins rather than a short search per peak, whose
+		// uneven lengths the branch predictor can't follow: the lowest bin between each two peaks
+		// is marked as where the second's region starts, then every bin takes the rotation of
+		// the region it's in. peaks are at least three bins apart, and the last region runs to
+		// nyquist
+		int* starts = mRegionStart.data();
+		float lowest = std::numeric_limits<float>::max();
+		int lowestAt = peaks[0] + 1;
+		for (int k = peaks[0] + 1; k <= peaks[numPeaks - 1]; ++k) {
+			int atPeak = flags[k];
+			bool lower = mag[k] < lowest;
+			starts[lowestAt] |= atPeak;
+			lowestAt = atPeak ? k + 1 : lower ? k : lowestAt;
+			lowest = atPeak ? std::numeric_limits<float>::max() : lower ? mag[k] : lowest;
+		}
+		int n = 0;
+		for (int k = 1; k < half; ++k) {
+			n += starts[k];
+			starts[k] = 0;
+			yr[k] = xr[k] * rotRe[n] - xi[k] * rotIm[n];
+			yi[k] = xr[k] * rotIm[n] + xi[k] * rotRe[n];
+		}
+	}
+
+	if (mFormants > 0.0)
+		ApplyFormants();
+
+	// synthesis: both channels' spectra, extended to their conjugate-symmetric halves, packed
+	// into one inverse transform as real and imaginary parts
+	const float* g0 = &mGain[0];
+	const float* g1 = &mGain[(mChannels - 1) * bins];
+	for (int k = 0; k <= half; ++k) {
+		float gain0 = mFormants > 0.0 ? g0[k] : 1.0f;
+		float gain1 = mFormants > 0.0 ? g1[k] : 1.0f;
+		float ar = mYRe[k] * gain0, ai = mYIm[k] * gain0;
+		float br = 0.0f, bi = 0.0f;
+		if (mChannels > 1) {
+			br = mYRe[bins + k] * gain1;
+			bi = mYIm[bins + k] * gain1;
+		}
+		mRe[k] = ar - bi;
+		mIm[k] = ai + br;
+		if (k > 0 && k < half) {
+			mRe[size - k] = ar + bi;
+			mIm[size - k] = br - ai;
+		}
+	}
+	mFFT.Inverse(mRe.data(), mIm.data());
+
+	// hann twice over four-fold overlap sums to 1.5; the inverse leaves a factor of the size
+	float* out = &mSlotOutput[(size_t)(frame & (kSlots - 1)) * mChannels * size];
+	const float scale = 1.0f / (1.5f * (float)size);
+	for (int j = 0; j < size; ++j)
+		out[j] = mRe[j] * mWindow[j] * scale;
+	if (mChannels > 1) {
+		for (int j = 0; j < size; ++j)
+			out[size + j] = mIm[j] * mWindow[j] * scale;
+	}
+	mSlotFrame[(size_t)(frame & (kSlots - 1))] = frame;
+	mLastFrame = frame;
+	mLastOnset = onset;
+}
+
+// ComplexPro: reading the source at a pitch moves its formants with it, so each bin gets the
+// gain that puts back the spectral envelope found pitchRatio higher (or lower) in the read frame.
+// the envelope is the cepstrally smoothed log spectrum, taken over the spectrum averaged down
+// kEnvelopeDecimation times: a ~1 ms lifter keeps far fewer points than even that has
+void WarpVocoder::ApplyFormants() {
+	const int bins = mSize / 2 + 1;
+	const int size = mEnvelopeFFT.GetSize();
+	const int half = size / 2;
+	const int decimation = mSize / size;
+
+	// a real even log spectrum has a real even cepstrum, so the channels share a transform
+	float* re = mEnvelopeRe.data();
+	float* im = mEnvelopeIm.data();
+	const float* mag0 = &mMag[0];
+	const float* mag1 = mChannels > 1 ? &mMag[bins] : nullptr;
+	for (int j = 0; j <= half; ++j) {
+		int lo = std::max(0, j * decimation - decimation / 2);
+		int hi = std::min(bins - 1, j * decimation + decimation / 2);
+		float sum0 = 0.0f, sum1 = 0.0f;
+		for (int k = lo; k <= hi; ++k) {
+			sum0 += mag0[k];
+			sum1 += mag1 ? mag1[k] : 0.0f;
+		}
+		float l0 = std::log(sum0 / (float)(hi - lo + 1) + 1e-9f);
+		float l1 = mag1 ? std::log(sum1 / (float)(hi - lo + 1) + 1e-9f) : 0.0f;
+		re[j] = l0;
+		im[j] = l1;
+		if (j > 0 && j < half) {
+			re[size - j] = l0;
+			im[size - j] = l1;
+		}
+	}
+	mEnvelopeFFT.Inverse(re, im);
+	const float scale = 1.0f / (float)size;
+	for (int q = 0; q < size; ++q) {
+		bool keep = q < mLifter || q > size - mLifter;
+		re[q] = keep ? re[q] * scale : 0.0f;
+		im[q] = keep ? im[q] * scale : 0.0f;
+	}
+	mEnvelopeFFT.Forward(re, im);
+
+	const float ratio = (float)mParams.pitchRatio;
+	const float strength = (float)mFormants;
+	const float limit = (float)kMaxFormantGain;
+	const float step = 1.0f / (float)decimation; // a power of two, so exact
+	for (int c = 0; c < mChannels; ++c) {
+		const float* envelope = c == 0 ? re : im;
+		float* gain = &mGain[c * bins];
+		for (int k = 0; k < bins; ++k) {
+			float at = (float)k * step;
+			float shift = SampleEnvelope(envelope, half, at * ratio) - SampleEnvelope(envelope, half, at);
+			gain[k] = std::clamp(strength * shift, -limit, limit);
+		}
+	}
+	ExpInPlace(mGain.data(), mChannels * bins);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "WarpEngine.h"
+#include "FFT.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// the Complex/ComplexPro engine: an stft phase vocoder with identity phase locking, phase resets
+// at transients, and for ComplexPro a cepstral-envelope formant correction. frames are read from
+// the source with the granular engine's time map -- frame m sits at output frame m * hop and reads
+// around source frame (m * hop + offset) * speed, stepping pitchRead -- so time and pitch stay as
+// decoupled as in the other modes and the clip lands on the grid the same way.
+//
+// a frame's phases carry on from the frame before it, so unlike the grains this has state: the
+// frames last rendered, the spectrum the next one goes on from and, while frames read no more
+// than half a frame apart, the last analysis, which the next measures its frequencies against
+// (one stereo transform a frame; further apart, each frame reads a second, delayed one too). a
+// block that doesn't follow on from the last (a seek, a loop wrapping, an export starting)
+// restarts the phases from the analysis, as a transient does. the output is then a function of
+// the position and of where playback last jumped to: block splits don't change a bit, a loop or
+// an export renders the same every time, and past the first transient after a jump it's the
+// same as if playback had run into it. restarting on a fixed grid instead would make every
+// frame position-addressable, but each restart dents sustained tones audibly.
+//
+// which is audible: after a seek or a loop wrap, a sustained sound plays with slightly different
+// phases (a different stereo image or beating between partials, not a different pitch) than a
+// pass straight through, until the next transient. a frozen clip (WarpFreeze) is rendered
+// straight through from the clip start, so it matches live playback only when that also started
+// at the clip start; the clip view says as much for these modes.
+//
+// one per clip, made on the ui thread with everything allocated up front; the audio thread (or
+// an export, with the audio thread suspended) is then its only user
+class WarpVocoder {
+public:
+	WarpVocoder(const WarpRenderParams& params, int clipChannels);
+
+	// true if the vocoder was made for these params
+	bool Matches(const WarpRenderParams& params) const;
+	int GetNumChannels() const { return mChannels; }
+
+	// the source frames [firstFrame, endFrame) a Render of the same block reads: those of the
+	// frames it has yet to compute
+	void GetSourceSpan(int64_t outStartFrame, int count, int64_t& firstFrame, int64_t& endFrame) const;
+
+	// RenderWarpedBlock for this vocoder's params: mixes `count` frames into dest
+	void Render(const float* samples, size_t numSamples, int clipChannels, int64_t firstFrame,
+				int64_t outStartFrame, int count, int destChannels, float* dest);
+private:
+	struct Source {
+		const float* samples;
+		size_t numSamples;
+		int channels;
+		int64_t firstFrame;
+	};
+
+	double FrameAnchor(int64_t frame) const;
+	void GetFrames(int64_t outStartFrame, int count, int64_t& first, int64_t& last) const;
+	bool IsResident(int64_t frame) const;
+	int64_t GetStartFrame(int64_t first, int64_t last) const; // the first of [first, last] to compute, or last + 1
+	void RenderPass(const Source& src, int64_t a, int n, int destChannels, float* dest);
+	void ComputeFrame(const Source& src, int64_t frame);
+	void ReadFrame(const Source& src, double anchor); // every channel's reads into mRaw
+	void Unpack(float* ar, float* ai, float* br, float* bi) const;
+	void ApplyFormants();
+
+	// geometry, fixed by the params
+	WarpRenderParams mParams;
+	double mFormants = 0.0;	   // ComplexPro's correction strength, 0 when there's nothing to correct
+	int mChannels = 1;		   // channels computed: the source's, up to stereo
+	int mSize = 0;			   // frame length, a power of two
+	int mHop = 0;			   // synthesis hop, a quarter frame
+	int mDelay = 0;			   // reads before a frame its second analysis starts, 0 to use the last frame's
+	double mReach = 0.0;	   // reads between the two spectra frequencies are measured across
+	float mAdvance = 0.0f;	   // mHop / mReach
+	int mLifter = 0;		   // cepstral bins kept for the formant envelope
+	FFT mFFT;
+	FFT mEnvelopeFFT;			// a quarter frame, for the formant envelope
+	std::vector<float> mWindow; // periodic hann, for analysis and synthesis
+
+	// cached frames, frame m in slot m mod kSlots: windowed output, mChannels * mSize each
+	std::vector<int64_t> mSlotFrame;
+	std::vector<float> mSlotOutput;
+
+	// the newest computed frame and its onset; its spectrum is in mYRe/mYIm, which the next
+	// frame's phases go on from
+	int64_t mLastFrame = INT64_MIN;
+	float mLastOnset = 0.0f;
+
+	// per channel, mSize / 2 + 1 bins each
+	std::vector<float> mXRe, mXIm; // analysis spectrum
+	std::vector<float> mDRe, mDIm; // the spectrum mReach reads earlier: the delayed frame's or the last frame's
+	std::vector<float> mMag, mDMag;
+	std::vector<float> mYRe, mYIm;		   // synthesis spectrum
+	std::vector<float> mPrevRe, mPrevIm;   // the last frame's synthesis spectrum
+	std::vector<float> mGain;			   // formant correction
+	std::vector<float> mExpectedRe, mExpectedIm; // per bin, e^(-i Omega reach): its own phase advance
+	std::vector<float> mRaw;			   // per channel, the reads from mDelay before the frame on
+	std::vector<float> mRe, mIm;		   // fft scratch, mSize
+	std::vector<float> mEnvelopeRe, mEnvelopeIm; // the formant envelope's scratch
+	std::vector<int> mPeaks;
+	std::vector<float> mRotRe, mRotIm; // each peak's rotation
+	std::vector<int> mPeakFlag;		   // per bin, 1 at a peak
+	std::vector<int> mRegionStart;	   // per bin, 1 where a peak's region starts; cleared after use
+	std::vector<float> mMix; // one pass's overlap-add, up to a hop of stereo frames
+};
@@ -0,0 +1,288 @@
+#include "PrecompHeader.h"
+#include "WaveformPeaks.h"
+#include "SamplePool.h"
+#include "ProjectFile.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+
+namespace {
+	constexpr char kPeaksMagic[4] = {'M', 'S', 'P', 'K'};
+	constexpr uint32_t kPeaksVersion = 1;
+	constexpr uint64_t kReadBlockFrames = 64 * WaveformPeaks::kBaseFramesPerBin; // whole bins per read
+
+	int16_t Quantize(float value) {
+		return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	uint64_t NumBins(uint64_t numFrames, uint64_t framesPerBin) {
+		return (numFrames + framesPerBin - 1) / framesPerBin;
+	}
+}
+
+const PeakLevel* WaveformPeaks::FindLevel(double framesPerPixel) const {
+	for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+		if (it->framesPerBin <= framesPerPixel)
+			return &*it;
+	}
+	return nullptr;
+}
+
+bool WaveformPeaks::Build(const std::string& path, WaveformPeaks& out, const std::atomic<bool>* cancel) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	WavInfo info;
+	if (!ReadWavInfo(file, path, info) || info.channels <= 0)
+		return false;
+
+	const int channels = info.channels;
+	out.channels = channels;
+	out.numFrames = info.numFrames;
+	out.levels.clear();
+
+	PeakLevel base;
+	base.framesPerBin = kBaseFramesPerBin;
+	base.numBins = NumBins(info.numFrames, kBaseFramesPerBin);
+	base.values.resize((size_t)base.numBins * channels * 3);
+
+	std::vector<uint8_t> raw;
+	std::vector<float> block;
+	for (uint64_t start = 0; start < info.numFrames; start += kReadBlockFrames) {
+		if (cancel && cancel->load())
+			return false;
+		uint64_t frames = std::min(kReadBlockFrames, info.numFrames - start);
+		raw.resize((size_t)frames * info.BytesPerFrame());
+		file.read((char*)raw.data(), raw.size());
+		if ((size_t)file.gcount() < raw.size()) // a truncated file reads as silence past its end
+			std::fill(raw.begin() + file.gcount(), raw.end(), info.bitsPerSample == 8 ? 128 : 0);
+		block.resize((size_t)frames * channels);
+		ConvertWavSamples(info, raw.data(), block.size(), block.data());
+
+		for (uint64_t first = 0; first < frames; first += kBaseFramesPerBin) {
+			uint64_t last = std::min(first + kBaseFramesPerBin, frames);
+			uint64_t bin = (start + first) / kBaseFramesPerBin;
+			for (int c = 0; c < channels; ++c) {
+				float lo = block[first * channels + c], hi = lo;
+				double sumSquares = 0.0;
+				for (uint64_t f = first; f < last; ++f) {
+					float v = block[f * channels + c];
+					lo = std::min(lo, v);
+					hi = std::max(hi, v);
+					sumSquares += (double)v * v;
+				}
+				int16_t* values = base.values.data() + (bin * channels + c) * 3;
+				values[0] = Quantize(lo);
+				values[1] = Quantize(hi);
+				values[2] = Quantize((float)std::sqrt(sumSquares / (double)(last - first)));
+			}
+		}
+	}
+	out.levels.push_back(std::move(base));
+
+	// each level from the one below: min of mins, max of maxes, rms of the rms values
+	while (out.levels.back().numBins > 1) {
+		const PeakLevel& below = out.levels.back();
+		PeakLevel level;
+		level.framesPerBin = below.framesPerBin * kLevelFactor;
+		level.numBins = NumBins(below.numBins, kLevelFactor);
+		level.values.resize((size_t)level.numBins * channels * 3);
+		for (uint64_t bin = 0; bin < level.numBins; ++bin) {
+			uint64_t firstChild = bin * kLevelFactor;
+			uint64_t lastChild = std::min(firstChild + kLevelFactor, below.numBins);
+			for (int c = 0; c < channels; ++c) {
+				int lo = INT16_MAX, hi = INT16_MIN;
+				double sumSquares = 0.0;
+				for (uint64_t child = firstChild; child < lastChild; ++child) {
+					const int16_t* v = below.GetBin(child, channels, c);
+					lo = std::min(lo, (int)v[0]);
+					hi = std::max(hi, (int)v[1]);
+					sumSquares += (double)v[2] * v[2];
+				}
+				int16_t* values = level.values.data() + (bin * channels + c) * 3;
+				values[0] = (int16_t)lo;
+				values[1] = (int16_t)hi;
+				values[2] = (int16_t)std::lround(std::sqrt(sumSquares / (double)(lastChild - firstChild)));
+			}
+		}
+		out.levels.push_back(std::move(level));
+	}
+	return true;
+}
+
+std::string WaveformPeaks::GetPeaksPath(const std::string& audioPath) {
+	return audioPath + ".peaks";
+}
+
+bool WaveformPeaks::Save(const std::string& path, uint64_t sourceSize, int64_t sourceModified) const {
+	ChunkWriter out;
+	out.WriteBytes(kPeaksMagic, sizeof(kPeaksMagic));
+	out.Write<uint32_t>(kPeaksVersion);
+	out.Write<uint64_t>(sourceSize);
+	out.Write<int64_t>(sourceModified);
+	out.Write<int32_t>(channels);
+	out.Write<uint64_t>(numFrames);
+	out.Write<uint32_t>((uint32_t)levels.size());
+	for (const auto& level : levels) {
+		out.Write<uint32_t>(level.framesPerBin);
+		out.Write<uint64_t>(level.numBins);
+		out.WriteBytes(level.values.data(), level.values.size() * sizeof(int16_t));
+	}
+
+	// written aside and renamed in, so a reader never finds half a file under the real name
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false; // a read-only folder: the pyramid just isn't kept
+		file.write((const char*)out.GetData().data(), out.GetData().size());
+		if (!file)
+			return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tempPath, path, ec);
+	if (ec) {
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool WaveformPeaks::Load(const std::string& path, uint64_t sourceSize, int64_t sourceModified) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	ChunkReader in(data.data(), data.size());
+	char magic[4] = {};
+	in.ReadBytes(magic, sizeof(magic));
+	if (std::memcmp(magic, kPeaksMagic, sizeof(magic)) != 0 || in.Read<uint32_t>() != kPeaksVersion)
+		return false;
+	if (in.Read<uint64_t>() != sourceSize || in.Read<int64_t>() != sourceModified)
+		return false; // the audio changed since
+
+	channels = in.Read<int32_t>();
+	numFrames = in.Read<uint64_t>();
+	uint32_t numLevels = in.Read<uint32_t>();
+	if (in.IsShort() || channels <= 0 || numLevels == 0)
+		return false;
+
+	levels.clear();
+	uint64_t framesPerBin = kBaseFramesPerBin;
+	for (uint32_t i = 0; i < numLevels; ++i, framesPerBin *= kLevelFactor) {
+		PeakLevel level;
+		level.framesPerBin = in.Read<uint32_t>();
+		level.numBins = in.Read<uint64_t>();
+		if (in.IsShort() || level.framesPerBin != framesPerBin || level.numBins != NumBins(numFrames, framesPerBin))
+			return false;
+		size_t count = (size_t)level.numBins * channels * 3;
+		if (count * sizeof(int16_t) > in.GetRemaining())
+			return false;
+		level.values.resize(count);
+		in.ReadBytes(level.values.data(), count * sizeof(int16_t));
+		levels.push_back(std::move(level));
+	}
+	return true;
+}
+
+bool WaveformPeakKey::operator<(const WaveformPeakKey& other) const {
+	return std::tie(path, size, modified) < std::tie(other.path, other.size, other.modified);
+}
+
+WaveformPeakCache& WaveformPeakCache::Instance() {
+	static WaveformPeakCache instance;
+	return instance;
+}
+
+WaveformPeakCache::~WaveformPeakCache() {
+	mQuit.store(true); // also abandons a build in progress
+	mCondition.notify_all();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+std::shared_ptr<WaveformPeakEntry> WaveformPeakCache::Request(const std::string& path) {
+	if (path.empty())
+		return nullptr;
+	WaveformPeakKey key;
+	std::error_code ec;
+	key.size = std::filesystem::file_size(path, ec);
+	if (!ec)
+		key.modified = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	if (ec)
+		return nullptr;
+	key.path = path;
+
+	std::shared_ptr<WaveformPeakEntry> entry;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto& weak = mEntries[key];
+		if ((entry = weak.lock()))
+			return entry;
+		entry = std::make_shared<WaveformPeakEntry>();
+		entry->key = std::move(key);
+		weak = entry;
+		mQueue.push_back(entry);
+
+		// drop entries no clip holds any more, once the map has doubled since the last sweep
+		if (mEntries.size() >= 2 * mEntriesAfterPrune + 16) {
+			std::erase_if(mEntries, [](const auto& item) { return item.second.expired(); });
+			mEntriesAfterPrune = mEntries.size();
+		}
+		if (!mThread.joinable())
+			mThread = std::thread(&WaveformPeakCache::Run, this);
+	}
+	mCondition.notify_all();
+	return entry;
+}
+
+std::shared_ptr<const WaveformPeaks> WaveformPeakCache::Get(const std::shared_ptr<WaveformPeakEntry>& entry) {
+	if (!entry)
+		return nullptr;
+	std::lock_guard<std::mutex> lock(mMutex);
+	return entry->peaks;
+}
+
+void WaveformPeakCache::Run() {
+	while (true) {
+		std::shared_ptr<WaveformPeakEntry> entry;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mQuit.load() || !mQueue.empty(); });
+			if (mQuit.load())
+				return;
+			entry = mQueue.front().lock();
+			mQueue.pop_front();
+		}
+		if (!entry)
+			continue; // its clips went away before it was made
+
+		auto peaks = Make(entry->key);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		entry->peaks = std::move(peaks);
+	}
+}
+
+std::shared_ptr<const WaveformPeaks> WaveformPeakCache::Make(const WaveformPeakKey& key) {
+	auto peaks = std::make_shared<WaveformPeaks>();
+	std::string peaksPath = WaveformPeaks::GetPeaksPath(key.path);
+	if (peaks->Load(peaksPath, key.size, key.modified))
+		return peaks;
+	if (!WaveformPeaks::Build(key.path, *peaks, &mQuit))
+		return nullptr; // unreadable: the entry stays null and the clip draws from its samples
+
+	// the file may have been rewritten again while it was read: then this pyramid is of
+	// neither version, so it's kept for this session only and the .peaks left as it was
+	std::error_code ec;
+	uint64_t size = std::filesystem::file_size(key.path, ec);
+	int64_t modified = 0;
+	if (!ec)
+		modified = (int64_t)std::filesystem::last_write_time(key.path, ec).time_since_epoch().count();
+	if (!ec && size == key.size && modified == key.modified)
+		peaks->Save(peaksPath, key.size, key.modified);
+	return peaks;
+}
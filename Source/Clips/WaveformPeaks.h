@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one level of a peak pyramid: for each bin of `framesPerBin` source frames and each channel,
+// the min, max and rms, as 16-bit fractions of full scale
+struct PeakLevel {
+	uint32_t framesPerBin = 0;
+	uint64_t numBins = 0;
+	std::vector<int16_t> values; // [bin][channel][min, max, rms]
+
+	const int16_t* GetBin(uint64_t bin, int channels, int channel) const { return values.data() + (bin * channels + channel) * 3; }
+};
+
+// a file's waveform at every zoom: level 0 summarizes kBaseFramesPerBin frames a bin, each level
+// above a kLevelFactor times coarser one. drawing picks the level matching the zoom, so it
+// touches a few bins per pixel however long the file is. never written after it's built
+struct WaveformPeaks {
+	static constexpr uint32_t kBaseFramesPerBin = 256;
+	static constexpr uint32_t kLevelFactor = 4;
+
+	int channels = 2;
+	uint64_t numFrames = 0;
+	std::vector<PeakLevel> levels;
+
+	// the coarsest level whose bins are no wider than `framesPerPixel`; null when zoomed in
+	// past level 0, where the samples themselves are finer than any level
+	const PeakLevel* FindLevel(double framesPerPixel) const;
+
+	// reads the wav at `path` block by block. false if it can't be read, or `cancel` was set
+	static bool Build(const std::string& path, WaveformPeaks& out, const std::atomic<bool>* cancel = nullptr);
+
+	// the .peaks file next to an audio file. it records the audio's size and modification
+	// time, and Load refuses one that no longer matches
+	static std::string GetPeaksPath(const std::string& audioPath);
+	bool Save(const std::string& path, uint64_t sourceSize, int64_t sourceModified) const;
+	bool Load(const std::string& path, uint64_t sourceSize, int64_t sourceModified);
+};
+
+// one version of a file: its path, size and modification time, as SamplePool tells them apart
+struct WaveformPeakKey {
+	std::string path; // empty = no file
+	uint64_t size = 0;
+	int64_t modified = 0;
+	bool operator<(const WaveformPeakKey& other) const;
+};
+
+// one file version's pyramid, held by the clips showing it. the cache only refers to it
+// weakly, so the pyramid goes with the last clip of that version
+struct WaveformPeakEntry {
+	WaveformPeakKey key;
+	std::shared_ptr<const WaveformPeaks> peaks; // null until the worker gets to it. cache mutex
+};
+
+// process-wide pyramids by file version, so a file rewritten on disk gets a new one the next
+// time it's opened. a worker thread loads each file's .peaks, or builds the pyramid from the
+// audio and writes the .peaks for next time, so neither happens on the ui thread
+class WaveformPeakCache {
+public:
+	static WaveformPeakCache& Instance();
+	~WaveformPeakCache();
+
+	// the entry for the file as it is on disk now, queued for the worker if no clip holds that
+	// version yet. null if the file can't be read. any thread; called as a file is opened
+	std::shared_ptr<WaveformPeakEntry> Request(const std::string& path);
+
+	// the entry's pyramid, or null while it's being made (or if the file couldn't be read). no
+	// file access, so it's cheap enough to call every frame
+	std::shared_ptr<const WaveformPeaks> Get(const std::shared_ptr<WaveformPeakEntry>& entry);
+private:
+	WaveformPeakCache() = default;
+	void Run();
+	std::shared_ptr<const WaveformPeaks> Make(const WaveformPeakKey& key);
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::map<WaveformPeakKey, std::weak_ptr<WaveformPeakEntry>> mEntries;
+	size_t mEntriesAfterPrune = 0; // how many the last sweep for expired entries left
+	std::deque<std::weak_ptr<WaveformPeakEntry>> mQueue; // skipped once no clip holds them
+	std::atomic<bool> mQuit{false};
+	std::thread mThread;
+};
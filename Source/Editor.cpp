@@ -26,6 +26,8 @@ Editor::Editor(AudioEngine& engine)
 	mDeviceRackView = std::make_unique<DeviceRackView>(mContext);
 	mClipView = std::make_unique<ClipView>(mContext);
 	mPianoRollView = std::make_unique<PianoRollView>(mContext);
+	mAutosaver = std::make_unique<Autosaver>((std::filesystem::path(AppConfig::Instance().ConfigDirectory()) / "Autosave").string(),
+										   GetEditRevision());
 
 	VSTProcessor::OnGlobalKeyEvent = [this](int virtualKey, bool isDown) {
 		this->OnExternalKey(virtualKey, isDown);
@@ -35,11 +37,17 @@ Editor::Editor(AudioEngine& engine)
 	Parameter::sOnEditCommitted = [this](Parameter* param, float oldValue, float newValue) {
 		mContext.undoManager.Push(std::make_unique<ParameterChangeAction>(param, oldValue, newValue));
 	};
+	// and every edit that doesn't reach it as a change to autosave
+	Parameter::sOnExternalEdit = [this]() {
+		if (Project* p = GetProject())
+			p->MarkEdited();
+	};
 }
 
 Editor::~Editor() {
 	// the callback captures `this`; drop it before we go away
 	Parameter::sOnEditCommitted = nullptr;
+	Parameter::sOnExternalEdit = nullptr;
 }
 
 void Editor::Init(float scale) {
@@ -55,6 +63,11 @@ Project* Editor::GetProject() {
 	return mContext.GetProject();
 }
 
+uint64_t Editor::GetEditRevision() {
+	Project* p = GetProject();
+	return mContext.undoManager.GetRevision() + (p ? p->GetEditCount() : 0);
+}
+
 void Editor::OnFileDrop(const std::string& path, float x, float y) {
 	mContext.state.droppedPath = path;
 	mContext.state.dropX = x;
@@ -75,6 +88,8 @@ void Editor::ClearDragState() {
 }
 
 void Editor::NewProject() {
+	mProjectLoader.reset(); // whatever was still loading belongs to the old project
+	mAutosaver->Reset(GetEditRevision());
 	if (Project* p = GetProject()) {
 		p->Initialize();
 		mContext.undoManager.Clear(); // new object graph — old actions are meaningless
@@ -93,6 +108,7 @@ void Editor::NewProject() {
 }
 
 void Editor::SaveProject() {
+	FinishProjectLoad(); // a chain still being built isn't on its track yet, so it wouldn't be saved
 	if (mCurrentProjectPath.empty()) {
 		SaveProjectAs();
 	} else {
@@ -121,7 +137,7 @@ void Editor::SaveProjectAs() {
 	ofn.hwndOwner = (HWND)mContext.nativeWindowHandle;
 	ofn.lpstrFile = szFile;
 	ofn.nMaxFile = sizeof(szFile);
-	ofn.lpstrFilter = "MSDAW Project\0*.msdaw\0All Files\0*.*\0";
+	ofn.lpstrFilter = "MSDAW Project\0*.msdaw\0MSDAW Project (Text)\0*.msdaw\0All Files\0*.*\0";
 	ofn.nFilterIndex = 1;
 	ofn.lpstrFileTitle = NULL;
 	ofn.nMaxFileTitle = 0;
@@ -130,6 +146,7 @@ void Editor::SaveProjectAs() {
 	ofn.lpstrDefExt = "msdaw";
 
 	if (GetSaveFileNameA(&ofn) == TRUE) {
+		FinishProjectLoad();
 		mCurrentProjectPath = szFile;
 		if (Project* p = GetProject()) {
 			ProjectViewState vs;
@@ -141,7 +158,8 @@ void Editor::SaveProjectAs() {
 			vs.timelineGridNumerator = mContext.state.timelineGridNumerator;
 			vs.timelineGridDenominator = mContext.state.timelineGridDenominator;
 			p->SetViewState(vs);
-			p->Save(mCurrentProjectPath);
+			// the text filter exports the line-based format; Save goes back to binary
+			p->Save(mCurrentProjectPath, ofn.nFilterIndex == 2 ? ProjectFileFormat::Text : ProjectFileFormat::Binary);
 		}
 	}
 #endif
@@ -166,8 +184,14 @@ void Editor::OpenProject() {
 
 	if (GetOpenFileNameA(&ofn) == TRUE) {
 		mCurrentProjectPath = szFile;
+		mProjectLoader.reset();
+		mAutosaver->Reset(GetEditRevision());
 		if (Project* p = GetProject()) {
-			p->Load(mCurrentProjectPath);
+			// the structure comes in now; audio files and plugins follow on the loader's
+			// threads and are installed by RenderLoadWindow as they finish
+			mProjectLoader = std::make_unique<ProjectLoader>();
+			p->BeginLoad(mCurrentProjectPath, *mProjectLoader);
+			mProjectLoader->Start();
 			mContext.undoManager.Clear(); // freshly loaded graph — discard old history
 
 			const auto& vs = p->GetViewState();
@@ -189,7 +213,37 @@ void Editor::OpenProject() {
 #endif
 }
 
-void Editor::ExportProject() {
+void Editor::RecoverAutosave() {
+	Project* p = GetProject();
+	if (!p)
+		return;
+	mProjectLoader.reset();
+	mAutosaver->Reset(GetEditRevision());
+	auto loader = std::make_unique<ProjectLoader>();
+	if (!mAutosaver->BeginRecover(*p, *loader))
+		return;
+	mProjectLoader = std::move(loader);
+	mProjectLoader->Start();
+
+	// untitled, so a save asks where rather than overwriting whatever file it came from
+	mCurrentProjectPath.clear();
+	mContext.undoManager.Clear();
+
+	const auto& vs = p->GetViewState();
+	mContext.state.pixelsPerBeat = std::max(10.0f, vs.pixelsPerBeat);
+	mContext.state.selectionStart = vs.selectionStart;
+	mContext.state.selectionEnd = vs.selectionEnd;
+	mContext.state.timelineScrollX = vs.scrollX;
+	mContext.state.timelineScrollY = vs.scrollY;
+	mContext.state.timelineGridNumerator = vs.timelineGridNumerator;
+	mContext.state.timelineGridDenominator = vs.timelineGridDenominator > 0 ? vs.timelineGridDenominator : 4;
+	mContext.state.timelineGrid = (double)mContext.state.timelineGridNumerator / mContext.state.timelineGridDenominator;
+	mContext.state.restoreScroll = true;
+}
+
+void Editor::ExportProject(ExportStems stems) {
+	if (mExportJob)
+		return; // one export at a time
 #ifdef _WIN32
 	OPENFILENAMEA ofn;
 	char szFile[260] = {0};
@@ -208,19 +262,21 @@ void Editor::ExportProject() {
 	ofn.lpstrDefExt = "wav";
 
 	if (GetSaveFileNameA(&ofn) == TRUE) {
+		FinishProjectLoad(); // the export renders a copy of the project as it stands
 		if (Project* p = GetProject()) {
-			double start = 0.0;
-			double end = 0.0;
+			RenderSettings settings;
+			settings.sampleFormat = AppConfig::Instance().exportFormat;
+			settings.dither = AppConfig::Instance().exportDither;
+			settings.resampleQuality = AppConfig::Instance().exportResampleQuality;
 			if (mContext.state.selectionEnd > mContext.state.selectionStart) {
-				start = mContext.state.selectionStart;
-				end = mContext.state.selectionEnd;
+				settings.startBeat = mContext.state.selectionStart;
+				settings.endBeat = mContext.state.selectionEnd;
 			}
+			if (stems != ExportStems::None)
+				settings.stems = p->GetStems(szFile, stems == ExportStems::TopLevel);
 
-			if (p->RenderAudio(szFile, start, end)) {
-				MessageBoxA((HWND)mContext.nativeWindowHandle, "Export Complete!", "Success", MB_OK);
-			} else {
-				MessageBoxA((HWND)mContext.nativeWindowHandle, "Export Failed.", "Error", MB_OK | MB_ICONERROR);
-			}
+			// renders in the background; RenderExportWindow reports back when it is done
+			mExportJob = std::make_unique<RenderJob>(*p, szFile, settings);
 		}
 	}
 #endif
@@ -492,9 +548,15 @@ void Editor::RenderMenuBar() {
 				SaveProject();
 			if (ImGui::MenuItem("Save Project As..."))
 				SaveProjectAs();
+			if (ImGui::MenuItem("Recover Autosave", nullptr, false, mAutosaver->HasAutosave()))
+				RecoverAutosave();
 			ImGui::Separator();
 			if (ImGui::MenuItem("Export Audio..."))
 				ExportProject();
+			if (ImGui::MenuItem("Export Stems..."))
+				ExportProject(ExportStems::TopLevel);
+			if (ImGui::MenuItem("Export Every Track..."))
+				ExportProject(ExportStems::All);
 			ImGui::Separator();
 			if (ImGui::MenuItem("Exit"))
 				exit(0);
@@ -709,6 +771,44 @@ void Editor::PumpPluginEditors() {
 	}
 }
 
+double Editor::GetFrameInterval() {
+	constexpr double kIdleFrameInterval = 0.5; // background work (peaks, autosave, cpu readout) still shows up
+	constexpr float kMeterFloor = 0.001f;	   // -60 dB, the bottom of the meters
+
+	if (mProjectLoader || mContext.state.isOsDragging || ImGui::IsAnyItemActive())
+		return 0.0;
+
+	double followInterval = 1.0 / std::max(1, AppConfig::Instance().playbackFrameRate);
+	if (mExportJob)
+		return followInterval;
+
+	Project* project = GetProject();
+	if (!project)
+		return kIdleFrameInterval;
+	if (project->GetTransport().IsPlaying())
+		return followInterval;
+
+	// meters still falling after a stop, or a plugin editor that needs its idle pumped
+	auto isMoving = [&](const std::shared_ptr<Track>& track) {
+		if (!track)
+			return false;
+		if (track->GetPeakL() > kMeterFloor || track->GetPeakR() > kMeterFloor)
+			return true;
+		for (auto& proc : track->GetProcessors()) {
+			if (proc && proc->IsEditorOpen())
+				return true;
+		}
+		return false;
+	};
+	if (isMoving(project->GetMasterTrack()))
+		return followInterval;
+	for (auto& track : project->GetTracks()) {
+		if (isMoving(track))
+			return followInterval;
+	}
+	return kIdleFrameInterval;
+}
+
 void Editor::RenderHistoryWindow() {
 	if (!mContext.state.showHistoryWindow)
 		return;
@@ -766,6 +866,74 @@ void Editor::RenderHistoryWindow() {
 	ImGui::End();
 }
 
+void Editor::FinishProjectLoad() {
+	if (!mProjectLoader)
+		return;
+	mProjectLoader->Wait();
+	if (Project* p = GetProject())
+		p->ApplyLoadedAssets(*mProjectLoader);
+	mProjectLoader.reset();
+}
+
+void Editor::RenderLoadWindow() {
+	if (!mProjectLoader)
+		return;
+
+	if (Project* p = GetProject())
+		p->ApplyLoadedAssets(*mProjectLoader);
+	if (mProjectLoader->IsDone()) {
+		mProjectLoader.reset();
+		return;
+	}
+
+	float scale = mContext.state.mainScale;
+	int applied = mProjectLoader->GetApplied();
+	int total = mProjectLoader->GetTotal();
+	ImGui::SetNextWindowSize(ImVec2(320 * scale, 0), ImGuiCond_Always);
+	if (ImGui::Begin("Loading Project", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize)) {
+		ImGui::TextUnformatted(std::filesystem::path(mCurrentProjectPath).filename().string().c_str());
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "%d / %d", applied, total);
+		ImGui::ProgressBar((float)applied / (float)total, ImVec2(-1, 0), overlay);
+		ImGui::TextDisabled("Tracks play as their audio and plugins arrive");
+	}
+	ImGui::End();
+}
+
+void Editor::RenderExportWindow() {
+	if (!mExportJob)
+		return;
+
+	mExportJob->Update(); // the copy's plugins are built here, on the ui thread
+	if (mExportJob->IsFinished()) {
+		bool succeeded = mExportJob->Succeeded();
+		bool cancelled = mExportJob->IsCancelled();
+		mExportJob.reset();
+#ifdef _WIN32
+		if (succeeded)
+			MessageBoxA((HWND)mContext.nativeWindowHandle, "Export Complete!", "Success", MB_OK);
+		else if (!cancelled)
+			MessageBoxA((HWND)mContext.nativeWindowHandle, "Export Failed.", "Error", MB_OK | MB_ICONERROR);
+#else
+		(void)succeeded;
+		(void)cancelled;
+#endif
+		return;
+	}
+
+	float scale = mContext.state.mainScale;
+	ImGui::SetNextWindowSize(ImVec2(320 * scale, 0), ImGuiCond_Always);
+	if (ImGui::Begin("Exporting Audio", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize)) {
+		ImGui::TextUnformatted(std::filesystem::path(mExportJob->GetPath()).filename().string().c_str());
+		ImGui::ProgressBar(mExportJob->GetProgress(), ImVec2(-1, 0), mExportJob->IsLoading() ? "Loading tracks" : nullptr);
+		ImGui::BeginDisabled(mExportJob->IsCancelled());
+		if (ImGui::Button("Cancel"))
+			mExportJob->Cancel();
+		ImGui::EndDisabled();
+	}
+	ImGui::End();
+}
+
 void Editor::RenderSettingsWindow() {
 	if (!mContext.state.showSettingsWindow)
 		return;
@@ -778,6 +946,34 @@ void Editor::RenderSettingsWindow() {
 				ImGui::Text("Device: Default Output");
 				ImGui::Text("Sample Rate: 48000 Hz");
 				ImGui::Text("Buffer Size: 512");
+				ImGui::Separator();
+				AppConfig& config = AppConfig::Instance();
+				ImGui::SetNextItemWidth(120.0f);
+				if (ImGui::InputInt("Stream files from (MB)", &config.streamThresholdMB, 16, 128)) {
+					config.streamThresholdMB = std::max(0, config.streamThresholdMB);
+					config.Save();
+				}
+				ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::Instance().textMuted),
+								   "Larger files play from disk. Applies to files loaded afterwards; 0 loads all into memory.");
+				if (ImGui::Checkbox("Memory-map audio files", &config.mapAudioFiles))
+					config.Save();
+				ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::Instance().textMuted),
+								   "Plays files in place from the OS file cache instead of decoding them.");
+				ImGui::SetNextItemWidth(120.0f);
+				if (ImGui::BeginCombo("Resampling", GetResampleQualityName(config.resampleQuality))) {
+					for (int i = (int)ResampleQuality::Linear; i <= (int)ResampleQuality::Sinc; ++i) {
+						ResampleQuality quality = (ResampleQuality)i;
+						if (ImGui::Selectable(GetResampleQualityName(quality), quality == config.resampleQuality)) {
+							config.resampleQuality = quality;
+							config.Save();
+							if (Project* p = GetProject())
+								p->SetResampleQuality(quality);
+						}
+					}
+					ImGui::EndCombo();
+				}
+				ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::Instance().textMuted),
+								   "How unwarped and Re-Pitch clips play at another rate or pitch. Sinc doesn't alias but costs the most.");
 				ImGui::EndTabItem();
 			}
 			if (ImGui::BeginTabItem("Display & Input")) {
@@ -787,6 +983,68 @@ void Editor::RenderSettingsWindow() {
 				ImGui::SameLine();
 				if (ImGui::RadioButton("Continuous", mContext.state.followMode == FollowMode::Continuous))
 					mContext.state.followMode = FollowMode::Continuous;
+
+				AppConfig& config = AppConfig::Instance();
+				ImGui::SetNextItemWidth(120.0f);
+				if (ImGui::InputInt("Playback redraw (fps)", &config.playbackFrameRate, 5, 15)) {
+					config.playbackFrameRate = std::clamp(config.playbackFrameRate, 1, 240);
+					config.Save();
+				}
+				ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::Instance().textMuted),
+								   "How often the playhead and meters redraw. When idle, the UI only redraws on input.");
+				ImGui::EndTabItem();
+			}
+			if (ImGui::BeginTabItem("Project")) {
+				AppConfig& config = AppConfig::Instance();
+				ImGui::SetNextItemWidth(120.0f);
+				if (ImGui::InputInt("Autosave every (s)", &config.autosaveIntervalSeconds, 30, 300)) {
+					config.autosaveIntervalSeconds = std::max(0, config.autosaveIntervalSeconds);
+					config.Save();
+				}
+				ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::Instance().textMuted),
+								   "Saves edits in the background for File > Recover Autosave; 0 turns it off.");
+				ImGui::EndTabItem();
+			}
+			if (ImGui::BeginTabItem("Export")) {
+				AppConfig& config = AppConfig::Instance();
+				bool changed = false;
+				if (ImGui::BeginCombo("Sample Format", GetWavSampleFormatName(config.exportFormat))) {
+					for (int i = (int)WavSampleFormat::Int16; i <= (int)WavSampleFormat::Float64; ++i) {
+						WavSampleFormat format = (WavSampleFormat)i;
+						if (ImGui::Selectable(GetWavSampleFormatName(format), format == config.exportFormat)) {
+							config.exportFormat = format;
+							changed = true;
+						}
+					}
+					ImGui::EndCombo();
+				}
+				bool canDither = config.exportFormat == WavSampleFormat::Int16 || config.exportFormat == WavSampleFormat::Int24;
+				ImGui::BeginDisabled(!canDither);
+				if (ImGui::BeginCombo("Dither", GetWavDitherName(config.exportDither))) {
+					for (int i = (int)WavDither::None; i <= (int)WavDither::NoiseShaped; ++i) {
+						WavDither dither = (WavDither)i;
+						if (ImGui::Selectable(GetWavDitherName(dither), dither == config.exportDither)) {
+							config.exportDither = dither;
+							changed = true;
+						}
+					}
+					ImGui::EndCombo();
+				}
+				ImGui::EndDisabled();
+				if (ImGui::BeginCombo("Resampling", GetResampleQualityName(config.exportResampleQuality))) {
+					for (int i = (int)ResampleQuality::Linear; i <= (int)ResampleQuality::Sinc; ++i) {
+						ResampleQuality quality = (ResampleQuality)i;
+						if (ImGui::Selectable(GetResampleQualityName(quality), quality == config.exportResampleQuality)) {
+							config.exportResampleQuality = quality;
+							changed = true;
+						}
+					}
+					ImGui::EndCombo();
+				}
+				ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::Instance().textMuted),
+								   "Files past 4 GB are written as RF64.");
+				if (changed)
+					config.Save();
 				ImGui::EndTabItem();
 			}
 			if (ImGui::BeginTabItem("Plugins")) {
@@ -901,6 +1159,8 @@ void Editor::Render(const ImVec2& fullWorkPos, const ImVec2& fullWorkSize) {
 	mPianoRollView->Render();
 	RenderSettingsWindow();
 	RenderHistoryWindow();
+	RenderExportWindow();
+	RenderLoadWindow();
 	PumpPluginEditors();
 
 	if (mContext.state.processDrop) {
@@ -926,7 +1186,7 @@ void Editor::Render(const ImVec2& fullWorkPos, const ImVec2& fullWorkSize) {
 						track->SetName(p.filename().stem().string());
 						track->AddProcessor(vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					}
 				}
 			}
@@ -942,7 +1202,7 @@ void Editor::Render(const ImVec2& fullWorkPos, const ImVec2& fullWorkSize) {
 						track->SetName(p.filename().stem().string());
 						track->AddProcessor(vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					}
 				}
 			}
@@ -986,4 +1246,12 @@ void Editor::Render(const ImVec2& fullWorkPos, const ImVec2& fullWorkSize) {
 	// every parameter widget has been drawn by now, so a click that reached here
 	// unclaimed means the user clicked away from all of them -> deselect
 	Parameter::ProcessDeselection();
+
+	// hand this frame's edits to the audio thread as one snapshot swap
+	if (Project* p = GetProject()) {
+		p->PublishGraph();
+		// not mid-load: chains still being built aren't on their tracks, so they'd be left out
+		if (!mProjectLoader)
+			mAutosaver->Update(*p, GetEditRevision());
+	}
 }
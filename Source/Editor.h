@@ -9,6 +9,9 @@
 #include "Views/ClipView.h"
 #include "Views/PianoRollView.h"
 #include "SystemMonitor.h"
+#include "RenderJob.h"
+#include "ProjectLoader.h"
+#include "Autosave.h"
 #include <memory>
 #include <string>
 
@@ -29,6 +32,11 @@ public:
 	// main render loop
 	void Render(const ImVec2& workPos, const ImVec2& workSize);
 
+	// seconds the ui can go between frames while no input arrives: 0 for every vsync (a load or
+	// a drag in progress), the playback rate in AppConfig while something on screen moves by
+	// itself (playhead, meters, an open plugin editor), and an idle heartbeat otherwise
+	double GetFrameInterval();
+
 	// handle file drops
 	void OnFileDrop(const std::string& path, float x, float y);
 
@@ -46,7 +54,11 @@ public:
 	void SaveProject();
 	void SaveProjectAs();
 	void OpenProject();
-	void ExportProject();
+	void RecoverAutosave(); // opens the last autosave as an untitled project
+	// stems are written next to the mix: the top-level tracks and groups, which sum to what
+	// enters the master, or every track and group (a group's stem includes its children)
+	enum class ExportStems { None, TopLevel, All };
+	void ExportProject(ExportStems stems = ExportStems::None);
 
 	// transport logic
 	void TogglePlayStop();
@@ -60,10 +72,15 @@ private:
 	void DrawMeterCell(const char* id, const char* label, float fraction, float heat, const char* valueText, const char* tooltip);
 	void RenderSettingsWindow();
 	void RenderHistoryWindow();
+	void RenderExportWindow(); // progress of the running export, if any
+	void RenderLoadWindow();   // installs loaded assets and shows how many are still coming
+	void FinishProjectLoad();  // blocks until the project being opened is complete
 	void ProcessComputerKeyboardMIDI(); // imgui input
 	void HandleGlobalShortcuts();
 	void PumpPluginEditors(); // per-frame idle for open plugin editor windows
 	Project* GetProject();
+	// moves with every edit, undoable or not: what the autosave watches
+	uint64_t GetEditRevision();
 private:
 	EditorContext mContext;
 
@@ -82,4 +99,13 @@ private:
 
 	// live cpu/ram sampling for the menu-bar resource meter
 	SystemMonitor mSystemMonitor;
+
+	// background export started from File > Export Audio
+	std::unique_ptr<RenderJob> mExportJob;
+
+	// audio files and plugins of the project being opened, null once they are all in
+	std::unique_ptr<ProjectLoader> mProjectLoader;
+
+	// crash-recovery saves of whatever is open, under the config directory
+	std::unique_ptr<Autosaver> mAutosaver;
 };
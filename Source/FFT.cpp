@@ -0,0 +1,176 @@
+#include "PrecompHeader.h"
+#include "FFT.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FFT_SSE2 1
+#endif
+
+FFT::FFT(int size) : mSize(size) {
+	int bits = 0;
+	while ((1 << bits) < size)
+		++bits;
+	for (uint32_t i = 0; i < (uint32_t)size; ++i) {
+		uint32_t reversed = 0;
+		for (int b = 0; b < bits; ++b)
+			reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+		if (i < reversed)
+			mSwaps.emplace_back(i, reversed);
+	}
+
+	// computed in double so the error doesn't grow with the pass
+	const double pi = 3.14159265358979323846;
+	for (int half = 4; half < size; half *= 2) {
+		for (int j = 0; j < half; ++j) {
+			double angle = -pi * (double)j / (double)half;
+			mCos.push_back((float)std::cos(angle));
+			mSin.push_back((float)std::sin(angle));
+		}
+	}
+}
+
+void FFT::Transform(float* re, float* im, bool inverse) const {
+	for (const auto& [i, j] : mSwaps) {
+		std::swap(re[i], re[j]);
+		std::swap(im[i], im[j]);
+	}
+
+	// the first two radix-2 passes as one 4-point butterfly: their twiddles are 1 and -i
+	// (+i inverse), which need no multiplies
+	for (int i = 0; i < mSize; i += 4) {
+		float ar = re[i] + re[i + 1], ai = im[i] + im[i + 1];
+		float br = re[i] - re[i + 1], bi = im[i] - im[i + 1];
+		float cr = re[i + 2] + re[i + 3], ci = im[i + 2] + im[i + 3];
+		float dr = re[i + 2] - re[i + 3], di = im[i + 2] - im[i + 3];
+		// d times -i (forward) or +i (inverse)
+		float er = inverse ? -di : di, ei = inverse ? dr : -dr;
+		re[i] = ar + cr;
+		im[i] = ai + ci;
+		re[i + 2] = ar - cr;
+		im[i + 2] = ai - ci;
+		re[i + 1] = br + er;
+		im[i + 1] = bi + ei;
+		re[i + 3] = br - er;
+		im[i + 3] = bi - ei;
+	}
+
+	// the remaining radix-2 passes two at a time, so each four points are loaded and stored once
+	// for both: the pass of half h pairs (a, b) and (c, d), the pass of 2h then (a, c) and (b, d).
+	// the arithmetic is the same as one pass after the other. an odd pass left over goes last
+	const float sign = inverse ? -1.0f : 1.0f; // the inverse's twiddles are the conjugates
+	int half = 4;
+	for (; 2 * half < mSize; half *= 4) {
+		const float* wc1 = mCos.data() + (half - 4); // pass h's twiddles, then pass 2h's
+		const float* ws1 = mSin.data() + (half - 4);
+		const float* wc2 = mCos.data() + (2 * half - 4);
+		const float* ws2 = mSin.data() + (2 * half - 4);
+		for (int start = 0; start < mSize; start += 4 * half) {
+			float* ar = re + start;
+			float* ai = im + start;
+			float* br = ar + half;
+			float* bi = ai + half;
+			float* cr = br + half;
+			float* ci = bi + half;
+			float* dr = cr + half;
+			float* di = ci + half;
+#ifdef FFT_SSE2
+			// half is a multiple of 4 from here on, so four butterflies a step and no tail
+			const __m128 vSign = _mm_set1_ps(sign);
+			auto twiddle = [](__m128 xr, __m128 xi, __m128 wr, __m128 wi, __m128& tr, __m128& ti) {
+				tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+				ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+			};
+			for (int j = 0; j < half; j += 4) {
+				__m128 w1r = _mm_loadu_ps(wc1 + j);
+				__m128 w1i = _mm_mul_ps(_mm_loadu_ps(ws1 + j), vSign);
+				__m128 tr, ti;
+				twiddle(_mm_loadu_ps(br + j), _mm_loadu_ps(bi + j), w1r, w1i, tr, ti);
+				__m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+				__m128 a1r = _mm_add_ps(yr, tr), a1i = _mm_add_ps(yi, ti);
+				__m128 b1r = _mm_sub_ps(yr, tr), b1i = _mm_sub_ps(yi, ti);
+				twiddle(_mm_loadu_ps(dr + j), _mm_loadu_ps(di + j), w1r, w1i, tr, ti);
+				yr = _mm_loadu_ps(cr + j);
+				yi = _mm_loadu_ps(ci + j);
+				__m128 c1r = _mm_add_ps(yr, tr), c1i = _mm_add_ps(yi, ti);
+				__m128 d1r = _mm_sub_ps(yr, tr), d1i = _mm_sub_ps(yi, ti);
+
+				twiddle(c1r, c1i, _mm_loadu_ps(wc2 + j), _mm_mul_ps(_mm_loadu_ps(ws2 + j), vSign), tr, ti);
+				_mm_storeu_ps(ar + j, _mm_add_ps(a1r, tr));
+				_mm_storeu_ps(ai + j, _mm_add_ps(a1i, ti));
+				_mm_storeu_ps(cr + j, _mm_sub_ps(a1r, tr));
+				_mm_storeu_ps(ci + j, _mm_sub_ps(a1i, ti));
+				twiddle(d1r, d1i, _mm_loadu_ps(wc2 + half + j), _mm_mul_ps(_mm_loadu_ps(ws2 + half + j), vSign), tr, ti);
+				_mm_storeu_ps(br + j, _mm_add_ps(b1r, tr));
+				_mm_storeu_ps(bi + j, _mm_add_ps(b1i, ti));
+				_mm_storeu_ps(dr + j, _mm_sub_ps(b1r, tr));
+				_mm_storeu_ps(di + j, _mm_sub_ps(b1i, ti));
+			}
+#else
+			for (int j = 0; j < half; ++j) {
+				float w1r = wc1[j], w1i = ws1[j] * sign;
+				float tr = br[j] * w1r - bi[j] * w1i;
+				float ti = br[j] * w1i + bi[j] * w1r;
+				float a1r = ar[j] + tr, a1i = ai[j] + ti;
+				float b1r = ar[j] - tr, b1i = ai[j] - ti;
+				tr = dr[j] * w1r - di[j] * w1i;
+				ti = dr[j] * w1i + di[j] * w1r;
+				float c1r = cr[j] + tr, c1i = ci[j] + ti;
+				float d1r = cr[j] - tr, d1i = ci[j] - ti;
+
+				float w2r = wc2[j], w2i = ws2[j] * sign;
+				tr = c1r * w2r - c1i * w2i;
+				ti = c1r * w2i + c1i * w2r;
+				ar[j] = a1r + tr;
+				ai[j] = a1i + ti;
+				cr[j] = a1r - tr;
+				ci[j] = a1i - ti;
+				w2r = wc2[half + j];
+				w2i = ws2[half + j] * sign;
+				tr = d1r * w2r - d1i * w2i;
+				ti = d1r * w2i + d1i * w2r;
+				br[j] = b1r + tr;
+				bi[j] = b1i + ti;
+				dr[j] = b1r - tr;
+				di[j] = b1i - ti;
+			}
+#endif
+		}
+	}
+	if (half < mSize) {
+		const float* wc = mCos.data() + (half - 4);
+		const float* ws = mSin.data() + (half - 4);
+		for (int start = 0; start < mSize; start += 2 * half) {
+			float* ar = re + start;
+			float* ai = im + start;
+			float* br = ar + half;
+			float* bi = ai + half;
+#ifdef FFT_SSE2
+			const __m128 vSign = _mm_set1_ps(sign);
+			for (int j = 0; j < half; j += 4) {
+				__m128 wr = _mm_loadu_ps(wc + j);
+				__m128 wi = _mm_mul_ps(_mm_loadu_ps(ws + j), vSign);
+				__m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+				__m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+				__m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+				_mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+				_mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+				_mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+				_mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+			}
+#else
+			for (int j = 0; j < half; ++j) {
+				float wr = wc[j], wi = ws[j] * sign;
+				float tr = br[j] * wr - bi[j] * wi;
+				float ti = br[j] * wi + bi[j] * wr;
+				float yr = ar[j], yi = ai[j];
+				ar[j] = yr + tr;
+				ai[j] = yi + ti;
+				br[j] = yr - tr;
+				bi[j] = yi - ti;
+			}
+#endif
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// in-place complex fft of a fixed power-of-two size (at least 4), on split real and imaginary
+// arrays. the tables are built by the constructor, so a transform never allocates and may run
+// on the audio thread. neither direction scales: Inverse(Forward(x)) is x times the size
+class FFT {
+public:
+	explicit FFT(int size);
+
+	int GetSize() const { return mSize; }
+
+	void Forward(float* re, float* im) const { Transform(re, im, false); }
+	void Inverse(float* re, float* im) const { Transform(re, im, true); }
+private:
+	void Transform(float* re, float* im, bool inverse) const;
+
+	int mSize = 0;
+	std::vector<std::pair<uint32_t, uint32_t>> mSwaps; // the bit-reversal permutation
+	std::vector<float> mCos;						   // each pass's twiddles back to back, from the
+	std::vector<float> mSin;						   // pass with 4-point butterflies on: 4, 8 .. size/2
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 
 // MIDI message block data
 struct MIDIMessage {
@@ -8,3 +9,7 @@ struct MIDIMessage {
 	uint8_t data2;	// velocity
 	int frameIndex; // sample offset
 };
+
+// upper bound on live MIDI events handed to one audio block. the live queue holds this many,
+// and audio-thread scratch lists reserve it up front so they never grow in the callback
+constexpr size_t kMaxLiveMIDIEventsPerBlock = 1024;
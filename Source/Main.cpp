@@ -6,6 +6,7 @@
 #include "misc/freetype/imgui_freetype.h"
 
 #include <stdio.h>
+#include <cmath>
 #include <string>
 #include <SDL3/SDL.h>
 #if defined(IMGUI_IMPL_OPENGL_ES2)
@@ -160,6 +161,34 @@ int main(int, char**) {
 	editor.SetNativeWindowHandle(hwnd);
 
 	bool done = false;
+
+	// frame pacing: the ui redraws on input, then keeps going for a moment so hover effects,
+	// tooltips and popups settle; past that only as often as the editor asks (see
+	// Editor::GetFrameInterval), sleeping in the event queue in between instead of spinning at vsync
+	constexpr double kInputSettleSeconds = 0.6;
+	double lastInputTime = 0.0;
+	double lastFrameTime = 0.0;
+	auto now = []() { return (double)SDL_GetTicksNS() * 1e-9; };
+
+	auto handleEvent = [&](const SDL_Event& event) {
+		lastInputTime = now();
+		ImGui_ImplSDL3_ProcessEvent(&event);
+		if (event.type == SDL_EVENT_QUIT)
+			done = true;
+		if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && event.window.windowID == SDL_GetWindowID(window))
+			done = true;
+
+		if (event.type == SDL_EVENT_DROP_FILE) {
+			if (event.drop.data) {
+				editor.OnFileDrop(event.drop.data, event.drop.x, event.drop.y);
+			}
+		}
+		// drag position updates
+		if (event.type == SDL_EVENT_DROP_POSITION) {
+			editor.OnDragOver(event.drop.x, event.drop.y);
+		}
+	};
+
 #ifdef __EMSCRIPTEN__
 	io.IniFilename = nullptr;
 	EMSCRIPTEN_MAINLOOP_BEGIN
@@ -168,23 +197,14 @@ int main(int, char**) {
 #endif
 	{
 		SDL_Event event;
-		while (SDL_PollEvent(&event)) {
-			ImGui_ImplSDL3_ProcessEvent(&event);
-			if (event.type == SDL_EVENT_QUIT)
-				done = true;
-			if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && event.window.windowID == SDL_GetWindowID(window))
-				done = true;
-
-			if (event.type == SDL_EVENT_DROP_FILE) {
-				if (event.drop.data) {
-					editor.OnFileDrop(event.drop.data, event.drop.x, event.drop.y);
-				}
-			}
-			// drag position updates
-			if (event.type == SDL_EVENT_DROP_POSITION) {
-				editor.OnDragOver(event.drop.x, event.drop.y);
-			}
-		}
+#ifndef __EMSCRIPTEN__
+		double interval = now() - lastInputTime < kInputSettleSeconds ? 0.0 : editor.GetFrameInterval();
+		double wait = lastFrameTime + interval - now();
+		if (wait > 0.0 && SDL_WaitEventTimeout(&event, (Sint32)std::ceil(wait * 1000.0)))
+			handleEvent(event);
+#endif
+		while (SDL_PollEvent(&event))
+			handleEvent(event);
 
 		if (SDL_GetWindowFlags(window) & SDL_WINDOW_MINIMIZED) {
 			SDL_Delay(10);
@@ -192,6 +212,7 @@ int main(int, char**) {
 		}
 
 		SDL_GL_MakeCurrent(window, gl_context);
+		lastFrameTime = now();
 
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplSDL3_NewFrame();
@@ -10,6 +10,7 @@ float Parameter::sEditOldValue = 0.0f;
 Parameter* Parameter::sLastTouchedParameter = nullptr;
 
 std::function<void(Parameter*, float, float)> Parameter::sOnEditCommitted;
+std::function<void()> Parameter::sOnExternalEdit;
 
 void Parameter::Select() {
 	sSelectedParameter = this;
@@ -63,8 +63,19 @@ public:
 	static void NotifyExternalEdit(Parameter* param) {
 		if (param)
 			sLastTouchedParameter = param;
+		NotifyExternalStateChange();
 	}
 
+	// a plugin changed its own state with nothing on the undo stack to show for it: a knob in
+	// its editor, or a preset picked there (VST2 audioMasterUpdateDisplay / VST3 restartComponent)
+	static void NotifyExternalStateChange() {
+		if (sOnExternalEdit)
+			sOnExternalEdit();
+	}
+
+	// Editor installs this to count such edits as project changes (see Project::MarkEdited)
+	static std::function<void()> sOnExternalEdit;
+
 	// request that the editor reveal this parameter's automation lane
 	static void RequestAutomation(Parameter* param) { sAutomationRequestParameter = param; }
 protected:
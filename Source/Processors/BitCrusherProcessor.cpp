@@ -13,10 +13,11 @@ BitCrusherProcessor::BitCrusherProcessor() {
 	pDrive = AddParameter(std::make_unique<SliderParameter>("Drive dB", 0.0f, 0.0f, 30.0f));
 }
 
-void BitCrusherProcessor::PrepareToPlay(double sampleRate) {
+void BitCrusherProcessor::PrepareToPlay(double sampleRate, int maxBlockFrames) {
 	// clear states
 	mChannelStates.clear();
 	(void)sampleRate;
+	(void)maxBlockFrames;
 }
 
 void BitCrusherProcessor::Process(float* buffer, int numFrames, int numChannels,
@@ -11,7 +11,7 @@ public:
 	std::string GetProcessorId() const override { return "BitCrusher"; }
 	bool IsInstrument() const override { return false; }
 
-	void PrepareToPlay(double sampleRate) override;
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override;
 
 	void Process(float* buffer, int numFrames, int numChannels,
 				 std::vector<MIDIMessage>& mIDIMessages,
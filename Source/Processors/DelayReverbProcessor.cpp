@@ -106,7 +106,8 @@ DelayReverbProcessor::DelayReverbProcessor() {
 	pRevMix = AddParameter(std::make_unique<KnobParameter>("Mix", 0.2f, 0.0f, 1.0f));
 }
 
-void DelayReverbProcessor::PrepareToPlay(double sampleRate) {
+void DelayReverbProcessor::PrepareToPlay(double sampleRate, int maxBlockFrames) {
+	(void)maxBlockFrames;
 	mSampleRate = sampleRate;
 
 	// 2 second buffer
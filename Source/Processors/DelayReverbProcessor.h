@@ -50,7 +50,7 @@ public:
 	std::string GetProcessorId() const override { return "DelayReverb"; }
 	bool IsInstrument() const override { return false; }
 
-	void PrepareToPlay(double sampleRate) override;
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override;
 	void Reset() override;
 
 	void Process(float* buffer, int numFrames, int numChannels,
@@ -118,7 +118,8 @@ EqProcessor::EqProcessor() {
 	mSelectedBandIndex = 0;
 }
 
-void EqProcessor::PrepareToPlay(double sampleRate) {
+void EqProcessor::PrepareToPlay(double sampleRate, int maxBlockFrames) {
+	(void)maxBlockFrames;
 	mSampleRate = sampleRate;
 	mStates.clear();
 	for (int i = 0; i < kNumBands; ++i)
@@ -37,7 +37,7 @@ public:
 	const char* GetName() const override { return "EQ Eight"; }
 	std::string GetProcessorId() const override { return "EqEight"; }
 
-	void PrepareToPlay(double sampleRate) override;
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override;
 	void Reset() override;
 	void Process(float* buffer, int numFrames, int numChannels,
 				 std::vector<MIDIMessage>& mIDIMessages,
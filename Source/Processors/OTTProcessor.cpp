@@ -119,7 +119,8 @@ OTTProcessor::OTTProcessor() {
 	pHighGain = AddParameter(std::make_unique<SliderParameter>("High Gain", 0.0f, -12.0f, 12.0f));
 }
 
-void OTTProcessor::PrepareToPlay(double sampleRate) {
+void OTTProcessor::PrepareToPlay(double sampleRate, int maxBlockFrames) {
+	(void)maxBlockFrames;
 	mSampleRate = sampleRate;
 	mChannels.clear();
 }
@@ -4,7 +4,8 @@
 
 class OscillatorProcessor : public AudioProcessor {
 public:
-	void PrepareToPlay(double sampleRate) override {
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override {
+		(void)maxBlockFrames;
 		mSampleRate = sampleRate;
 	}
 
@@ -18,7 +18,8 @@ SimpleSynth::SimpleSynth() {
 	}
 }
 
-void SimpleSynth::PrepareToPlay(double sampleRate) {
+void SimpleSynth::PrepareToPlay(double sampleRate, int maxBlockFrames) {
+	(void)maxBlockFrames;
 	mSampleRate = sampleRate;
 }
 
@@ -24,7 +24,7 @@ public:
 	std::string GetProcessorId() const override { return "SimpleSynth"; }
 	bool IsInstrument() const override { return true; }
 
-	void PrepareToPlay(double sampleRate) override;
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override;
 
 	void Reset() override;
 	void AllNotesOff() override;
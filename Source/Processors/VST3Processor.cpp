@@ -293,8 +293,10 @@ Steinberg::uint32 PLUGIN_API VST3Processor::ParameterChanges::release() {
 //--- VST3HostContext ------------------------------------------------------
 
 Steinberg::Vst::IHostApplication* VST3HostContext::sInstance = nullptr;
+std::mutex VST3HostContext::sInstanceMutex;
 
 Steinberg::Vst::IHostApplication* VST3HostContext::GetInstance() {
+	std::lock_guard<std::mutex> lock(sInstanceMutex);
 	if (!sInstance) {
 		sInstance = new VST3HostContext();
 	}
@@ -302,6 +304,7 @@ Steinberg::Vst::IHostApplication* VST3HostContext::GetInstance() {
 }
 
 void VST3HostContext::Shutdown() {
+	std::lock_guard<std::mutex> lock(sInstanceMutex);
 	if (sInstance) {
 		sInstance->release();
 		sInstance = nullptr;
@@ -576,7 +579,7 @@ void VST3Processor::SetupBuses(int numChannels) {
 	}
 }
 
-void VST3Processor::PrepareToPlay(double sampleRate) {
+void VST3Processor::PrepareToPlay(double sampleRate, int maxBlockFrames) {
 	if (!mProcessor || !mComponent)
 		return;
 
@@ -585,7 +588,7 @@ void VST3Processor::PrepareToPlay(double sampleRate) {
 	Steinberg::Vst::ProcessSetup setup;
 	setup.processMode = Steinberg::Vst::kRealtime;
 	setup.symbolicSampleSize = Steinberg::Vst::kSample32;
-	setup.maxSamplesPerBlock = 512;
+	setup.maxSamplesPerBlock = maxBlockFrames;
 	setup.sampleRate = sampleRate;
 
 	mProcessor->setupProcessing(setup);
@@ -22,12 +22,15 @@
 #if defined(_WIN32)
 #include <windows.h>
 #endif
+#include <atomic>
+#include <mutex>
 
 class VST3HostContext : public Steinberg::Vst::IHostApplication {
 public:
 	VST3HostContext() = default;
 	virtual ~VST3HostContext() = default;
 
+	// shared by every plugin. created on first use; safe from any thread
 	static Steinberg::Vst::IHostApplication* GetInstance();
 	static void Shutdown();
 
@@ -37,7 +40,8 @@ public:
 	DECLARE_FUNKNOWN_METHODS
 private:
 	static Steinberg::Vst::IHostApplication* sInstance;
-	Steinberg::uint32 mRefCount = 1;
+	static std::mutex sInstanceMutex;
+	std::atomic<Steinberg::uint32> mRefCount{1}; // plugins on different threads hold it
 };
 
 class VST3ComponentHandler : public Steinberg::Vst::IComponentHandler {
@@ -63,7 +67,11 @@ public:
 		}
 		return Steinberg::kResultTrue;
 	}
-	Steinberg::tresult PLUGIN_API restartComponent(Steinberg::int32 flags) override { return Steinberg::kResultTrue; }
+	Steinberg::tresult PLUGIN_API restartComponent(Steinberg::int32 flags) override {
+		// a preset or other state change from the plugin's side
+		Parameter::NotifyExternalStateChange();
+		return Steinberg::kResultTrue;
+	}
 
 	DECLARE_FUNKNOWN_METHODS
 private:
@@ -84,7 +92,7 @@ public:
 	const std::string& GetPath() const { return mPath; }
 	const std::string& GetClassID() const { return mClassID; }
 
-	void PrepareToPlay(double sampleRate) override;
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override;
 	void Reset() override;
 	void AllNotesOff() override;
 	void Process(float* buffer, int numFrames, int numChannels,
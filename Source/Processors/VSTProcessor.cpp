@@ -215,12 +215,19 @@ void VSTProcessor::InitializeParameters() {
 	}
 }
 
-void VSTProcessor::PrepareToPlay(double sampleRate) {
+void VSTProcessor::PrepareToPlay(double sampleRate, int maxBlockFrames) {
+	mMaxBlockFrames = maxBlockFrames;
 	if (!mAEffect)
 		return;
 
 	mAEffect->dispatcher(mAEffect, effSetSampleRate, 0, 0, 0, (float)sampleRate);
-	mAEffect->dispatcher(mAEffect, effSetBlockSize, 0, 512, 0, 0.0f);
+	mAEffect->dispatcher(mAEffect, effSetBlockSize, 0, maxBlockFrames, 0, 0.0f);
+
+	// sized for the largest block up front, so Process doesn't grow them on the audio thread
+	int maxChannels = max(mAEffect->numInputs, mAEffect->numOutputs);
+	mProcessBuffer.resize((size_t)maxBlockFrames * maxChannels * 2);
+	mInputPtrs.resize(mAEffect->numInputs);
+	mOutputPtrs.resize(mAEffect->numOutputs);
 
 	Resume();
 }
@@ -751,6 +758,10 @@ VstIntPtr VSTCALLBACK VSTProcessor::HostCallback(AEffect* effect, VstInt32 opcod
 		if (proc && index >= 0 && index < (int)proc->mParameters.size())
 			proc->mParameters[index]->EndEditGesture();
 		return 1;
+	case audioMasterUpdateDisplay:
+		// the plugin changed program or state on its own, usually a preset picked in its editor
+		Parameter::NotifyExternalStateChange();
+		return 1;
 	case audioMasterGetTime:
 		if (proc) {
 			return (VstIntPtr)&proc->mTimeInfo;
@@ -759,7 +770,7 @@ VstIntPtr VSTCALLBACK VSTProcessor::HostCallback(AEffect* effect, VstInt32 opcod
 	case audioMasterGetSampleRate:
 		return 48000;
 	case audioMasterGetBlockSize:
-		return 512;
+		return proc ? proc->mMaxBlockFrames : 512;
 	case audioMasterGetCurrentProcessLevel:
 		return 2; // kVstProcessLevelRealtime
 	case audioMasterGetVendorString:
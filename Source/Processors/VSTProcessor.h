@@ -25,7 +25,7 @@ public:
 	bool IsInstrument() const override { return mIsSynth; }
 	const std::string& GetPath() const { return mPath; }
 
-	void PrepareToPlay(double sampleRate) override;
+	void PrepareToPlay(double sampleRate, int maxBlockFrames) override;
 	void Reset() override;
 	void AllNotesOff() override;
 	void Process(float* buffer, int numFrames, int numChannels,
@@ -61,6 +61,7 @@ private:
 
 	AEffect* mAEffect = nullptr;
 	VstTimeInfo mTimeInfo;
+	int mMaxBlockFrames = 512; // as last prepared, reported back through audioMasterGetBlockSize
 
 	// parameter sync tracking
 	std::vector<float> mLastSentValues;
@@ -1,5 +1,7 @@
 #include "PrecompHeader.h"
 #include "Project.h"
+#include "ProjectLoader.h"
+#include "Clips/MappedFile.h"
 #include "Processors/SimpleSynth.h"
 #include "Clips/MIDIClip.h"
 #include "Clips/AudioClip.h"
@@ -8,12 +10,49 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
-#include <functional>
+#include <thread>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
 
 // version history
 const int kCurrentProjectVersion = 1; // 1: initial format
 
+// the live engine and export both render stereo; graph buffers are sized for it
+const int kGraphChannels = 2;
+
+// blocks an offline render unrolls into one pass (fewer when the graph is too big for the
+// render pool): how far an independent track may run ahead of the master
+const int kOfflineBlocksPerPass = 8;
+
+// parks the audio callback for the lifetime of the scope. the callback raises mAudioInBlock
+// and then checks mAudioSuspended; we raise mAudioSuspended and then wait out mAudioInBlock.
+// both sides use seq_cst, so at least one of them sees the other and the callback can never
+// be inside the graph while offline work resets or re-prepares processors. the audio side
+// only ever reads a flag, so it stays wait-free
+class ScopedAudioSuspend {
+public:
+	explicit ScopedAudioSuspend(Project& project)
+		: mProject(project) {
+		mWasSuspended = mProject.mAudioSuspended.exchange(true);
+		while (mProject.mAudioInBlock.load())
+			std::this_thread::yield();
+	}
+	~ScopedAudioSuspend() {
+		if (!mWasSuspended)
+			mProject.mAudioSuspended.store(false);
+	}
+	ScopedAudioSuspend(const ScopedAudioSuspend&) = delete;
+	ScopedAudioSuspend& operator=(const ScopedAudioSuspend&) = delete;
+private:
+	Project& mProject;
+	bool mWasSuspended = false;
+};
+
 Project::Project() {
+	mChunkMIDIEvents.reserve(kMaxLiveMIDIEventsPerBlock);
+	mSliceMIDIEvents.reserve(kMaxLiveMIDIEventsPerBlock);
+	mResampleQuality.store(AppConfig::Instance().resampleQuality, std::memory_order_relaxed);
 }
 
 Project::~Project() {
@@ -26,6 +65,7 @@ void Project::Initialize() {
 	mMasterTrack = std::make_shared<Track>();
 	mMasterTrack->SetName("Master");
 	mMasterTrack->InitMasterTrackParameters(mTransport.GetBpm());
+	PublishGraphInternal();
 }
 
 void Project::CreateTrack() {
@@ -34,9 +74,10 @@ void Project::CreateTrack() {
 	track->SetName("Track " + std::to_string(mTracks.size() + 1));
 
 	if (mTransport.GetSampleRate() > 0) {
-		track->PrepareToPlay(mTransport.GetSampleRate());
+		track->PrepareToPlay(mTransport.GetSampleRate(), mMaxBlockFrames);
 	}
 	mTracks.push_back(track);
+	PublishGraphInternal();
 }
 
 void Project::RemoveTrack(int index) {
@@ -51,6 +92,7 @@ void Project::RemoveTrack(int index) {
 			}
 		}
 		mTracks.erase(mTracks.begin() + index);
+		PublishGraphInternal();
 	}
 }
 
@@ -110,6 +152,7 @@ void Project::MoveTrack(int srcIndex, int dstIndex, bool asChild) {
 		mTracks.insert(mTracks.begin() + dstIndex, srcTrack);
 	}
 	CheckEmptyGroups();
+	PublishGraphInternal();
 }
 
 void Project::GroupSelectedTracks(const std::set<int>& indices) {
@@ -162,7 +205,7 @@ void Project::GroupSelectedTracks(const std::set<int>& indices) {
 		groupTrack->SetParent(commonParent);
 
 	if (mTransport.GetSampleRate() > 0)
-		groupTrack->PrepareToPlay(mTransport.GetSampleRate());
+		groupTrack->PrepareToPlay(mTransport.GetSampleRate(), mMaxBlockFrames);
 
 	// 4. remove from list
 	// iterate reverse to preserve indices
@@ -182,6 +225,7 @@ void Project::GroupSelectedTracks(const std::set<int>& indices) {
 		mTracks.insert(mTracks.begin() + insertPos, t);
 		insertPos++;
 	}
+	PublishGraphInternal();
 }
 
 void Project::UngroupTrack(int trackIndex) {
@@ -202,6 +246,7 @@ void Project::UngroupTrack(int trackIndex) {
 		}
 	}
 	mTracks.erase(mTracks.begin() + trackIndex);
+	PublishGraphInternal();
 }
 
 void Project::CheckEmptyGroups() {
@@ -229,26 +274,82 @@ void Project::CheckEmptyGroups() {
 void Project::SetSelectedTrack(int index) {
 	std::lock_guard<std::mutex> lock(mMutex);
 	mSelectedTrackIndex = index;
+	PublishGraphInternal();
 }
 
 void Project::RestoreTracks(std::vector<std::shared_ptr<Track>> tracks) {
 	std::lock_guard<std::mutex> lock(mMutex);
 	mTracks = std::move(tracks);
+	PublishGraphInternal();
+}
+
+void Project::PublishGraph() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mTempoChangedOnAudioThread.exchange(false))
+		ValidateClipDurations(mTransport.GetBpm());
+	UpdateWarpTables(mTransport.GetSampleRate(), true);
+	PublishGraphInternal();
+}
+
+void Project::UpdateWarpTables(double sampleRate, bool freeze) {
+	// a clip whose warp params moved gets fresh tables, which the graph then picks up
+	double bpm = mTransport.GetBpm();
+	for (auto& track : mTracks) {
+		for (auto& clip : track->GetClips()) {
+			AudioClip* audioClip = clip->As<AudioClip>();
+			if (!audioClip)
+				continue;
+			audioClip->UpdateWarpTables(sampleRate, bpm);
+			if (freeze)
+				audioClip->UpdateFreeze(sampleRate, bpm);
+		}
+	}
+}
+
+void Project::PublishGraphInternal() {
+	int blockCapacity = mMaxBlockFrames * kGraphChannels;
+	if (!mGraph || !mGraph->Matches(mTracks, mMasterTrack, mSelectedTrackIndex, blockCapacity)) {
+		auto graph = RenderGraph::Build(mTracks, mMasterTrack, mSelectedTrackIndex, blockCapacity);
+		mPublishedGraph.store(graph.get());
+		if (mGraph)
+			mRetiredGraphs.push_back(std::move(mGraph));
+		mGraph = std::move(graph);
+	}
+	CollectRetiredGraphs();
+}
+
+void Project::CollectRetiredGraphs() {
+	// anything the audio thread is not pinning right now is unreachable: it re-reads
+	// mPublishedGraph after pinning, so it can never pick up a retired snapshot again
+	RenderGraph* inUse = mAudioGraphHazard.load();
+	std::erase_if(mRetiredGraphs, [inUse](const std::unique_ptr<RenderGraph>& g) {
+		return g.get() != inUse;
+	});
 }
 
-void Project::PrepareToPlayInternal(double sampleRate) {
+void Project::PrepareToPlayInternal(double sampleRate, int maxBlockFrames) {
 	mTransport.SetSampleRate(sampleRate);
 	for (auto& track : mTracks) {
-		track->PrepareToPlay(sampleRate);
+		track->PrepareToPlay(sampleRate, maxBlockFrames);
 	}
 	if (mMasterTrack)
-		mMasterTrack->PrepareToPlay(sampleRate);
+		mMasterTrack->PrepareToPlay(sampleRate, maxBlockFrames);
 	mWasPlaying = false;
 }
 
-void Project::PrepareToPlay(double sampleRate) {
+void Project::PrepareToPlay(double sampleRate, int maxBlockFrames) {
 	std::lock_guard<std::mutex> lock(mMutex);
-	PrepareToPlayInternal(sampleRate);
+	ScopedAudioSuspend suspend(*this);
+	if (maxBlockFrames > 0)
+		mMaxBlockFrames = maxBlockFrames;
+	PrepareToPlayInternal(sampleRate, mMaxBlockFrames);
+	PublishGraphInternal();
+}
+
+void Project::SetRenderThreadCount(int numWorkers, bool realtime) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	ScopedAudioSuspend suspend(*this);
+	mRenderPool.Start(numWorkers, realtime);
 }
 
 void Project::SetBpmInternal(double bpm) {
@@ -292,11 +393,13 @@ void Project::SetBpmInternal(double bpm) {
 		int64_t newLoopEnd = (int64_t)std::round(loopEndBeat * newSecondsPerBeat * sampleRate);
 		mTransport.SetLoopRange(newLoopStart, newLoopEnd);
 	}
+}
 
-	// 4. validate audio clip tempo
+void Project::ValidateClipDurations(double bpm) {
+	// validate audio clip tempo
 	for (auto& track : mTracks) {
 		for (auto& clip : track->GetClips()) {
-			if (auto ac = std::dynamic_pointer_cast<AudioClip>(clip)) {
+			if (AudioClip* ac = clip->As<AudioClip>()) {
 				ac->ValidateDuration(bpm);
 			}
 		}
@@ -306,104 +409,141 @@ void Project::SetBpmInternal(double bpm) {
 void Project::SetBpm(double bpm) {
 	std::lock_guard<std::mutex> lock(mMutex);
 	SetBpmInternal(bpm);
+	ValidateClipDurations(bpm);
 }
 
-void Project::ProcessTrackRecursively(std::shared_ptr<Track> track, float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents, bool anySolo) {
+void Project::ProcessTrackNode(const RenderGraph& graph, int trackIndex, const RenderBuffers& buffers, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents) {
+	const RenderGraphTrack& node = graph.tracks[trackIndex];
+	const auto& track = node.track;
 
-	// determine if this track is "effectively soloed".
-	// includes explicit/inheriting solo from an ancestor
-	bool ancestorSolo = false;
-	auto p = track->GetParent();
-	while (p) {
-		if (p->GetSolo()) {
-			ancestorSolo = true;
-			break;
-		}
-		p = p->GetParent();
-	}
-
-	bool isEffectiveSolo = track->GetSolo() || ancestorSolo;
-
-	// must be soloed to bypass mute
-	if (track->GetMute() && !isEffectiveSolo)
+	// children are scheduled ahead of their group, so a track under a silenced group still
+	// reaches this point; audible already accounts for the whole ancestor chain
+	if (!node.audible)
 		return;
 
-	// global check
-	if (anySolo && !isEffectiveSolo) {
-		bool childSolo = false;
-		if (track->IsGroup()) {
-			// recursively check if any descendant is soloed
-			// keep the group chain active so the signal from the deep child can bubble up
-			std::function<bool(std::shared_ptr<Track>)> hasSoloChild = [&](std::shared_ptr<Track> parent) -> bool {
-				for (const auto& t : mTracks)
-					if (t->GetParent() == parent) {
-						if (t->GetSolo())
-							return true;
-						if (t->IsGroup() && hasSoloChild(t))
-							return true;
-					}
-				return false;
-			};
-			childSolo = hasSoloChild(track);
+	float* output = buffers.Slot(node.buffer);
+	int sampleCount = numFrames * numChannels;
+	if (node.isGroup && !node.children.empty()) {
+		// every child has finished by now, and the first one rendered into this very slot.
+		// sum the others on top in project order; silenced children contribute nothing
+		if (!graph.tracks[node.children.front()].audible)
+			std::fill(output, output + sampleCount, 0.0f);
+		for (size_t c = 1; c < node.children.size(); ++c) {
+			const RenderGraphTrack& child = graph.tracks[node.children[c]];
+			if (!child.audible)
+				continue;
+			const float* childOutput = buffers.Slot(child.buffer);
+			for (int i = 0; i < sampleCount; ++i)
+				output[i] += childOutput[i];
 		}
-		if (!childSolo)
-			return;
+	} else {
+		std::fill(output, output + sampleCount, 0.0f);
 	}
 
-	if (track->IsGroup()) {
-		track->ClearAccumulator();
-		for (auto& child : mTracks) {
-			if (child->GetParent() == track) {
-				std::vector<float> childBuffer(numFrames * numChannels, 0.0f);
-				ProcessTrackRecursively(child, childBuffer.data(), numFrames, numChannels, context, liveMIDIEvents, anySolo);
-				track->AddToAccumulator(childBuffer.data(), numFrames, numChannels);
+	node.midi.clear();
+	if (trackIndex == graph.liveMIDITarget)
+		node.midi.assign(liveMIDIEvents.begin(), liveMIDIEvents.end());
+
+	track->Process(output, numFrames, numChannels, node.midi, context, node.state);
+}
+
+void Project::ProcessAudioGraph(const RenderGraph& graph, float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents) {
+	// a block longer than the graph's buffers were sized for (the device changed its buffer
+	// size) is rendered in slices rather than growing them on the audio thread
+	int maxFrames = graph.blockCapacity / numChannels;
+	if (numFrames > maxFrames && maxFrames > 0) {
+		for (int offset = 0; offset < numFrames; offset += maxFrames) {
+			int slice = std::min(maxFrames, numFrames - offset);
+			ProcessContext sliceContext = context;
+			sliceContext.currentSample += offset;
+			sliceContext.playheadJumped = context.playheadJumped && offset == 0;
+
+			mSliceMIDIEvents.clear();
+			for (const auto& msg : liveMIDIEvents) {
+				if (msg.frameIndex >= offset && msg.frameIndex < offset + slice) {
+					MIDIMessage rebased = msg;
+					rebased.frameIndex -= offset;
+					mSliceMIDIEvents.push_back(rebased);
+				}
 			}
+			ProcessAudioGraph(graph, destinationBuffer + offset * numChannels, slice, numChannels, sliceContext, mSliceMIDIEvents);
 		}
+		return;
 	}
 
-	std::vector<float> processBuffer(numFrames * numChannels, 0.0f);
-	std::vector<MIDIMessage> trackMIDI;
-	int trackIdx = -1;
-	for (int i = 0; i < (int)mTracks.size(); ++i)
-		if (mTracks[i] == track)
-			trackIdx = i;
+	struct TrackNodeRunner final : RenderNodeRunner {
+		TrackNodeRunner(Project& project, const RenderGraph& graph, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents)
+			: project(project), graph(graph), buffers(graph.GetBuffers()), numFrames(numFrames), numChannels(numChannels), context(context), liveMIDIEvents(liveMIDIEvents) {}
+		void RunNode(int nodeIndex) override {
+			project.ProcessTrackNode(graph, nodeIndex, buffers, numFrames, numChannels, context, liveMIDIEvents);
+		}
+		Project& project;
+		const RenderGraph& graph;
+		RenderBuffers buffers;
+		int numFrames;
+		int numChannels;
+		const ProcessContext& context;
+		const std::vector<MIDIMessage>& liveMIDIEvents;
+	};
+
+	// every track, children before groups, spread over the render pool
+	TrackNodeRunner runner(*this, graph, numFrames, numChannels, context, liveMIDIEvents);
+	mRenderPool.Execute(graph.schedule, runner);
+
+	ProcessMasterNode(graph, graph.GetBuffers(), destinationBuffer, numFrames, numChannels, context);
+}
 
-	if (trackIdx == mSelectedTrackIndex && track->HasInstrument()) {
-		trackMIDI = liveMIDIEvents;
+void Project::ProcessMasterNode(const RenderGraph& graph, const RenderBuffers& buffers, float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context) {
+	// the roots head their slot chains, so their buffers are still intact
+	int sampleCount = numFrames * numChannels;
+	std::fill(destinationBuffer, destinationBuffer + sampleCount, 0.0f);
+	for (int root : graph.roots) {
+		const RenderGraphTrack& node = graph.tracks[root];
+		if (!node.audible)
+			continue;
+		const float* output = buffers.Slot(node.buffer);
+		for (int i = 0; i < sampleCount; ++i)
+			destinationBuffer[i] += output[i];
 	}
 
-	track->Process(processBuffer.data(), numFrames, numChannels, trackMIDI, context);
-
-	for (int i = 0; i < numFrames * numChannels; ++i) {
-		destinationBuffer[i] += processBuffer[i];
+	if (graph.master.track) {
+		graph.master.midi.clear();
+		graph.master.track->Process(destinationBuffer, numFrames, numChannels, graph.master.midi, context, graph.master.state, false);
 	}
 }
 
-void Project::ProcessAudioGraph(float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents, bool anySolo) {
-	if (mMixBuffer.size() < (size_t)(numFrames * numChannels)) {
-		mMixBuffer.resize(numFrames * numChannels);
+void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels, std::vector<MIDIMessage>& liveMIDIEvents) {
+	// audio half of the ScopedAudioSuspend handshake: while offline work owns the
+	// processors the callback just leaves the (already cleared) output silent
+	mAudioInBlock.store(true);
+	if (mAudioSuspended.load()) {
+		mAudioInBlock.store(false);
+		return;
 	}
-	std::fill(mMixBuffer.begin(), mMixBuffer.begin() + (numFrames * numChannels), 0.0f);
 
-	for (auto& track : mTracks) {
-		if (track->GetParent() == nullptr) {
-			ProcessTrackRecursively(track, mMixBuffer.data(), numFrames, numChannels, context, liveMIDIEvents, anySolo);
-		}
+	// pin the published snapshot in the hazard slot, then re-check that it is still the
+	// published one. once that holds, the UI thread cannot retire it under us
+	RenderGraph* pinned = mPublishedGraph.load();
+	for (;;) {
+		mAudioGraphHazard.store(pinned);
+		RenderGraph* current = mPublishedGraph.load();
+		if (current == pinned)
+			break;
+		pinned = current;
 	}
 
-	if (mMasterTrack) {
-		for (int i = 0; i < numFrames * numChannels; ++i)
-			destinationBuffer[i] = mMixBuffer[i];
-		std::vector<MIDIMessage> emptyMIDI;
-		mMasterTrack->Process(destinationBuffer, numFrames, numChannels, emptyMIDI, context, false);
-	} else {
-		for (int i = 0; i < numFrames * numChannels; ++i)
-			destinationBuffer[i] = mMixBuffer[i];
-	}
-}
+	// unpin on every exit path
+	struct BlockExit {
+		Project& project;
+		~BlockExit() {
+			project.mAudioGraphHazard.store(nullptr);
+			project.mAudioInBlock.store(false);
+		}
+	} blockExit{*this};
 
-void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels, std::vector<MIDIMessage>& liveMIDIEvents) {
-	std::lock_guard<std::mutex> lock(mMutex);
+	if (!pinned)
+		return;
+	const RenderGraph& graph = *pinned;
 
 	bool isPlaying = mTransport.IsPlaying();
 	int64_t blockStartSample = mTransport.GetPosition();
@@ -418,10 +558,10 @@ void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels,
 	bool startedPlaying = !mWasPlaying && isPlaying;
 	bool seeked = isPlaying && mLastBlockEndSample >= 0 && blockStartSample != mLastBlockEndSample;
 	if (stopped || seeked) {
-		for (auto& track : mTracks)
-			track->Reset();
-		if (mMasterTrack)
-			mMasterTrack->Reset();
+		for (auto& node : graph.tracks)
+			node.track->Reset(node.state);
+		if (graph.master.track)
+			graph.master.track->Reset(graph.master.state);
 	}
 	mWasPlaying = isPlaying;
 
@@ -430,34 +570,28 @@ void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels,
 	// on the block where we just started or jumped, tell the sequencer to chase those onsets
 	bool playheadJumped = startedPlaying || seeked;
 
-	if (mMasterTrack) {
-		if (auto bpmParam = mMasterTrack->GetBpmParameter()) {
+	if (const auto& masterTrack = graph.master.track) {
+		if (auto bpmParam = masterTrack->GetBpmParameter()) {
 			double newBpm = bpmParam->value;
 			if (std::abs(newBpm - mTransport.GetBpm()) > 0.001) {
 				SetBpmInternal(newBpm);
+				mTempoChangedOnAudioThread.store(true);
 			}
 		}
 
 		if (isPlaying) {
 			double currentBeat = (double)mTransport.GetPosition() / mTransport.GetSampleRate() * (mTransport.GetBpm() / 60.0);
-			mMasterTrack->EvaluateAutomation(currentBeat);
-			if (auto bpmParam = mMasterTrack->GetBpmParameter()) {
+			Track::EvaluateAutomation(graph.master.state, currentBeat);
+			if (auto bpmParam = masterTrack->GetBpmParameter()) {
 				double newBpm = bpmParam->value;
 				if (std::abs(newBpm - mTransport.GetBpm()) > 0.001) {
 					SetBpmInternal(newBpm);
+					mTempoChangedOnAudioThread.store(true);
 				}
 			}
 		}
 	}
 
-	bool anySolo = false;
-	for (auto& track : mTracks) {
-		if (track->GetSolo()) {
-			anySolo = true;
-			break;
-		}
-	}
-
 	// looping logic
 	if (isPlaying && mTransport.IsLoopEnabled()) {
 		int64_t currentPos = mTransport.GetPosition();
@@ -471,7 +605,8 @@ void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels,
 			context.bpm = mTransport.GetBpm();
 			context.isPlaying = isPlaying;
 			context.playheadJumped = playheadJumped;
-			ProcessAudioGraph(outputBuffer, numFrames, numChannels, context, liveMIDIEvents, anySolo);
+			context.resampleQuality = mResampleQuality.load(std::memory_order_relaxed);
+			ProcessAudioGraph(graph, outputBuffer, numFrames, numChannels, context, liveMIDIEvents);
 			mTransport.Advance(numFrames);
 			mLastBlockEndSample = mTransport.GetPosition();
 			return;
@@ -490,10 +625,10 @@ void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels,
 				// a note held across the loop end has its note-off past loopEnd, which we jump
 				// away from, so it would stick. flush held notes on the wrap (notes only, to
 				// keep effect delay/reverb tails ringing seamlessly across the loop point)
-				for (auto& track : mTracks)
-					track->AllNotesOff();
-				if (mMasterTrack)
-					mMasterTrack->AllNotesOff();
+				for (auto& node : graph.tracks)
+					node.track->AllNotesOff(node.state);
+				if (graph.master.track)
+					graph.master.track->AllNotesOff(graph.master.state);
 			}
 
 			int64_t framesUntilLoopEnd = loopEnd - pos;
@@ -510,10 +645,21 @@ void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels,
 			// a wrapped chunk restarts at the loop start, and the very first chunk begins at a
 			// jumped-to position; both are jumps that should chase onsets rounding just before them
 			context.playheadJumped = wrapped || (framesProcessed == 0 && playheadJumped);
+			context.resampleQuality = mResampleQuality.load(std::memory_order_relaxed);
+
+			// live events carry real frame offsets, so each chunk gets the ones that land
+			// inside it, rebased to the chunk start
+			mChunkMIDIEvents.clear();
+			for (const auto& msg : liveMIDIEvents) {
+				if (msg.frameIndex >= framesProcessed && msg.frameIndex < framesProcessed + chunk) {
+					MIDIMessage rebased = msg;
+					rebased.frameIndex -= framesProcessed;
+					mChunkMIDIEvents.push_back(rebased);
+				}
+			}
 
 			float* outPtr = outputBuffer + (framesProcessed * numChannels); // offset output
-			// mIDI frame timing warning: splitting MIDI during wrap is complex
-			ProcessAudioGraph(outPtr, chunk, numChannels, context, (framesProcessed == 0 ? liveMIDIEvents : std::vector<MIDIMessage>{}), anySolo);
+			ProcessAudioGraph(graph, outPtr, chunk, numChannels, context, mChunkMIDIEvents);
 
 			mTransport.Advance(chunk);
 			framesProcessed += chunk;
@@ -526,33 +672,53 @@ void Project::ProcessBlock(float* outputBuffer, int numFrames, int numChannels,
 		context.bpm = mTransport.GetBpm();
 		context.isPlaying = isPlaying;
 		context.playheadJumped = playheadJumped;
+		context.resampleQuality = mResampleQuality.load(std::memory_order_relaxed);
 
-		ProcessAudioGraph(outputBuffer, numFrames, numChannels, context, liveMIDIEvents, anySolo);
+		ProcessAudioGraph(graph, outputBuffer, numFrames, numChannels, context, liveMIDIEvents);
 		mTransport.Advance(numFrames);
 	}
 
 	mLastBlockEndSample = mTransport.GetPosition();
 }
 
-struct WavHeader {
-	char riff[4] = {'R', 'I', 'F', 'F'};
-	uint32_t overallSize = 0;
-	char wave[4] = {'W', 'A', 'V', 'E'};
-	char fmt[4] = {'f', 'm', 't', ' '};
-	uint32_t fmtChunkSize = 16;
-	uint16_t formatType = 1;
-	uint16_t channels = 2;
-	uint32_t sampleRate = 44100;
-	uint32_t byteRate = 0;
-	uint16_t blockAlign = 0;
-	uint16_t bitsPerSample = 16;
-	char data[4] = {'d', 'a', 't', 'a'};
-	uint32_t dataSize = 0;
-};
+std::string GetStemPath(const std::string& mixPath, int trackIndex, const std::string& trackName) {
+	std::filesystem::path mix(mixPath);
+	std::string name;
+	for (char c : trackName) {
+		if (strchr("<>:\"/\\|?*", c) == nullptr && (unsigned char)c >= 32)
+			name += c;
+	}
+	char prefix[16];
+	snprintf(prefix, sizeof(prefix), " - %02d ", trackIndex + 1);
+	std::string file = mix.stem().string() + prefix + name + mix.extension().string();
+	return (mix.parent_path() / file).string();
+}
 
-bool Project::RenderAudio(const std::string& path, double startBeat, double endBeat, double sampleRate) {
+std::vector<RenderStem> Project::GetStems(const std::string& mixPath, bool topLevelOnly) {
 	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<RenderStem> stems;
+	for (int i = 0; i < (int)mTracks.size(); ++i) {
+		if (!topLevelOnly || !mTracks[i]->GetParent())
+			stems.push_back({i, GetStemPath(mixPath, i, mTracks[i]->GetName())});
+	}
+	return stems;
+}
 
+bool Project::RenderAudio(const std::string& path, const RenderSettings& settings, RenderProgress* progress) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	ScopedAudioSuspend suspend(*this);
+
+	// render from a snapshot of the current model, the same way the audio thread does, with
+	// warp tables (and vocoders) made for the export's rate. freezes are left as they are: an
+	// export renders live, and playback picks them up again after
+	double sampleRate = settings.sampleRate;
+	UpdateWarpTables(sampleRate, false);
+	PublishGraphInternal();
+	const RenderGraph& graph = *mGraph;
+
+	int blockSize = std::clamp(settings.blockSize, 1, RenderSettings::kMaxBlockSize);
+	double startBeat = settings.startBeat;
+	double endBeat = settings.endBeat;
 	if (endBeat <= startBeat) { // detect max duration
 		endBeat = 0.0;
 		for (const auto& t : mTracks) {
@@ -574,20 +740,52 @@ bool Project::RenderAudio(const std::string& path, double startBeat, double endB
 	int64_t totalFrames = (int64_t)(seconds * sampleRate);
 	int64_t startFrame = (int64_t)(startBeat * (60.0 / mTransport.GetBpm()) * sampleRate);
 
-	std::ofstream outFile(path, std::ios::binary);
-	if (!outFile.is_open())
+	WavFormat format;
+	format.sampleRate = (uint32_t)sampleRate;
+	format.channels = 2;
+	format.sampleFormat = settings.sampleFormat;
+	format.dither = settings.dither;
+
+	// the mix and every stem stream through their own writer thread, so conversion and disk
+	// io run alongside the next pass instead of after it
+	struct RenderOutput {
+		std::string path;
+		std::unique_ptr<AsyncWavWriter> writer;
+	};
+	std::vector<RenderOutput> outputs;
+	auto discardOutputs = [&outputs]() {
+		for (RenderOutput& output : outputs) {
+			output.writer->Close();
+			std::error_code ec;
+			std::filesystem::remove(output.path, ec); // a partial file would look like a finished one
+		}
+	};
+	auto openOutput = [&outputs, &format](const std::string& outputPath) {
+		auto writer = std::make_unique<AsyncWavWriter>();
+		if (!writer->Open(outputPath, format))
+			return false;
+		outputs.push_back({outputPath, std::move(writer)});
+		return true;
+	};
+
+	bool writeMix = !path.empty();
+	if (writeMix && !openOutput(path))
 		return false;
 
-	WavHeader header;
-	header.sampleRate = (uint32_t)sampleRate;
-	header.channels = 2;
-	header.bitsPerSample = 16;
-	header.blockAlign = header.channels * (header.bitsPerSample / 8);
-	header.byteRate = header.sampleRate * header.blockAlign;
-	header.dataSize = (uint32_t)(totalFrames * header.blockAlign);
-	header.overallSize = header.dataSize + 36;
-
-	outFile.write((char*)&header, sizeof(WavHeader));
+	// track index -> its stem's slot in stemBuffers; a track asked for twice is written once
+	std::vector<int> stemOfTrack(graph.tracks.size(), -1);
+	int numStems = 0;
+	for (const RenderStem& stem : settings.stems) {
+		if (stem.trackIndex < 0 || stem.trackIndex >= (int)graph.tracks.size() || stemOfTrack[stem.trackIndex] >= 0)
+			continue;
+		if (!openOutput(stem.path)) {
+			discardOutputs();
+			return false;
+		}
+		stemOfTrack[stem.trackIndex] = numStems++;
+	}
+	if (outputs.empty())
+		return false;
 
 	// save transport state
 	double oldSR = mTransport.GetSampleRate();
@@ -601,72 +799,175 @@ bool Project::RenderAudio(const std::string& path, double startBeat, double endB
 	mTransport.SetPlaying(true);
 	mTransport.SetLoopEnabled(false); // disable looping
 
-	PrepareToPlayInternal(sampleRate);
-	for (auto& track : mTracks) {
-		track->Reset();
-	}
-	if (mMasterTrack)
-		mMasterTrack->Reset();
-
-	const int blockSize = 512;
-	std::vector<float> blockBuffer(blockSize * 2);
-	std::vector<int16_t> intBuffer(blockSize * 2);
+	// the plugins are told the export's block size, which is larger than a device buffer
+	PrepareToPlayInternal(sampleRate, blockSize);
+	for (auto& node : graph.tracks)
+		node.track->Reset(node.state);
+	if (graph.master.track)
+		graph.master.track->Reset(graph.master.state);
+
+	// offline there is no deadline to meet, so a pass renders several blocks at once: the
+	// graph is unrolled over them and each track only waits for its own previous block and
+	// its children, letting independent tracks run ahead on every core. tempo stays fixed
+	// for the whole export, so no track depends on another's timeline
+	const int numChannels = 2;
+	int stride = graph.GetUnrolledStride();
+	int blocksPerPass = std::clamp(RenderThreadPool::kMaxNodes / stride, 1, kOfflineBlocksPerPass);
+	RenderSchedule fullPass = graph.Unroll(blocksPerPass);
+	RenderSchedule lastPass;
+
+	size_t blockSamples = (size_t)blockSize * numChannels;
+	size_t passStride = (size_t)graph.numBuffers * blockSamples; // node buffers of one block
+	std::vector<float> nodeBuffers(passStride * blocksPerPass);
+	std::vector<float> passBuffer(blockSamples * blocksPerPass);
+	size_t stemStride = blockSamples * blocksPerPass;
+	std::vector<float> stemBuffers(stemStride * numStems);
 	std::vector<MIDIMessage> emptyMIDI;
 
+	struct OfflineNodeRunner final : RenderNodeRunner {
+		void RunNode(int nodeIndex) override {
+			int block = nodeIndex / stride;
+			int track = nodeIndex % stride;
+			RenderBuffers buffers{nodeBuffers + passStride * block, blockSamples};
+
+			ProcessContext context;
+			context.sampleRate = sampleRate;
+			context.currentSample = passStartSample + (int64_t)block * blockSize;
+			context.bpm = bpm;
+			context.isPlaying = true;
+			// the export begins at startFrame; chase onsets that round to just before it
+			context.playheadJumped = firstPass && block == 0;
+			context.isOffline = true;
+			context.resampleQuality = resampleQuality;
+
+			int frames = (int)std::min<int64_t>(blockSize, passFrames - (int64_t)block * blockSize);
+			if (track == stride - 1) {
+				project->ProcessMasterNode(*graph, buffers, passBuffer + blockSamples * block, frames, numChannels, context);
+				return;
+			}
+			project->ProcessTrackNode(*graph, track, buffers, frames, numChannels, context, *emptyMIDI);
+
+			// tap the post-fader output now: a group reuses its first child's slot and
+			// overwrites it as soon as this node's dependents run
+			int stem = stemOfTrack[track];
+			if (stem < 0)
+				return;
+			const RenderGraphTrack& node = graph->tracks[track];
+			float* tap = stemBuffers + stemStride * stem + blockSamples * block;
+			int sampleCount = frames * numChannels;
+			if (node.audible && node.buffer >= 0)
+				std::copy_n(buffers.Slot(node.buffer), sampleCount, tap);
+			else
+				std::fill_n(tap, sampleCount, 0.0f);
+		}
+		Project* project;
+		const RenderGraph* graph;
+		const std::vector<MIDIMessage>* emptyMIDI;
+		const int* stemOfTrack;
+		float* nodeBuffers;
+		float* passBuffer;
+		float* stemBuffers;
+		size_t passStride;
+		size_t stemStride;
+		size_t blockSamples;
+		int stride;
+		int blockSize;
+		int numChannels;
+		double sampleRate;
+		double bpm;
+		ResampleQuality resampleQuality;
+		int64_t passStartSample = 0;
+		int64_t passFrames = 0;
+		bool firstPass = true;
+	} runner;
+	runner.project = this;
+	runner.graph = &graph;
+	runner.emptyMIDI = &emptyMIDI;
+	runner.stemOfTrack = stemOfTrack.data();
+	runner.nodeBuffers = nodeBuffers.data();
+	runner.passBuffer = passBuffer.data();
+	runner.stemBuffers = stemBuffers.data();
+	runner.passStride = passStride;
+	runner.stemStride = stemStride;
+	runner.blockSamples = blockSamples;
+	runner.stride = stride;
+	runner.blockSize = blockSize;
+	runner.numChannels = numChannels;
+	runner.sampleRate = sampleRate;
+	runner.bpm = mTransport.GetBpm();
+	runner.resampleQuality = settings.resampleQuality;
+
 	int64_t framesRemaining = totalFrames;
-	bool anySolo = false;
-	for (auto& track : mTracks) {
-		if (track->GetSolo()) {
-			anySolo = true;
+	bool cancelled = false;
+	bool writeFailed = false;
+	while (framesRemaining > 0 && !writeFailed) {
+		if (progress && progress->cancelRequested.load()) {
+			cancelled = true;
 			break;
 		}
-	}
-
-	bool firstRenderBlock = true;
-	while (framesRemaining > 0) {
-		int framesToDo = (framesRemaining > blockSize) ? blockSize : (int)framesRemaining;
 
-		ProcessContext context;
-		context.sampleRate = sampleRate;
-		context.currentSample = mTransport.GetPosition();
-		context.bpm = mTransport.GetBpm();
-		context.isPlaying = true;
-		// the export begins at startFrame; chase onsets that round to just before it
-		context.playheadJumped = firstRenderBlock;
-		firstRenderBlock = false;
-
-		std::fill(blockBuffer.begin(), blockBuffer.end(), 0.0f);
-		ProcessAudioGraph(blockBuffer.data(), framesToDo, 2, context, emptyMIDI, anySolo);
-		mTransport.Advance(framesToDo);
-
-		// float to int16 conversion
-		for (int i = 0; i < framesToDo * 2; ++i) {
-			float val = blockBuffer[i];
-			if (val > 1.0f)
-				val = 1.0f;
-			if (val < -1.0f)
-				val = -1.0f;
-			intBuffer[i] = (int16_t)(val * 32767.0f);
+		int64_t passFrames = std::min<int64_t>(framesRemaining, (int64_t)blockSize * blocksPerPass);
+		int passBlocks = (int)((passFrames + blockSize - 1) / blockSize);
+		const RenderSchedule* schedule = &fullPass;
+		if (passBlocks < blocksPerPass) {
+			lastPass = graph.Unroll(passBlocks);
+			schedule = &lastPass;
 		}
 
-		outFile.write((char*)intBuffer.data(), framesToDo * 2 * sizeof(int16_t));
-		framesRemaining -= framesToDo;
+		runner.passStartSample = mTransport.GetPosition();
+		runner.passFrames = passFrames;
+		mRenderPool.Execute(*schedule, runner);
+		runner.firstPass = false;
+		mTransport.Advance((int)passFrames);
+
+		for (size_t i = 0; i < outputs.size(); ++i) {
+			size_t stem = i - (writeMix ? 1 : 0); // outputs hold the mix first, then the stems
+			const float* source = writeMix && i == 0 ? passBuffer.data() : stemBuffers.data() + stemStride * stem;
+			if (!outputs[i].writer->Write(source, passFrames))
+				writeFailed = true;
+		}
+		if (writeFailed)
+			break;
+		framesRemaining -= passFrames;
+		if (progress)
+			progress->fraction.store((float)(totalFrames - framesRemaining) / (float)totalFrames);
 	}
 
 	mTransport.SetSampleRate(oldSR);
 	mTransport.SetPosition(oldPos);
 	mTransport.SetPlaying(oldPlaying);
 	mTransport.SetLoopEnabled(oldLoop);
-	PrepareToPlayInternal(oldSR); // internal sr reset
+	PrepareToPlayInternal(oldSR, mMaxBlockFrames); // back to the device's rate and buffer
 
+	bool written = framesRemaining == 0;
+	for (RenderOutput& output : outputs)
+		written = output.writer->Close() && written;
+	if (cancelled || !written) {
+		discardOutputs();
+		return false;
+	}
 	return true;
 }
 
-void Project::Save(const std::string& path) {
-	std::lock_guard<std::mutex> lock(mMutex);
-	std::ofstream out(path);
+void Project::Save(const std::string& path, ProjectFileFormat format) {
+	if (format == ProjectFileFormat::Text) {
+		std::ofstream out(path);
+		if (!out.is_open())
+			return;
+		Save(out);
+		return;
+	}
+
+	ChunkWriter writer;
+	Save(writer);
+	std::ofstream out(path, std::ios::binary);
 	if (!out.is_open())
 		return;
+	out.write((const char*)writer.GetData().data(), (std::streamsize)writer.GetData().size());
+}
+
+void Project::Save(std::ostream& out) {
+	std::lock_guard<std::mutex> lock(mMutex);
 
 	out << "PROJECT_BEGIN\n";
 	out << "VERSION " << kCurrentProjectVersion << "\n";
@@ -710,15 +1011,135 @@ void Project::Save(const std::string& path) {
 	out << "PROJECT_END\n";
 }
 
-void Project::Load(const std::string& path) {
+void Project::Save(ChunkWriter& out, ProcessorStateCache* cache) {
 	std::lock_guard<std::mutex> lock(mMutex);
+
+	out.WriteHeader();
+
+	double sR = mTransport.GetSampleRate() > 0 ? mTransport.GetSampleRate() : 48000.0;
+	double beatsPerSec = mTransport.GetBpm() / 60.0;
+
+	out.Begin(ProjectChunk::Project);
+	out.Write<double>(mTransport.GetBpm());
+	out.Write<double>((double)mTransport.GetPosition() / sR * beatsPerSec);
+	out.Write<uint8_t>(mTransport.IsLoopEnabled() ? 1 : 0);
+	out.Write<double>((double)mTransport.GetLoopStart() / sR * beatsPerSec);
+	out.Write<double>((double)mTransport.GetLoopEnd() / sR * beatsPerSec);
+	out.End();
+
+	out.Begin(ProjectChunk::View);
+	out.Write<float>(mViewState.pixelsPerBeat);
+	out.Write<double>(mViewState.selectionStart);
+	out.Write<double>(mViewState.selectionEnd);
+	out.Write<float>(mViewState.scrollX);
+	out.Write<float>(mViewState.scrollY);
+	out.Write<int32_t>(mViewState.timelineGridNumerator);
+	out.Write<int32_t>(mViewState.timelineGridDenominator);
+	out.End();
+
+	for (auto& track : mTracks) {
+		int parentIndex = -1;
+		if (auto parent = track->GetParent()) {
+			auto it = std::find(mTracks.begin(), mTracks.end(), parent);
+			if (it != mTracks.end())
+				parentIndex = (int)(it - mTracks.begin());
+		}
+		out.Begin(ProjectChunk::Track);
+		track->Save(out, parentIndex, cache);
+		out.End();
+	}
+
+	if (mMasterTrack) {
+		out.Begin(ProjectChunk::Master);
+		mMasterTrack->Save(out, -1, cache);
+		out.End();
+	}
+}
+
+bool Project::Load(const std::string& path) {
+	ProjectLoader loader;
+	if (!BeginLoad(path, loader))
+		return false;
+	loader.Start();
+	loader.Wait();
+	ApplyLoadedAssets(loader);
+	return true;
+}
+
+bool Project::Load(std::istream& in) {
+	ProjectLoader loader;
+	if (!BeginLoad(in, loader))
+		return false;
+	loader.Start();
+	loader.Wait();
+	ApplyLoadedAssets(loader);
+	return true;
+}
+
+bool Project::Load(const uint8_t* data, size_t size) {
+	ProjectLoader loader;
+	if (!BeginLoad(data, size, loader))
+		return false;
+	loader.Start();
+	loader.Wait();
+	ApplyLoadedAssets(loader);
+	return true;
+}
+
+bool Project::BeginLoad(const std::string& path, ProjectLoader& loader) {
+	// a binary project is parsed straight out of the mapping; strings and note lists are
+	// copied out as they're read, so the mapping only lives as long as the parse
+	if (auto mapped = MappedFile::Open(path)) {
+		if (IsBinaryProject(mapped->GetData(), (size_t)mapped->GetSize()))
+			return BeginLoad(mapped->GetData(), (size_t)mapped->GetSize(), loader);
+	}
+
+	// the text format, kept for projects from before the binary one and for hand editing
 	std::ifstream in(path);
 	if (!in.is_open())
-		return;
+		return false;
+	return BeginLoad(in, loader);
+}
+
+void Project::ApplyLoadedAssets(ProjectLoader& loader) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (loader.Apply(mTransport.GetSampleRate(), mMaxBlockFrames) > 0)
+		PublishGraphInternal();
+}
 
+void Project::ResetForLoad() {
 	mTracks.clear();
 	if (mMasterTrack)
 		mMasterTrack->Reset();
+	mViewState = ProjectViewState(); // reset to default
+}
+
+void Project::FinishLoad(double playheadBeat, double loopStartBeat, double loopEndBeat, bool loopEnabled) {
+	for (auto& t : mTracks) {
+		t->RebindAutomation();
+		if (t->mLoadedParentIndex != -1 && t->mLoadedParentIndex < (int)mTracks.size()) {
+			t->SetParent(mTracks[t->mLoadedParentIndex]);
+		}
+	}
+	if (mMasterTrack)
+		mMasterTrack->RebindAutomation();
+
+	double sR = mTransport.GetSampleRate() > 0 ? mTransport.GetSampleRate() : 48000.0;
+	double secsPerBeat = 60.0 / mTransport.GetBpm();
+
+	mTransport.SetPosition((int64_t)(playheadBeat * secsPerBeat * sR));
+	mTransport.SetLoopRange((int64_t)(loopStartBeat * secsPerBeat * sR), (int64_t)(loopEndBeat * secsPerBeat * sR));
+	mTransport.SetLoopEnabled(loopEnabled);
+
+	PublishGraphInternal();
+}
+
+bool Project::BeginLoad(std::istream& in, ProjectLoader& loader) {
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// the old master keeps its processors across the load, and they get reset below
+	ScopedAudioSuspend suspend(*this);
+	ResetForLoad();
 
 	std::string line;
 	int version = 0;
@@ -728,8 +1149,6 @@ void Project::Load(const std::string& path) {
 	double loadedLoopEndBeat = 4.0;
 	bool loadedLoopEn = false;
 
-	mViewState = ProjectViewState(); // reset to default
-
 	while (std::getline(in, line)) {
 		if (line == "PROJECT_END")
 			break;
@@ -770,19 +1189,25 @@ void Project::Load(const std::string& path) {
 			ss >> mViewState.timelineGridDenominator;
 		} else if (token == "TRACK_BEGIN") {
 			auto t = std::make_shared<Track>();
-			t->Load(in);
+			std::vector<TrackLoadJob> deferred;
+			t->Load(in, &deferred);
 			if (mTransport.GetSampleRate() > 0)
-				t->PrepareToPlay(mTransport.GetSampleRate());
+				t->PrepareToPlay(mTransport.GetSampleRate(), mMaxBlockFrames);
+			for (auto& job : deferred)
+				loader.Add(t, std::move(job));
 			mTracks.push_back(t);
 		} else if (token == "MASTER_BEGIN") {
 			mMasterTrack = std::make_shared<Track>();
 			mMasterTrack->SetName("Master");
 			mMasterTrack->InitMasterTrackParameters(mTransport.GetBpm());
-			mMasterTrack->Load(in); // master track scope
+			std::vector<TrackLoadJob> deferred;
+			mMasterTrack->Load(in, &deferred); // master track scope
 			std::string endTag;
 			std::getline(in, endTag); // consume MASTER_END
 			if (mTransport.GetSampleRate() > 0)
-				mMasterTrack->PrepareToPlay(mTransport.GetSampleRate());
+				mMasterTrack->PrepareToPlay(mTransport.GetSampleRate(), mMaxBlockFrames);
+			for (auto& job : deferred)
+				loader.Add(mMasterTrack, std::move(job));
 		} else if (token == "PARENT_IDX") {
 			int pIdx = -1;
 			ss >> pIdx;
@@ -792,19 +1217,67 @@ void Project::Load(const std::string& path) {
 		}
 	}
 
-	for (auto& t : mTracks) {
-		t->RebindAutomation();
-		if (t->mLoadedParentIndex != -1 && t->mLoadedParentIndex < (int)mTracks.size()) {
-			t->SetParent(mTracks[t->mLoadedParentIndex]);
-		}
+	FinishLoad(loadedPlayheadBeat, loadedLoopStartBeat, loadedLoopEndBeat, loadedLoopEn);
+	return true;
+}
+
+bool Project::BeginLoad(const uint8_t* data, size_t size, ProjectLoader& loader) {
+	ChunkReader chunks;
+	if (!ChunkReader::OpenFile(data, size, chunks))
+		return false;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	ScopedAudioSuspend suspend(*this);
+	ResetForLoad();
+
+	double loadedPlayheadBeat = 0.0;
+	double loadedLoopStartBeat = 0.0;
+	double loadedLoopEndBeat = 4.0;
+	bool loadedLoopEn = false;
+
+	// settings first wherever they sit: the master's tempo parameter is built from the bpm
+	ChunkReader settings;
+	if (chunks.Find(ProjectChunk::Project, settings)) {
+		mTransport.SetBpm(settings.Read<double>(mTransport.GetBpm()));
+		loadedPlayheadBeat = settings.Read<double>(loadedPlayheadBeat);
+		loadedLoopEn = settings.Read<uint8_t>(loadedLoopEn) != 0;
+		loadedLoopStartBeat = settings.Read<double>(loadedLoopStartBeat);
+		loadedLoopEndBeat = settings.Read<double>(loadedLoopEndBeat);
 	}
-	if (mMasterTrack)
-		mMasterTrack->RebindAutomation();
 
-	double sR = mTransport.GetSampleRate() > 0 ? mTransport.GetSampleRate() : 48000.0;
-	double secsPerBeat = 60.0 / mTransport.GetBpm();
+	ChunkReader chunk;
+	uint32_t id = 0;
+	while (chunks.Next(id, chunk)) {
+		if (id == ProjectChunk::View) {
+			mViewState.pixelsPerBeat = chunk.Read<float>(mViewState.pixelsPerBeat);
+			mViewState.selectionStart = chunk.Read<double>(mViewState.selectionStart);
+			mViewState.selectionEnd = chunk.Read<double>(mViewState.selectionEnd);
+			mViewState.scrollX = chunk.Read<float>(mViewState.scrollX);
+			mViewState.scrollY = chunk.Read<float>(mViewState.scrollY);
+			mViewState.timelineGridNumerator = chunk.Read<int32_t>(mViewState.timelineGridNumerator);
+			mViewState.timelineGridDenominator = chunk.Read<int32_t>(mViewState.timelineGridDenominator);
+		} else if (id == ProjectChunk::Track) {
+			auto t = std::make_shared<Track>();
+			std::vector<TrackLoadJob> deferred;
+			t->Load(chunk, &deferred);
+			if (mTransport.GetSampleRate() > 0)
+				t->PrepareToPlay(mTransport.GetSampleRate(), mMaxBlockFrames);
+			for (auto& job : deferred)
+				loader.Add(t, std::move(job));
+			mTracks.push_back(t);
+		} else if (id == ProjectChunk::Master) {
+			mMasterTrack = std::make_shared<Track>();
+			mMasterTrack->SetName("Master");
+			mMasterTrack->InitMasterTrackParameters(mTransport.GetBpm());
+			std::vector<TrackLoadJob> deferred;
+			mMasterTrack->Load(chunk, &deferred);
+			if (mTransport.GetSampleRate() > 0)
+				mMasterTrack->PrepareToPlay(mTransport.GetSampleRate(), mMaxBlockFrames);
+			for (auto& job : deferred)
+				loader.Add(mMasterTrack, std::move(job));
+		}
+	}
 
-	mTransport.SetPosition((int64_t)(loadedPlayheadBeat * secsPerBeat * sR));
-	mTransport.SetLoopRange((int64_t)(loadedLoopStartBeat * secsPerBeat * sR), (int64_t)(loadedLoopEndBeat * secsPerBeat * sR));
-	mTransport.SetLoopEnabled(loadedLoopEn);
+	FinishLoad(loadedPlayheadBeat, loadedLoopStartBeat, loadedLoopEndBeat, loadedLoopEn);
+	return true;
 }
@@ -2,10 +2,53 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <set>
 #include <string>
+#include <iosfwd>
 #include "Track.h"
 #include "Transport.h"
+#include "RenderGraph.h"
+#include "RenderThreadPool.h"
+#include "WavWriter.h"
+
+class ProjectLoader;
+class ProcessorStateCache;
+
+// a track or group tapped post-fader during an export and written to its own file
+struct RenderStem {
+	int trackIndex = -1;
+	std::string path;
+};
+
+// "<mix> - 03 Drums.wav" beside the mix file, with characters a file name can't hold dropped
+std::string GetStemPath(const std::string& mixPath, int trackIndex, const std::string& trackName);
+
+// how an offline render runs. blocks are larger than a device buffer: there is no deadline
+// to meet, so bigger blocks just mean less scheduling overhead per sample
+struct RenderSettings {
+	double startBeat = 0.0; // start == end renders the whole song
+	double endBeat = 0.0;
+	double sampleRate = 48000.0;
+	static constexpr int kMaxBlockSize = 16384;
+	int blockSize = 4096; // processors are prepared for it for the length of the render
+	WavSampleFormat sampleFormat = WavSampleFormat::Int16;
+	WavDither dither = WavDither::Triangular;
+	ResampleQuality resampleQuality = ResampleQuality::Sinc; // no deadline, so the best by default
+	std::vector<RenderStem> stems; // rendered in the same pass as the mix
+};
+
+// shared between an offline render and whoever watches it
+struct RenderProgress {
+	std::atomic<float> fraction{0.0f};
+	std::atomic<bool> cancelRequested{false};
+};
+
+// Save's on-disk format. Load tells them apart by the binary header
+enum class ProjectFileFormat {
+	Binary, // chunked container (ProjectFile.h), the default
+	Text	// the original line-based format, for interchange and hand editing
+};
 
 struct ProjectViewState {
 	float pixelsPerBeat = 60.0f;
@@ -46,22 +89,68 @@ public:
 	// caller restores those before/after as needed.
 	void RestoreTracks(std::vector<std::shared_ptr<Track>> tracks);
 
-	void PrepareToPlay(double sampleRate);
+	// maxBlockFrames sizes the graph's mixing buffers and is what processors are prepared for;
+	// longer callbacks are rendered in slices
+	void PrepareToPlay(double sampleRate, int maxBlockFrames = 512);
+	// the most frames any processor gets per call during playback. a processor added to the
+	// project is prepared with it
+	int GetMaxBlockFrames() const { return mMaxBlockFrames; }
 
 	// set bpm
 	void SetBpm(double bpm);
 
-	// audio callback
+	// audio callback. lock-free: reads only the published RenderGraph
 	void ProcessBlock(float* outputBuffer, int numFrames, int numChannels, std::vector<MIDIMessage>& liveMIDIEvents);
 
-	// wav export
-	bool RenderAudio(const std::string& path, double startBeat, double endBeat, double sampleRate = 48000.0);
+	// worker threads the render pool runs beside the rendering thread. < 0 = one per spare
+	// core, 0 = render serially (a new project starts with none). realtime is for the project
+	// the audio device plays; see RenderThreadPool::Start
+	void SetRenderThreadCount(int numWorkers, bool realtime = true);
+
+	// how playback resamples unwarped and Re-Pitch clips, from the next block on. starts at
+	// AppConfig::resampleQuality; an export uses its RenderSettings' instead
+	void SetResampleQuality(ResampleQuality quality) { mResampleQuality.store(quality, std::memory_order_relaxed); }
+
+	// wav export. holds the project for the whole render; RenderJob runs one on a copy
+	// instead. an empty path writes only settings.stems. returns false on failure or when
+	// cancelled through progress
+	bool RenderAudio(const std::string& path, const RenderSettings& settings, RenderProgress* progress = nullptr);
+
+	// stems for a mix written to mixPath (see GetStemPath). topLevelOnly keeps the tracks and
+	// groups the master mixes directly, which sum to what enters the master; otherwise every
+	// track and group, a group's stem already holding its children's
+	std::vector<RenderStem> GetStems(const std::string& mixPath, bool topLevelOnly);
 
+	// counts edits that never reach the undo stack (a plugin's own editor, the loop toggle), so
+	// the autosave sees them beside the undo revision. any thread
+	void MarkEdited() { mEditCount.fetch_add(1, std::memory_order_relaxed); }
+	uint64_t GetEditCount() const { return mEditCount.load(std::memory_order_relaxed); }
+
+	// serializes UI-side edits against each other (and against export/load). the audio
+	// thread never takes it; it sees edits once they are published
 	std::mutex& GetMutex() { return mMutex; }
 
+	// rebuild the audio thread's snapshot if the model changed since the last publish, and
+	// free snapshots the audio thread has moved past. UI thread, once per frame; the
+	// project's own mutators publish on their own
+	void PublishGraph();
+
 	// serialization
-	void Save(const std::string& path);
-	void Load(const std::string& path);
+	void Save(const std::string& path, ProjectFileFormat format = ProjectFileFormat::Binary);
+	void Save(std::ostream& out); // text
+	void Save(ChunkWriter& out, ProcessorStateCache* cache = nullptr); // binary, header included
+	bool Load(const std::string& path); // either format; false when the file can't be read
+	bool Load(std::istream& in);			// text. each Load is BeginLoad, then waits for every asset
+	bool Load(const uint8_t* data, size_t size); // binary
+
+	// progressive load: parses the project and queues its audio files and plugin chains on
+	// `loader` instead of opening them. the caller starts the loader and calls
+	// ApplyLoadedAssets until it's done; tracks play as soon as their assets are in
+	bool BeginLoad(const std::string& path, ProjectLoader& loader);
+	bool BeginLoad(std::istream& in, ProjectLoader& loader);
+	bool BeginLoad(const uint8_t* data, size_t size, ProjectLoader& loader);
+	// ui thread: installs whatever the loader finished since the last call
+	void ApplyLoadedAssets(ProjectLoader& loader);
 
 	// view state
 	ProjectViewState& GetViewState() { return mViewState; }
@@ -72,22 +161,62 @@ private:
 	ProjectViewState mViewState;
 	std::shared_ptr<Track> mMasterTrack;
 
-	std::vector<float> mMixBuffer;
+	int mMaxBlockFrames = 512;
+	std::vector<MIDIMessage> mChunkMIDIEvents; // live events of one loop chunk, reserved up front
+	std::vector<MIDIMessage> mSliceMIDIEvents; // same, for one slice of an oversized block
 	bool mWasPlaying = false;
 	// playhead position at the end of the previous processed block, used to
 	// detect a discontinuous seek so we can flush stuck notes (-1 = no prior block)
 	int64_t mLastBlockEndSample = -1;
-	int mSelectedTrackIndex = 0;
+	int mSelectedTrackIndex = 0; // receives live MIDI; baked into the published graph
+	std::atomic<ResampleQuality> mResampleQuality{ResampleQuality::Linear};
+	std::atomic<uint64_t> mEditCount{0};
+
+	// ---- published render graph (RCU) ----
+	// mGraph is the UI thread's owning handle to the snapshot currently published through
+	// mPublishedGraph. a replaced snapshot moves to mRetiredGraphs and is freed by the UI
+	// thread once the audio thread's hazard slot no longer names it
+	std::unique_ptr<RenderGraph> mGraph;
+	std::atomic<RenderGraph*> mPublishedGraph{nullptr};
+	std::atomic<RenderGraph*> mAudioGraphHazard{nullptr};
+	std::vector<std::unique_ptr<RenderGraph>> mRetiredGraphs;
+
+	// set by the audio thread when automation moved the tempo; clip durations are then
+	// re-validated on the UI thread, which owns the clips
+	std::atomic<bool> mTempoChangedOnAudioThread{false};
+
+	// offline work (export, load, sample-rate change) touches processor state directly, so
+	// it parks the audio thread first: the callback outputs silence while suspended
+	std::atomic<bool> mAudioSuspended{false};
+	std::atomic<bool> mAudioInBlock{false};
+	friend class ScopedAudioSuspend;
+
+	// spreads the track DAG over all cores, for playback and export alike
+	RenderThreadPool mRenderPool;
 
 	// core dsp processing
-	void ProcessAudioGraph(float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents, bool anySolo);
+	void ProcessAudioGraph(const RenderGraph& graph, float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents);
+
+	// renders one track into its node buffer (a group first sums its children's buffers).
+	// runs on whichever render pool thread picked the node up
+	void ProcessTrackNode(const RenderGraph& graph, int trackIndex, const RenderBuffers& buffers, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents);
 
-	// recursive track helper
-	void ProcessTrackRecursively(std::shared_ptr<Track> track, float* accumulationBuffer, int numFrames, int numChannels, const ProcessContext& context, const std::vector<MIDIMessage>& liveMIDIEvents, bool anySolo);
+	// sums the audible roots into destinationBuffer and runs the master chain over it
+	void ProcessMasterNode(const RenderGraph& graph, const RenderBuffers& buffers, float* destinationBuffer, int numFrames, int numChannels, const ProcessContext& context);
 
 	// internal helper
-	void PrepareToPlayInternal(double sampleRate);
+	void PrepareToPlayInternal(double sampleRate, int maxBlockFrames); // prepares every processor
 	void SetBpmInternal(double bpm);
+	void ValidateClipDurations(double bpm);
+	void PublishGraphInternal(); // caller holds mMutex
+	void CollectRetiredGraphs();
+	// caller holds mMutex: see AudioClip::UpdateWarpTables. `freeze` also refreshes the clips'
+	// freezes, which only realtime playback uses
+	void UpdateWarpTables(double sampleRate, bool freeze);
+	// shared by both formats' BeginLoad, caller holds mMutex: clear before parsing, then wire
+	// up parents and automation and restore the transport after
+	void ResetForLoad();
+	void FinishLoad(double playheadBeat, double loopStartBeat, double loopEndBeat, bool loopEnabled);
 
 	std::mutex mMutex;
 };
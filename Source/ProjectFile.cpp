@@ -0,0 +1,92 @@
+#include "PrecompHeader.h"
+#include "ProjectFile.h"
+
+bool IsBinaryProject(const uint8_t* data, size_t size) {
+	return size >= sizeof(kProjectFileMagic) && std::memcmp(data, kProjectFileMagic, sizeof(kProjectFileMagic)) == 0;
+}
+
+void ChunkWriter::WriteHeader() {
+	WriteBytes(kProjectFileMagic, sizeof(kProjectFileMagic));
+	Write<uint32_t>(kProjectFileVersion);
+}
+
+void ChunkWriter::Begin(uint32_t id) {
+	Write<uint32_t>(id);
+	mOpen.push_back(mData.size());
+	Write<uint32_t>(0); // patched by End
+}
+
+void ChunkWriter::End() {
+	size_t sizeAt = mOpen.back();
+	mOpen.pop_back();
+	uint32_t size = (uint32_t)(mData.size() - sizeAt - sizeof(uint32_t));
+	std::memcpy(mData.data() + sizeAt, &size, sizeof(size));
+}
+
+void ChunkWriter::WriteString(const std::string& s) {
+	Write<uint32_t>((uint32_t)s.size());
+	WriteBytes(s.data(), s.size());
+}
+
+void ChunkWriter::WriteBytes(const void* data, size_t size) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	mData.insert(mData.end(), bytes, bytes + size);
+}
+
+bool ChunkReader::OpenFile(const uint8_t* data, size_t size, ChunkReader& chunks) {
+	if (!IsBinaryProject(data, size))
+		return false;
+	ChunkReader header(data + sizeof(kProjectFileMagic), size - sizeof(kProjectFileMagic));
+	uint32_t version = header.Read<uint32_t>();
+	if (header.IsShort() || version > kProjectFileVersion)
+		return false;
+	chunks = ChunkReader(data + 8, size - 8);
+	return true;
+}
+
+bool ChunkReader::Next(uint32_t& id, ChunkReader& payload) {
+	if (GetRemaining() < 8)
+		return false;
+	uint32_t size = 0;
+	std::memcpy(&id, mData + mPos, sizeof(id));
+	std::memcpy(&size, mData + mPos + 4, sizeof(size));
+	if (size > GetRemaining() - 8) {
+		mShort = true;
+		return false;
+	}
+	payload = ChunkReader(mData + mPos + 8, size);
+	mPos += 8 + (size_t)size;
+	return true;
+}
+
+bool ChunkReader::Find(uint32_t id, ChunkReader& payload) const {
+	ChunkReader chunks(mData, mSize);
+	uint32_t chunkId = 0;
+	while (chunks.Next(chunkId, payload)) {
+		if (chunkId == id)
+			return true;
+	}
+	return false;
+}
+
+std::string ChunkReader::ReadString(const std::string& fallback) {
+	uint32_t length = Read<uint32_t>();
+	if (mShort || length > GetRemaining()) {
+		mShort = true;
+		return fallback;
+	}
+	std::string s((const char*)mData + mPos, length);
+	mPos += length;
+	return s;
+}
+
+bool ChunkReader::ReadBytes(void* out, size_t size) {
+	if (size > GetRemaining()) {
+		mShort = true;
+		mPos = mSize;
+		return false;
+	}
+	std::memcpy(out, mData + mPos, size);
+	mPos += size;
+	return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// the binary project container. a file is an 8-byte header (magic, format version) followed by
+// chunks; a chunk is a four-character id, a byte size and that many bytes of payload, which
+// holds either typed fields or more chunks. a reader walks chunks by their sizes, so anything
+// it doesn't know (a newer build's additions) is stepped over without being parsed.
+//
+// fields are little-endian, native on every platform we ship. new fields go on the end of a
+// chunk and read as their default from older files, new data goes in new chunks; the version
+// only moves for a change old builds must refuse
+//
+// track             TRAK { THDR, PROC*, CLIP { CHDR, AUDI | NOTS }*, AUTO* }
+// master track      MAST { same as TRAK }
+// project settings  PROJ, VIEW
+
+constexpr uint32_t MakeChunkId(const char (&id)[5]) {
+	return (uint32_t)(uint8_t)id[0] | (uint32_t)(uint8_t)id[1] << 8 | (uint32_t)(uint8_t)id[2] << 16 | (uint32_t)(uint8_t)id[3] << 24;
+}
+
+namespace ProjectChunk {
+	constexpr uint32_t Project = MakeChunkId("PROJ");		// bpm, playhead, loop
+	constexpr uint32_t View = MakeChunkId("VIEW");			// ProjectViewState
+	constexpr uint32_t Track = MakeChunkId("TRAK");			// container
+	constexpr uint32_t Master = MakeChunkId("MAST");		// container, as TRAK
+	constexpr uint32_t TrackHeader = MakeChunkId("THDR");	// name, color, mixer, hierarchy
+	constexpr uint32_t Processor = MakeChunkId("PROC");		// type, editor scaling, saved state
+	constexpr uint32_t Clip = MakeChunkId("CLIP");			// container
+	constexpr uint32_t ClipHeader = MakeChunkId("CHDR");	// kind, grid, name, placement
+	constexpr uint32_t AudioClip = MakeChunkId("AUDI");		// file path, warp settings
+	constexpr uint32_t Notes = MakeChunkId("NOTS");			// count, then packed notes
+	constexpr uint32_t Automation = MakeChunkId("AUTO");	// parameter name, count, points
+}
+
+constexpr char kProjectFileMagic[4] = {'M', 'S', 'D', 'P'};
+constexpr uint32_t kProjectFileVersion = 1; // 1: initial binary format
+
+// true if `data` starts with a binary project header (as opposed to the text format)
+bool IsBinaryProject(const uint8_t* data, size_t size);
+
+// builds a file in memory. Begin/End nest: End patches the size of the chunk Begin opened
+class ChunkWriter {
+public:
+	void WriteHeader(); // magic and version; first thing in a file
+
+	void Begin(uint32_t id);
+	void End();
+
+	template <typename T>
+	void Write(T value) {
+		static_assert(std::is_arithmetic_v<T>);
+		WriteBytes(&value, sizeof(T));
+	}
+	void WriteString(const std::string& s); // u32 length, then the bytes
+	void WriteBytes(const void* data, size_t size);
+
+	const std::vector<uint8_t>& GetData() const { return mData; }
+	std::vector<uint8_t>& GetData() { return mData; }
+private:
+	std::vector<uint8_t> mData;
+	std::vector<size_t> mOpen; // offsets of the size fields of chunks begun and not ended
+};
+
+// reads one payload: fields in order, or the chunks in it one by one. never reads past its
+// span; a read that would comes back as the fallback and marks the reader short
+class ChunkReader {
+public:
+	ChunkReader() = default;
+	ChunkReader(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+	// a whole file: checks the header and returns a reader over its chunks. false if the
+	// data isn't a binary project or was written by a format this build can't read
+	static bool OpenFile(const uint8_t* data, size_t size, ChunkReader& chunks);
+
+	// the next chunk in this payload; false at the end (or at a chunk cut off by a truncated file)
+	bool Next(uint32_t& id, ChunkReader& payload);
+	// the first chunk `id` in this payload, from the start
+	bool Find(uint32_t id, ChunkReader& payload) const;
+
+	template <typename T>
+	T Read(T fallback = T()) {
+		static_assert(std::is_arithmetic_v<T>);
+		T value = fallback;
+		ReadBytes(&value, sizeof(T));
+		return value;
+	}
+	std::string ReadString(const std::string& fallback = std::string());
+	bool ReadBytes(void* out, size_t size);
+
+	bool IsShort() const { return mShort; }
+	size_t GetRemaining() const { return mSize - mPos; }
+private:
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+	size_t mPos = 0;
+	bool mShort = false;
+};
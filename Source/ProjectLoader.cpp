@@ -0,0 +1,71 @@
+#include "PrecompHeader.h"
+#include "ProjectLoader.h"
+
+ProjectLoader::~ProjectLoader() {
+	mCancelled.store(true);
+	Wait();
+	// anything never applied leaves its track loading; undo that so a track kept past the
+	// loader (the editor dropping a load to open another) doesn't stay silent forever
+	for (auto& job : mJobs) {
+		if (job->load.run) // cleared once applied
+			if (auto track = job->track.lock())
+				track->FinishPendingLoad();
+	}
+}
+
+void ProjectLoader::Add(const std::shared_ptr<Track>& track, TrackLoadJob job) {
+	auto entry = std::make_unique<Job>();
+	entry->track = track;
+	entry->load = std::move(job);
+	track->AddPendingLoad();
+	mJobs.push_back(std::move(entry));
+}
+
+void ProjectLoader::Start(int numThreads) {
+	if (numThreads < 0)
+		numThreads = (int)std::thread::hardware_concurrency();
+	numThreads = std::max(1, std::min(numThreads, (int)mJobs.size()));
+	if (mJobs.empty())
+		return;
+	for (int i = 0; i < numThreads; ++i)
+		mThreads.emplace_back(&ProjectLoader::WorkerLoop, this);
+}
+
+void ProjectLoader::Wait() {
+	for (auto& thread : mThreads) {
+		if (thread.joinable())
+			thread.join();
+	}
+	mThreads.clear();
+}
+
+void ProjectLoader::WorkerLoop() {
+	// jobs are claimed in file order, so the first tracks tend to come up first
+	while (!mCancelled.load()) {
+		int index = mNext.fetch_add(1);
+		if (index >= (int)mJobs.size())
+			return;
+		Job& job = *mJobs[index];
+		job.load.run();
+		job.finished.store(true, std::memory_order_release);
+	}
+}
+
+int ProjectLoader::Apply(double sampleRate, int maxBlockFrames) {
+	int applied = 0;
+	for (int i = mScanFrom; i < (int)mJobs.size(); ++i) {
+		Job& job = *mJobs[i];
+		if (!job.load.run || !job.finished.load(std::memory_order_acquire))
+			continue;
+		if (auto track = job.track.lock()) {
+			job.load.apply(sampleRate, maxBlockFrames);
+			track->FinishPendingLoad();
+		}
+		job.load = TrackLoadJob(); // frees what the job built if nobody took it
+		++applied;
+		++mApplied;
+	}
+	while (mScanFrom < (int)mJobs.size() && !mJobs[mScanFrom]->load.run)
+		++mScanFrom;
+	return applied;
+}
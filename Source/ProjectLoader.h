@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Track.h"
+
+// the slow half of opening a project. Project::BeginLoad parses the file and hands over what
+// Track::Load deferred (audio files to decode, plugin chains to build); the loader decodes the
+// files on worker threads, and the ui thread installs each result as it lands, building plugin
+// chains there since plugins expect to be created on it (Project::ApplyLoadedAssets), so tracks
+// come up one by one instead of all after the last file.
+//
+// jobs only ever run once, in any order, on any worker. a track deleted before its jobs are
+// applied simply doesn't get them
+class ProjectLoader {
+public:
+	ProjectLoader() = default;
+	~ProjectLoader(); // skips jobs not yet started and waits for the running ones
+
+	ProjectLoader(const ProjectLoader&) = delete;
+	ProjectLoader& operator=(const ProjectLoader&) = delete;
+
+	// before Start: queue a job for `track` (held weakly) and mark the track loading
+	void Add(const std::shared_ptr<Track>& track, TrackLoadJob job);
+
+	// runs the jobs on `numThreads` workers, < 0 = one per core
+	void Start(int numThreads = -1);
+	// blocks until every job has run
+	void Wait();
+
+	// ui thread, project mutex held: installs every job that finished since the last call.
+	// returns how many it applied
+	int Apply(double sampleRate, int maxBlockFrames);
+
+	int GetTotal() const { return (int)mJobs.size(); }
+	int GetApplied() const { return mApplied; }
+	bool IsDone() const { return mApplied == (int)mJobs.size(); }
+private:
+	struct Job {
+		std::weak_ptr<Track> track;
+		TrackLoadJob load;
+		std::atomic<bool> finished{false};
+	};
+
+	void WorkerLoop();
+
+	std::vector<std::unique_ptr<Job>> mJobs;
+	std::vector<std::thread> mThreads;
+	std::atomic<int> mNext{0};
+	std::atomic<bool> mCancelled{false};
+	int mApplied = 0;
+	int mScanFrom = 0; // jobs before this are all applied
+};
@@ -0,0 +1,160 @@
+// MSDAW-render: bounce a project to a WAV file with no window and no audio device.
+// meant for batch jobs, e.g. `ls *.msdaw | xargs -P4 -I{} MSDAW-render --threads 3 {} {}.wav`
+#include "PrecompHeader.h"
+#include "Project.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+static void PrintUsage() {
+	printf("usage: MSDAW-render [options] <project.msdaw> <output.wav>\n"
+		   "  --start <beat>   first beat to render (default: whole song)\n"
+		   "  --end <beat>     beat to stop at\n"
+		   "  --rate <hz>      output sample rate (default 48000)\n"
+		   "  --block <frames> frames per render block, up to 16384 (default 4096)\n"
+		   "  --format <fmt>   16, 24, 32, f32 or f64 (default 16)\n"
+		   "  --dither <mode>  none, tpdf or shaped; 16/24-bit only (default tpdf)\n"
+		   "  --resample <q>   linear, cubic or sinc, for unwarped and Re-Pitch clips (default sinc)\n"
+		   "  --stems          also write each top-level track and group as '<output> - NN Name.wav';\n"
+		   "                   these sum to what enters the master\n"
+		   "  --all-stems      like --stems, but every track and group (groups include their children)\n"
+		   "  --threads <n>    render workers besides the main thread (default: one per spare core)\n");
+}
+
+static bool ParseNumber(const char* text, double& out) {
+	char* end = nullptr;
+	out = strtod(text, &end);
+	return end != text && *end == '\0';
+}
+
+static bool ParseFormat(const std::string& text, WavSampleFormat& out) {
+	if (text == "16")
+		out = WavSampleFormat::Int16;
+	else if (text == "24")
+		out = WavSampleFormat::Int24;
+	else if (text == "32")
+		out = WavSampleFormat::Int32;
+	else if (text == "f32")
+		out = WavSampleFormat::Float32;
+	else if (text == "f64")
+		out = WavSampleFormat::Float64;
+	else
+		return false;
+	return true;
+}
+
+static bool ParseDither(const std::string& text, WavDither& out) {
+	if (text == "none")
+		out = WavDither::None;
+	else if (text == "tpdf")
+		out = WavDither::Triangular;
+	else if (text == "shaped")
+		out = WavDither::NoiseShaped;
+	else
+		return false;
+	return true;
+}
+
+static bool ParseResampleQuality(const std::string& text, ResampleQuality& out) {
+	if (text == "linear")
+		out = ResampleQuality::Linear;
+	else if (text == "cubic")
+		out = ResampleQuality::Cubic;
+	else if (text == "sinc")
+		out = ResampleQuality::Sinc;
+	else
+		return false;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	RenderSettings settings;
+	double blockSize = settings.blockSize;
+	double threads = -1.0;
+	bool stems = false;
+	bool allStems = false;
+	std::string projectPath;
+	std::string outputPath;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		double* value = nullptr;
+		if (arg == "--start")
+			value = &settings.startBeat;
+		else if (arg == "--end")
+			value = &settings.endBeat;
+		else if (arg == "--rate")
+			value = &settings.sampleRate;
+		else if (arg == "--block")
+			value = &blockSize;
+		else if (arg == "--threads")
+			value = &threads;
+		else if (arg == "--stems" || arg == "--all-stems") {
+			stems = true;
+			allStems = arg == "--all-stems";
+			continue;
+		} else if (arg == "--format" || arg == "--dither" || arg == "--resample") {
+			bool parsed = false;
+			if (i + 1 < argc) {
+				if (arg == "--format")
+					parsed = ParseFormat(argv[i + 1], settings.sampleFormat);
+				else if (arg == "--dither")
+					parsed = ParseDither(argv[i + 1], settings.dither);
+				else
+					parsed = ParseResampleQuality(argv[i + 1], settings.resampleQuality);
+			}
+			if (!parsed) {
+				printf("Error: bad value for %s\n", arg.c_str());
+				return 2;
+			}
+			++i;
+			continue;
+		} else if (arg == "-h" || arg == "--help") {
+			PrintUsage();
+			return 0;
+		}
+
+		if (value) {
+			if (i + 1 >= argc || !ParseNumber(argv[i + 1], *value)) {
+				printf("Error: %s expects a number\n", arg.c_str());
+				return 2;
+			}
+			++i;
+		} else if (projectPath.empty()) {
+			projectPath = arg;
+		} else if (outputPath.empty()) {
+			outputPath = arg;
+		} else {
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (projectPath.empty() || outputPath.empty() || settings.sampleRate <= 0.0 || blockSize < 1.0 ||
+		blockSize > RenderSettings::kMaxBlockSize) {
+		PrintUsage();
+		return 2;
+	}
+	settings.blockSize = (int)blockSize;
+
+	Project project;
+	project.Initialize();
+	// nothing here has a deadline, so the workers don't ask for realtime scheduling
+	project.SetRenderThreadCount(threads >= 0.0 ? (int)threads : -1, false);
+	if (!project.Load(projectPath)) {
+		printf("Error: can't open project '%s'\n", projectPath.c_str());
+		return 1;
+	}
+
+	if (stems)
+		settings.stems = project.GetStems(outputPath, !allStems);
+
+	// start == end renders the whole song, the same as an export without a selection
+	if (!project.RenderAudio(outputPath, settings)) {
+		printf("Error: rendering '%s' to '%s' failed\n", projectPath.c_str(), outputPath.c_str());
+		return 1;
+	}
+	printf("%s -> %s\n", projectPath.c_str(), outputPath.c_str());
+	return 0;
+}
@@ -0,0 +1,230 @@
+#include "PrecompHeader.h"
+#include "RenderGraph.h"
+#include <algorithm>
+#include <unordered_map>
+
+// MIDI scratch reserved per node for the events its clips emit in one block, at least. a block
+// can't emit more than every clip note's on and off, so that bounds it; beyond this floor the
+// reservation follows the track's note count and the list never grows on the audio thread
+constexpr size_t kClipMIDIEventsPerBlock = 256;
+
+static size_t GetMaxClipMIDIEvents(const TrackRenderState& state) {
+	size_t events = 0;
+	for (const ClipRenderState& clip : state.clips) {
+		if (clip.midi)
+			events += 2 * clip.midi->notes.size();
+	}
+	return std::max(events, kClipMIDIEventsPerBlock);
+}
+
+static void CaptureTrack(RenderGraphTrack& out, const std::shared_ptr<Track>& track, int parentIndex) {
+	out.track = track;
+	out.parentIndex = parentIndex;
+	if (!track)
+		return;
+	out.parent = track->GetParent().get();
+	out.isGroup = track->IsGroup();
+	out.mute = track->GetMute();
+	out.solo = track->GetSolo();
+	out.loading = track->IsLoading();
+	track->CaptureRenderState(out.state);
+}
+
+static bool TrackMatches(const RenderGraphTrack& node, const std::shared_ptr<Track>& track) {
+	if (node.track != track)
+		return false;
+	if (!track)
+		return true;
+	if (node.parent != track->GetParent().get())
+		return false;
+	if (node.isGroup != track->IsGroup() || node.mute != track->GetMute() || node.solo != track->GetSolo())
+		return false;
+	if (node.loading != track->IsLoading())
+		return false;
+	return track->MatchesRenderState(node.state);
+}
+
+// flattens per-node dependent lists into the schedule, and starts it with every node that has
+// nothing to wait for, in schedule order
+static void FinishSchedule(RenderSchedule& schedule, const std::vector<std::vector<int>>& dependentsOf) {
+	schedule.firstDependent.assign(schedule.numNodes + 1, 0);
+	for (int i = 0; i < schedule.numNodes; ++i)
+		schedule.firstDependent[i + 1] = schedule.firstDependent[i] + (int)dependentsOf[i].size();
+	schedule.dependents.clear();
+	schedule.dependents.reserve(schedule.firstDependent.back());
+	for (const auto& list : dependentsOf)
+		schedule.dependents.insert(schedule.dependents.end(), list.begin(), list.end());
+
+	schedule.ready.clear();
+	for (int node : schedule.order) {
+		if (schedule.numPrerequisites[node] == 0)
+			schedule.ready.push_back(node);
+	}
+}
+
+// the per-block mute/solo rules, evaluated once per snapshot. the schedule lists children before
+// parents, so walking it backwards visits every parent before its children
+static void ResolveMuteSolo(RenderGraph& graph) {
+	int numTracks = (int)graph.tracks.size();
+
+	// soloed itself or under a soloed group
+	std::vector<bool> effectiveSolo(numTracks, false);
+	for (auto it = graph.schedule.order.rbegin(); it != graph.schedule.order.rend(); ++it) {
+		const RenderGraphTrack& node = graph.tracks[*it];
+		effectiveSolo[*it] = node.solo || (node.parentIndex >= 0 && effectiveSolo[node.parentIndex]);
+	}
+
+	// a group stays open while a soloed track sits somewhere below it, so the signal from a
+	// deep child can bubble up. only group children pass that on, as before
+	std::vector<bool> soloBelow(numTracks, false);
+	for (int i : graph.schedule.order) {
+		for (int child : graph.tracks[i].children) {
+			const RenderGraphTrack& c = graph.tracks[child];
+			if (c.solo || (c.isGroup && soloBelow[child]))
+				soloBelow[i] = true;
+		}
+	}
+
+	for (auto it = graph.schedule.order.rbegin(); it != graph.schedule.order.rend(); ++it) {
+		RenderGraphTrack& node = graph.tracks[*it];
+		bool passes = true;
+		// must be soloed to bypass mute
+		if (node.mute && !effectiveSolo[*it])
+			passes = false;
+		if (graph.anySolo && !effectiveSolo[*it] && !(node.isGroup && soloBelow[*it]))
+			passes = false;
+		// a chain whose plugins aren't in yet would play dry; hold it back until it's whole
+		if (node.loading || graph.master.loading)
+			passes = false;
+		// only groups mix their children in, so anything parented to a plain track is silent
+		node.audible = passes;
+		if (node.parentIndex >= 0) {
+			const RenderGraphTrack& parent = graph.tracks[node.parentIndex];
+			node.audible = node.audible && parent.isGroup && parent.audible;
+		}
+	}
+}
+
+std::unique_ptr<RenderGraph> RenderGraph::Build(const std::vector<std::shared_ptr<Track>>& tracks,
+												const std::shared_ptr<Track>& masterTrack,
+												int selectedTrack, int blockCapacity) {
+	std::unordered_map<const Track*, int> indexOf;
+	for (int i = 0; i < (int)tracks.size(); ++i)
+		indexOf[tracks[i].get()] = i;
+
+	auto graph = std::make_unique<RenderGraph>();
+	graph->tracks.resize(tracks.size());
+	for (int i = 0; i < (int)tracks.size(); ++i) {
+		// a parent that is no longer in the list is treated as root, as before
+		int parentIndex = -1;
+		auto it = indexOf.find(tracks[i]->GetParent().get());
+		if (it != indexOf.end())
+			parentIndex = it->second;
+		CaptureTrack(graph->tracks[i], tracks[i], parentIndex);
+		if (graph->tracks[i].solo)
+			graph->anySolo = true;
+	}
+	CaptureTrack(graph->master, masterTrack, -1);
+
+	// the DAG: children in project order, then an iterative post-order walk from each root so
+	// every child lands before its group. a parent chain that loops back on itself never
+	// reaches the root level; the recursive walk this replaced never visited such tracks, and
+	// a scheduler waiting on them would hang, so they stay out of the schedule
+	for (int i = 0; i < (int)tracks.size(); ++i) {
+		int parentIndex = graph->tracks[i].parentIndex;
+		if (parentIndex >= 0)
+			graph->tracks[parentIndex].children.push_back(i);
+		else
+			graph->roots.push_back(i);
+	}
+
+	RenderSchedule& schedule = graph->schedule;
+	std::vector<std::pair<int, size_t>> stack;
+	for (int root : graph->roots) {
+		stack.push_back({root, 0});
+		while (!stack.empty()) {
+			auto& [node, nextChild] = stack.back();
+			const auto& children = graph->tracks[node].children;
+			if (nextChild < children.size()) {
+				int child = children[nextChild++];
+				stack.push_back({child, 0});
+			} else {
+				schedule.order.push_back(node);
+				stack.pop_back();
+			}
+		}
+	}
+
+	schedule.numNodes = (int)tracks.size();
+	schedule.numPrerequisites.assign(tracks.size(), 0);
+	std::vector<std::vector<int>> dependentsOf(tracks.size());
+	for (int i : schedule.order) {
+		const RenderGraphTrack& node = graph->tracks[i];
+		schedule.numPrerequisites[i] = (int)node.children.size();
+		if (node.parentIndex >= 0)
+			dependentsOf[i].push_back(node.parentIndex);
+	}
+	FinishSchedule(schedule, dependentsOf);
+
+	ResolveMuteSolo(*graph);
+
+	graph->selectedTrack = selectedTrack;
+	if (selectedTrack >= 0 && selectedTrack < (int)tracks.size() && tracks[selectedTrack]->HasInstrument())
+		graph->liveMIDITarget = selectedTrack;
+
+	// buffer slots. the schedule has every child ahead of its group, so the first child's slot
+	// is already assigned when the group comes up
+	for (int i : schedule.order) {
+		RenderGraphTrack& node = graph->tracks[i];
+		if (node.children.empty())
+			node.buffer = graph->numBuffers++;
+		else
+			node.buffer = graph->tracks[node.children.front()].buffer;
+		size_t clipEvents = GetMaxClipMIDIEvents(node.state);
+		node.midi.reserve(i == graph->liveMIDITarget ? clipEvents + kMaxLiveMIDIEventsPerBlock : clipEvents);
+	}
+	graph->master.midi.reserve(GetMaxClipMIDIEvents(graph->master.state));
+	graph->blockCapacity = blockCapacity;
+	graph->buffers.resize((size_t)graph->numBuffers * blockCapacity);
+	return graph;
+}
+
+RenderSchedule RenderGraph::Unroll(int numBlocks) const {
+	int stride = GetUnrolledStride();
+	int master = stride - 1;
+
+	RenderSchedule unrolled;
+	unrolled.numNodes = stride * numBlocks;
+	unrolled.numPrerequisites.assign(unrolled.numNodes, 0);
+	std::vector<std::vector<int>> dependentsOf(unrolled.numNodes);
+	for (int b = 0; b < numBlocks; ++b) {
+		int base = b * stride;
+		bool hasNext = b + 1 < numBlocks;
+		for (int i : schedule.order) {
+			const RenderGraphTrack& node = tracks[i];
+			unrolled.order.push_back(base + i);
+			unrolled.numPrerequisites[base + i] = (int)node.children.size() + (b > 0 ? 1 : 0);
+			dependentsOf[base + i].push_back(base + (node.parentIndex >= 0 ? node.parentIndex : master));
+			if (hasNext)
+				dependentsOf[base + i].push_back(base + stride + i);
+		}
+		unrolled.order.push_back(base + master);
+		unrolled.numPrerequisites[base + master] = (int)roots.size() + (b > 0 ? 1 : 0);
+		if (hasNext)
+			dependentsOf[base + master].push_back(base + stride + master);
+	}
+	FinishSchedule(unrolled, dependentsOf);
+	return unrolled;
+}
+
+bool RenderGraph::Matches(const std::vector<std::shared_ptr<Track>>& liveTracks,
+						  const std::shared_ptr<Track>& masterTrack,
+						  int selected, int capacity) const {
+	if (selected != selectedTrack || capacity != blockCapacity || liveTracks.size() != tracks.size())
+		return false;
+	for (int i = 0; i < (int)liveTracks.size(); ++i) {
+		if (!TrackMatches(tracks[i], liveTracks[i]))
+			return false;
+	}
+	return TrackMatches(master, masterTrack);
+}
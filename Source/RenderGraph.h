@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "Track.h"
+#include "RenderThreadPool.h"
+
+// one track as the audio thread sees it: the track object itself (for its DSP state and
+// meters) plus copies of everything the UI can restructure underneath it
+struct RenderGraphTrack {
+	std::shared_ptr<Track> track;
+	int parentIndex = -1;		   // index into RenderGraph::tracks, -1 = root level
+	const Track* parent = nullptr; // identity only, lets Matches() skip the index search
+	bool isGroup = false;
+	bool mute = false;
+	bool solo = false;
+	bool loading = false; // plugins still being built by the project loader (Track::IsLoading)
+	TrackRenderState state;
+	std::vector<int> children; // direct children, project order (the order groups sum them in)
+
+	// mute/solo resolved against the whole hierarchy at build time: false when the track or
+	// any of its ancestors is muted, solo elsewhere silences it, or its parent is not a group.
+	// a track (or master) still loading is silent too
+	bool audible = false;
+
+	// where this node renders: a slot in RenderGraph::buffers, shared with the first child
+	// (see Build). -1 for nodes that are never scheduled
+	int buffer = -1;
+
+	// per-block scratch, written only by the renderer currently executing this snapshot (the
+	// audio callback or an offline render, never both at once) and only by the thread running
+	// this node. reserved at build time
+	mutable std::vector<MIDIMessage> midi;
+};
+
+// one block's worth of node output buffers: slot i starts at data + i * stride
+struct RenderBuffers {
+	float* data = nullptr;
+	size_t stride = 0;
+	float* Slot(int slot) const { return data + (size_t)slot * stride; }
+};
+
+// immutable snapshot of the track/clip/processor graph. the UI thread builds a fresh one
+// whenever the model changes and publishes it with a single atomic pointer swap; the audio
+// thread only ever reads the published snapshot, so it never takes a lock. the shared_ptrs
+// held here keep removed tracks, clips and plugins alive until the snapshot is retired,
+// which always happens on the UI thread (see Project::PublishGraph)
+struct RenderGraph {
+	std::vector<RenderGraphTrack> tracks; // project order
+	RenderGraphTrack master;			  // master.track may be null
+	bool anySolo = false;
+
+	// the hierarchy as a dependency DAG: a group depends on its children, the master mix on
+	// the roots. tracks caught in a parent cycle are unreachable from the roots and left out
+	std::vector<int> roots;	  // parentIndex == -1, project order
+	RenderSchedule schedule; // node = track index; leaves ready first, children before parents
+
+	// the track live MIDI input is routed to: the selected track when it hosts an instrument,
+	// else -1. selectedTrack is kept as given so Matches can spot a selection change
+	int selectedTrack = -1;
+	int liveMIDITarget = -1;
+
+	// the node output buffers, allocated here so the audio thread never has to. a group
+	// renders into its first child's slot once it has summed its children, so only leaves
+	// take a fresh one: the fewest buffers that still let every leaf run at the same time
+	int blockCapacity = 0; // samples (frames * channels) per slot
+	int numBuffers = 0;
+	mutable std::vector<float> buffers;
+	RenderBuffers GetBuffers() const { return {buffers.data(), (size_t)blockCapacity}; }
+
+	// the track DAG unrolled over numBlocks consecutive blocks, for offline rendering. node
+	// block * GetUnrolledStride() + track renders that track for that block, and the node
+	// after the last track mixes the roots through the master. a node also waits for its own
+	// previous block, so DSP state advances in order, but nothing else ties tracks together
+	// in time: an independent track can run several blocks ahead of the rest
+	RenderSchedule Unroll(int numBlocks) const;
+	int GetUnrolledStride() const { return (int)tracks.size() + 1; }
+
+	static std::unique_ptr<RenderGraph> Build(const std::vector<std::shared_ptr<Track>>& tracks,
+											  const std::shared_ptr<Track>& masterTrack,
+											  int selectedTrack, int blockCapacity);
+
+	// true while the live model still matches this snapshot, so no rebuild is needed.
+	// allocation-free, cheap enough to run once per UI frame
+	bool Matches(const std::vector<std::shared_ptr<Track>>& tracks,
+				 const std::shared_ptr<Track>& masterTrack,
+				 int selectedTrack, int blockCapacity) const;
+};
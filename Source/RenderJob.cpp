@@ -0,0 +1,51 @@
+#include "PrecompHeader.h"
+#include "RenderJob.h"
+
+RenderJob::RenderJob(Project& source, const std::string& path, const RenderSettings& settings)
+	: mPath(path), mSettings(settings) {
+	ChunkWriter snapshot;
+	source.Save(snapshot);
+
+	mProject = std::make_unique<Project>();
+	mProject->Initialize();
+	// the live engine keeps the realtime class; the export soaks up whatever is left
+	mProject->SetRenderThreadCount(-1, false);
+
+	// the structure comes in now; audio files and plugin chains follow through Update
+	mLoader = std::make_unique<ProjectLoader>();
+	if (!mProject->BeginLoad(snapshot.GetData().data(), snapshot.GetData().size(), *mLoader)) {
+		mLoader.reset();
+		mFinished.store(true);
+		return;
+	}
+	mLoader->Start();
+}
+
+RenderJob::~RenderJob() {
+	Cancel();
+	if (mThread.joinable())
+		mThread.join();
+	mLoader.reset(); // skips the files not yet decoded; before the tracks they'd go to
+	mProject.reset();
+}
+
+void RenderJob::Update() {
+	if (!mLoader)
+		return;
+	if (IsCancelled()) {
+		mLoader.reset();
+		mFinished.store(true);
+		return;
+	}
+	mProject->ApplyLoadedAssets(*mLoader);
+	if (!mLoader->IsDone())
+		return;
+	mLoader.reset();
+	mThread = std::thread(&RenderJob::Run, this);
+}
+
+void RenderJob::Run() {
+	bool ok = !IsCancelled() && mProject->RenderAudio(mPath, mSettings, &mProgress);
+	mSucceeded.store(ok);
+	mFinished.store(true);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Project.h"
+#include "ProjectLoader.h"
+
+// an export that runs on its own thread against a private copy of the project, so the editor
+// and the live engine carry on while it renders. the copy is rebuilt from a saved snapshot;
+// taking that snapshot is the only time the live project's lock is held.
+//
+// the copy loads like an opened project: its audio files decode on the loader's workers, and
+// Update installs them and builds the plugin chains on the ui thread, as plugins expect. only
+// once every track is ready does the render thread take the copy, and the copy (plugins and
+// all) is torn down on the ui thread again when the job is destroyed
+class RenderJob {
+public:
+	// ui thread
+	RenderJob(Project& source, const std::string& path, const RenderSettings& settings);
+	~RenderJob(); // ui thread: cancels a render still in flight and waits for it
+
+	RenderJob(const RenderJob&) = delete;
+	RenderJob& operator=(const RenderJob&) = delete;
+
+	// ui thread, every frame until IsFinished: applies what the loader finished, and starts the
+	// render once the copy is complete
+	void Update();
+
+	const std::string& GetPath() const { return mPath; }
+	float GetProgress() const { return mProgress.fraction.load(); }
+	bool IsLoading() const { return mLoader != nullptr; }
+
+	void Cancel() { mProgress.cancelRequested.store(true); }
+	bool IsCancelled() const { return mProgress.cancelRequested.load(); }
+
+	bool IsFinished() const { return mFinished.load(); }
+	bool Succeeded() const { return mSucceeded.load(); }
+private:
+	void Run();
+
+	std::string mPath;
+	RenderSettings mSettings;
+	RenderProgress mProgress;
+	std::unique_ptr<Project> mProject;
+	std::unique_ptr<ProjectLoader> mLoader; // until the copy is complete
+	std::atomic<bool> mFinished{false};
+	std::atomic<bool> mSucceeded{false};
+	std::thread mThread;
+};
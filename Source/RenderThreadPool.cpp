@@ -0,0 +1,159 @@
+#include "PrecompHeader.h"
+#include "RenderThreadPool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// workers render audio on the callback's deadline, so they ask for the same treatment the
+// audio thread gets. best effort: without the privilege they just run at normal priority
+static void PromoteToRealtime() {
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+	sched_param param{};
+	param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+	pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
+
+RenderThreadPool::~RenderThreadPool() {
+	Stop();
+}
+
+void RenderThreadPool::Start(int numWorkers, bool realtime) {
+	Stop();
+	if (numWorkers < 0) {
+		int cores = (int)std::thread::hardware_concurrency();
+		numWorkers = cores > 1 ? cores - 1 : 0;
+	}
+
+	mPending = std::make_unique<std::atomic<int>[]>(kMaxNodes);
+	mStopping.store(false);
+	mRealtime = realtime;
+	mSlots.clear();
+	for (int i = 0; i <= numWorkers; ++i)
+		mSlots.push_back(std::make_unique<Slot>());
+	for (int i = 1; i <= numWorkers; ++i)
+		mSlots[i]->thread = std::thread(&RenderThreadPool::WorkerLoop, this, i);
+}
+
+void RenderThreadPool::Stop() {
+	mStopping.store(true);
+	mEpoch.fetch_add(1);
+	mEpoch.notify_all();
+	for (auto& slot : mSlots) {
+		if (slot->thread.joinable())
+			slot->thread.join();
+	}
+	mSlots.clear();
+}
+
+void RenderThreadPool::Execute(const RenderSchedule& schedule, RenderNodeRunner& runner) {
+	int numNodes = (int)schedule.order.size();
+	if (numNodes == 0)
+		return;
+
+	// nothing to spread the work over (or too big for the deques): run it in order
+	if (mSlots.size() < 2 || schedule.numNodes > kMaxNodes) {
+		for (int node : schedule.order)
+			runner.RunNode(node);
+		return;
+	}
+
+	for (int node : schedule.order)
+		mPending[node].store(schedule.numPrerequisites[node], std::memory_order_relaxed);
+	mSchedule.store(&schedule, std::memory_order_relaxed);
+	mRunner.store(&runner, std::memory_order_relaxed);
+	mRemaining.store(numNodes, std::memory_order_relaxed);
+
+	// pushed in reverse so we pop the first nodes ourselves while thieves take the last ones.
+	// the deque's release fence publishes the job fields above along with the nodes
+	for (auto it = schedule.ready.rbegin(); it != schedule.ready.rend(); ++it)
+		mSlots[0]->deque.Push(*it);
+
+	mEpoch.fetch_add(1, std::memory_order_release);
+	mEpoch.notify_all();
+	if (!mRealtime) {
+		mQueued.fetch_add(1, std::memory_order_release);
+		mQueued.notify_all();
+	}
+
+	WorkUntilDone(0);
+}
+
+void RenderThreadPool::WorkerLoop(int slot) {
+	if (mRealtime)
+		PromoteToRealtime();
+	uint32_t seen = 0;
+	for (;;) {
+		mEpoch.wait(seen, std::memory_order_acquire);
+		if (mStopping.load())
+			return;
+		seen = mEpoch.load(std::memory_order_acquire);
+		WorkUntilDone(slot);
+	}
+}
+
+void RenderThreadPool::WorkUntilDone(int slot) {
+	// realtime: spin rather than sleep. a job lasts a fraction of one audio block, and waking a
+	// parked thread would cost more than the work it picks up
+	if (mRealtime) {
+		while (mRemaining.load(std::memory_order_acquire) > 0) {
+			if (!TryRunOne(slot))
+				std::this_thread::yield();
+		}
+		return;
+	}
+
+	// offline: nothing has a deadline, so leave the cores to playback. the count is read before
+	// looking for work, so a node queued in between makes the wait return at once
+	for (;;) {
+		uint32_t queued = mQueued.load(std::memory_order_acquire);
+		if (mRemaining.load(std::memory_order_acquire) == 0)
+			return;
+		if (!TryRunOne(slot))
+			mQueued.wait(queued, std::memory_order_acquire);
+	}
+}
+
+bool RenderThreadPool::TryRunOne(int slot) {
+	int node = -1;
+	if (mSlots[slot]->deque.Pop(node)) {
+		RunNode(slot, node);
+		return true;
+	}
+	int numSlots = (int)mSlots.size();
+	for (int i = 1; i < numSlots; ++i) {
+		int victim = (slot + i) % numSlots;
+		if (mSlots[victim]->deque.Steal(node)) {
+			RunNode(slot, node);
+			return true;
+		}
+	}
+	return false;
+}
+
+void RenderThreadPool::RunNode(int slot, int node) {
+	const RenderSchedule& schedule = *mSchedule.load(std::memory_order_acquire);
+	mRunner.load(std::memory_order_acquire)->RunNode(node);
+
+	// the last prerequisite to finish readies a dependent. dependents are queued before this
+	// node counts as done, so mRemaining can't reach zero while work is still outstanding
+	bool queued = false;
+	for (int i = schedule.firstDependent[node]; i < schedule.firstDependent[node + 1]; ++i) {
+		int dependent = schedule.dependents[i];
+		if (mPending[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			mSlots[slot]->deque.Push(dependent);
+			queued = true;
+		}
+	}
+	bool last = mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	if (!mRealtime && (queued || last)) {
+		mQueued.fetch_add(1, std::memory_order_release);
+		mQueued.notify_all();
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "WorkStealingDeque.h"
+
+// a dependency DAG in flat form, the unit of work the pool executes. node ids are
+// 0..numNodes-1; ids that appear in neither order nor dependents are simply never run
+struct RenderSchedule {
+	int numNodes = 0;
+	std::vector<int> order;			   // every node to run, each after all its prerequisites
+	std::vector<int> ready;			   // nodes with no prerequisites, in the order to start them
+	std::vector<int> numPrerequisites; // per node id
+	// finishing node n counts down dependents[firstDependent[n] .. firstDependent[n + 1])
+	std::vector<int> firstDependent;
+	std::vector<int> dependents;
+};
+
+// the work the pool schedules: run one node of a RenderSchedule. called from whichever pool
+// thread picked the node up, always after every prerequisite of that node has finished
+class RenderNodeRunner {
+public:
+	virtual void RunNode(int nodeIndex) = 0;
+protected:
+	~RenderNodeRunner() = default;
+};
+
+// worker threads that execute a RenderSchedule across cores: a RenderGraph's track DAG for
+// one block, or several blocks of it at once for an offline render. the thread calling Execute
+// takes part as slot 0: it seeds its own deque with the ready nodes and works alongside the
+// workers, which steal from it and from each other. a node whose last prerequisite finishes is
+// pushed onto the finishing thread's deque, so a group is usually mixed on the core that still
+// has its children's buffers in cache. per-node results don't depend on which thread ran them,
+// so the output is bit-identical to the serial path
+class RenderThreadPool {
+public:
+	// schedules larger than this fall back to the serial path (fixed deque capacity)
+	static constexpr int kMaxNodes = 4096;
+
+	RenderThreadPool() = default;
+	~RenderThreadPool();
+
+	// spawn the workers. numWorkers < 0 means one per core besides the calling thread.
+	// realtime workers ask for the audio thread's scheduling class and spin through a job
+	// instead of sleeping. offline renders, which share the machine with live playback, run
+	// at normal priority and sleep while there is nothing to take
+	void Start(int numWorkers = -1, bool realtime = true);
+	void Stop();
+
+	int GetNumWorkers() const { return mSlots.empty() ? 0 : (int)mSlots.size() - 1; }
+
+	// run runner.RunNode for every node in schedule.order, prerequisites first. returns once
+	// all of them have finished. never called from two threads at once
+	void Execute(const RenderSchedule& schedule, RenderNodeRunner& runner);
+private:
+	struct alignas(64) Slot {
+		WorkStealingDeque<int, kMaxNodes> deque;
+		std::thread thread; // empty for slot 0
+	};
+
+	void WorkerLoop(int slot);
+	void WorkUntilDone(int slot);
+	bool TryRunOne(int slot);
+	void RunNode(int slot, int node);
+
+	std::vector<std::unique_ptr<Slot>> mSlots; // [0] = the thread calling Execute
+
+	// current job. written by Execute before it publishes any node, read by whoever runs one
+	std::atomic<const RenderSchedule*> mSchedule{nullptr};
+	std::atomic<RenderNodeRunner*> mRunner{nullptr};
+	std::unique_ptr<std::atomic<int>[]> mPending; // per node, prerequisites not yet finished
+	alignas(64) std::atomic<int> mRemaining{0};			  // nodes of the current job not yet finished
+
+	// bumped once per job; idle workers sleep on it
+	alignas(64) std::atomic<uint32_t> mEpoch{0};
+	std::atomic<bool> mStopping{false};
+	bool mRealtime = true;
+
+	// offline pools only: bumped whenever a node is queued or the job finishes, so a thread
+	// that found nothing to take can sleep on it instead of spinning
+	alignas(64) std::atomic<uint32_t> mQueued{0};
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstddef>
+
+// fixed-capacity single-producer/single-consumer ring buffer. every operation is wait-free
+// and nothing allocates after construction, so either end may live on the audio thread.
+// exactly one thread may push and exactly one (other) thread may pop
+template <typename T, size_t Capacity>
+class SpscQueue {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+public:
+	// producer side. returns false (and drops the item) when the queue is full
+	bool Push(const T& item) {
+		size_t head = mHead.load(std::memory_order_relaxed);
+		size_t tail = mTail.load(std::memory_order_acquire);
+		if (head - tail >= Capacity)
+			return false;
+		mItems[head & (Capacity - 1)] = item;
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side. the oldest item, or nullptr when empty; stays valid until Pop()
+	const T* Front() const {
+		size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail == mHead.load(std::memory_order_acquire))
+			return nullptr;
+		return &mItems[tail & (Capacity - 1)];
+	}
+
+	// consumer side. discards the oldest item; no-op when empty
+	void Pop() {
+		size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail == mHead.load(std::memory_order_acquire))
+			return;
+		mTail.store(tail + 1, std::memory_order_release);
+	}
+
+	bool Empty() const { return mTail.load(std::memory_order_acquire) == mHead.load(std::memory_order_acquire); }
+private:
+	// producer and consumer indices on separate cache lines so the two threads don't
+	// bounce one line between cores on every push/pop
+	alignas(64) std::atomic<size_t> mHead{0};
+	alignas(64) std::atomic<size_t> mTail{0};
+	std::array<T, Capacity> mItems{};
+};
@@ -5,7 +5,10 @@
 #include "Clips/MIDIClip.h"
 #include "Clips/AudioClip.h"
 #include "Clips/WarpEngine.h"
+#include "Clips/WarpFreeze.h"
+#include "Clips/Resampler.h"
 #include "ProcessorFactory.h"
+#include "Autosave.h"
 #include "Theme.h"
 #include "Processors/VSTProcessor.h"
 #include "Processors/VST3Processor.h"
@@ -13,6 +16,7 @@
 #include <algorithm>
 #include <sstream>
 #include <cstdlib>
+#include <limits>
 
 float AutomationCurve::Evaluate(double beat) const {
 
@@ -54,6 +58,32 @@ float AutomationCurve::Evaluate(double beat) const {
 	return points.back().value;
 }
 
+void ClipIntervalIndex::Build(const std::vector<ClipRenderState>& clips) {
+	order.resize(clips.size());
+	for (size_t i = 0; i < clips.size(); ++i)
+		order[i] = (int)i;
+	std::stable_sort(order.begin(), order.end(), [&clips](int a, int b) {
+		return clips[a].startBeat < clips[b].startBeat;
+	});
+
+	startBeat.resize(order.size());
+	maxEndBeat.resize(order.size());
+	double maxEnd = -std::numeric_limits<double>::infinity();
+	for (size_t k = 0; k < order.size(); ++k) {
+		const ClipRenderState& cs = clips[order[k]];
+		maxEnd = std::max(maxEnd, cs.endBeat);
+		startBeat[k] = cs.startBeat;
+		maxEndBeat[k] = maxEnd;
+	}
+}
+
+std::pair<size_t, size_t> ClipIntervalIndex::Find(double beginBeat, double endBeat) const {
+	// nothing before first ends after beginBeat; nothing from last on starts before endBeat
+	size_t first = std::upper_bound(maxEndBeat.begin(), maxEndBeat.end(), beginBeat) - maxEndBeat.begin();
+	size_t last = std::lower_bound(startBeat.begin(), startBeat.end(), endBeat) - startBeat.begin();
+	return {first, std::max(first, last)};
+}
+
 Track::Track() {
 
 	mVolumeParam = std::make_unique<SliderParameter>("Volume", 0.0f, -60.0f, 6.0f);
@@ -69,9 +99,9 @@ void Track::InitMasterTrackParameters(float initialBpm) {
 	mBpmParam = std::make_unique<SliderParameter>("BPM", initialBpm, 20.0f, 300.0f);
 }
 
-void Track::PrepareToPlay(double sampleRate) {
+void Track::PrepareToPlay(double sampleRate, int maxBlockFrames) {
 	for (auto& proc : mProcessors) {
-		proc->PrepareToPlay(sampleRate);
+		proc->PrepareToPlay(sampleRate, maxBlockFrames);
 	}
 }
 void Track::Reset() {
@@ -81,28 +111,24 @@ void Track::Reset() {
 	mPeakL.store(0.0f);
 	mPeakR.store(0.0f);
 }
-void Track::AllNotesOff() {
+void Track::Reset(const TrackRenderState& state) {
+	for (auto& proc : state.processors) {
+		proc->Reset();
+	}
+	mPeakL.store(0.0f);
+	mPeakR.store(0.0f);
+}
+void Track::AllNotesOff(const TrackRenderState& state) {
 	// only instruments hold MIDI notes, so only they need flushing on a loop wrap. use
 	// AllNotesOff (a note release), NOT Reset: Reset is a hard panic that also cuts a
 	// synth's own reverb/delay tail (VST2 sends cc 120 all-sound-off; built-in effects
 	// clear their buffers), which would break a looped region's ambience. effects are
 	// skipped entirely so their tails ring on across the loop point
-	for (auto& proc : mProcessors) {
+	for (auto& proc : state.processors) {
 		if (proc->IsInstrument())
 			proc->AllNotesOff();
 	}
 }
-void Track::ClearAccumulator() {
-	std::fill(mInputAccumulator.begin(), mInputAccumulator.end(), 0.0f);
-}
-void Track::AddToAccumulator(const float* input, int numFrames, int numChannels) {
-	if (mInputAccumulator.size() < (size_t)(numFrames * numChannels)) {
-		mInputAccumulator.resize(numFrames * numChannels, 0.0f);
-	}
-	for (int i = 0; i < numFrames * numChannels; ++i) {
-		mInputAccumulator[i] += input[i];
-	}
-}
 void Track::AddProcessor(std::shared_ptr<AudioProcessor> processor) {
 	InsertProcessor((int)mProcessors.size(), processor);
 }
@@ -139,22 +165,117 @@ void Track::EvaluateAutomation(double currentBeat) {
 	}
 }
 
+void Track::EvaluateAutomation(const TrackRenderState& state, double currentBeat) {
+	for (const auto& curve : state.automation) {
+		if (curve.targetParam) {
+			float val = curve.Evaluate(currentBeat);
+			curve.targetParam->value = val;
+		}
+	}
+}
+
+void Track::CaptureRenderState(TrackRenderState& out) const {
+	out.clips.clear();
+	out.clips.reserve(mClips.size());
+	out.hasStreams = false;
+	for (const auto& clip : mClips) {
+		ClipRenderState cs;
+		cs.clip = clip;
+		cs.startBeat = clip->GetStartBeat();
+		cs.endBeat = clip->GetEndBeat();
+		if (const MIDIClip* mc = clip->As<MIDIClip>())
+			cs.midi = mc->GetSchedule();
+		else if (const AudioClip* ac = clip->As<AudioClip>()) {
+			cs.audio = ac->GetData();
+			cs.stream = ac->GetStream();
+			cs.alignment = ac->GetAlignmentTable();
+			cs.window = ac->GetWindowTable();
+			cs.vocoder = ac->GetVocoder();
+			cs.freeze = ac->GetFreeze();
+			cs.freezeStream = ac->GetFreezeStream();
+			out.hasStreams |= cs.stream != nullptr || cs.freezeStream != nullptr;
+		}
+		out.clips.push_back(std::move(cs));
+	}
+	out.clipIndex.Build(out.clips);
+	out.processors = mProcessors;
+	out.automation = mAutomationCurves;
+}
+
+bool Track::MatchesRenderState(const TrackRenderState& state) const {
+	if (state.processors != mProcessors)
+		return false;
+
+	if (state.clips.size() != mClips.size())
+		return false;
+	for (size_t i = 0; i < mClips.size(); ++i) {
+		const ClipRenderState& cs = state.clips[i];
+		if (cs.clip != mClips[i])
+			return false;
+		// a moved or resized clip has to be re-indexed
+		if (cs.startBeat != cs.clip->GetStartBeat() || cs.endBeat != cs.clip->GetEndBeat())
+			return false;
+		if (cs.midi) {
+			// a note edit moves the clip's revision, which compiles a new schedule
+			auto mc = std::static_pointer_cast<MIDIClip>(cs.clip);
+			if (cs.midi != mc->GetSchedule())
+				return false;
+		} else if (const AudioClip* ac = cs.clip->As<AudioClip>()) {
+			if (cs.audio != ac->GetData() || cs.stream != ac->GetStream() || cs.alignment != ac->GetAlignmentTable() ||
+				cs.window != ac->GetWindowTable() || cs.vocoder != ac->GetVocoder() || cs.freeze != ac->GetFreeze() ||
+				cs.freezeStream != ac->GetFreezeStream())
+				return false;
+		}
+	}
+
+	if (state.automation.size() != mAutomationCurves.size())
+		return false;
+	for (size_t i = 0; i < mAutomationCurves.size(); ++i) {
+		const AutomationCurve& a = state.automation[i];
+		const AutomationCurve& b = mAutomationCurves[i];
+		if (a.targetParam != b.targetParam || a.points.size() != b.points.size())
+			return false;
+		// selection is ui-only state, so only the shape of the curve counts
+		for (size_t k = 0; k < a.points.size(); ++k) {
+			const AutomationPoint& pa = a.points[k];
+			const AutomationPoint& pb = b.points[k];
+			if (pa.beat != pb.beat || pa.value != pb.value || pa.tension != pb.tension)
+				return false;
+		}
+	}
+	return true;
+}
+
+// how far ahead of the playhead Process cues streamed clips that haven't started yet
+static constexpr double kStreamLookaheadSeconds = 2.0;
+
+// source frames [firstFrame, endFrame) an audio clip reads for `count` output frames starting
+// `outStart` frames into the clip, by whichever path Process plays it with
+static void GetAudioSourceSpan(const ClipRenderState& clipState, const AudioClip& clip, const ProcessContext& context,
+							   double offsetOutputFrames, int64_t outStart, int count, int64_t& firstFrame, int64_t& endFrame) {
+	if (clip.UsesGranularEngine()) {
+		GetWarpedSourceSpan(outStart, count, MakeWarpParams(clip, context.sampleRate, context.bpm), firstFrame, endFrame,
+							clipState.vocoder.get());
+		return;
+	}
+	double playbackRate = clip.ComputePlaybackRate(context.sampleRate, context.bpm);
+	double startReadFrame = (double)outStart * playbackRate + offsetOutputFrames * playbackRate;
+	int before = 0, after = 0; // the interpolator's taps either side of each read
+	GetResampleReach(context.resampleQuality, playbackRate, before, after);
+	firstFrame = (int64_t)std::floor(startReadFrame) - before;
+	endFrame = (int64_t)std::floor(startReadFrame + (double)(count - 1) * playbackRate) + after + 1;
+}
+
 void Track::Process(float* buffer, int numFrames, int numChannels,
 					std::vector<MIDIMessage>& mIDIMessages,
 					const ProcessContext& context,
+					const TrackRenderState& state,
 					bool accumulateToOutput) {
 
 	// automation processing
 	if (context.isPlaying) {
 		double currentBeat = (double)context.currentSample / context.sampleRate * (context.bpm / 60.0);
-		EvaluateAutomation(currentBeat);
-	}
-
-	// accumulate group inputs
-	if (mInputAccumulator.size() >= (size_t)(numFrames * numChannels)) {
-		for (int i = 0; i < numFrames * numChannels; ++i) {
-			buffer[i] += mInputAccumulator[i];
-		}
+		EvaluateAutomation(state, currentBeat);
 	}
 
 	// sequencer & audio playback
@@ -163,7 +284,14 @@ void Track::Process(float* buffer, int numFrames, int numChannels,
 		int64_t trackStartSample = context.currentSample;
 		int64_t trackEndSample = trackStartSample + numFrames;
 
-		for (const auto& clipBase : mClips) {
+		// the index narrows the arrangement to clips around this block (padded by a sample
+		// for the truncation below); the live geometry test still decides each one
+		double blockStartBeat = (double)(trackStartSample - 1) / samplesPerBeat;
+		double blockEndBeat = (double)(trackEndSample + 1) / samplesPerBeat;
+		auto [firstClip, lastClip] = state.clipIndex.Find(blockStartBeat, blockEndBeat);
+		for (size_t k = firstClip; k < lastClip; ++k) {
+			const auto& clipState = state.clips[state.clipIndex.order[k]];
+			const auto& clipBase = clipState.clip;
 			int64_t clipStartSample = (int64_t)(clipBase->GetStartBeat() * samplesPerBeat);
 			int64_t clipDurationSamples = (int64_t)(clipBase->GetDuration() * samplesPerBeat);
 			int64_t clipEndSample = clipStartSample + clipDurationSamples;
@@ -174,14 +302,15 @@ void Track::Process(float* buffer, int numFrames, int numChannels,
 			double offsetBeats = clipBase->GetOffset();
 
 			// handle MIDIClip
-			auto mIDIClip = std::dynamic_pointer_cast<MIDIClip>(clipBase);
-			if (mIDIClip) {
-				const auto& notes = mIDIClip->GetNotes();
-				for (const auto& note : notes) {
+			if (clipState.midi) {
+				const MIDINoteSchedule& schedule = *clipState.midi;
+				const int64_t kOnsetChaseSlopSamples = 4;
+
+				auto emitNote = [&](const MIDINote& note) {
 					// apply offset to note position
 					double adjustedStart = note.startBeat - offsetBeats;
 					if (adjustedStart < 0)
-						continue; // note starts before current clip view
+						return; // note starts before current clip view
 
 					int64_t noteOnAbs = clipStartSample + (int64_t)(adjustedStart * samplesPerBeat);
 					int64_t noteOffAbs = noteOnAbs + (int64_t)(note.durationBeats * samplesPerBeat);
@@ -201,7 +330,6 @@ void Track::Process(float* buffer, int numFrames, int numChannels,
 					// lined up with the playhead can land a sample or two before the block start.
 					// on a fresh start/seek, chase such onsets (but only while the note is still
 					// sounding, so a fully-past note is never turned on without a matching off)
-					const int64_t kOnsetChaseSlopSamples = 4;
 					bool fireOn;
 					if (context.playheadJumped)
 						fireOn = noteOnAbs >= trackStartSample - kOnsetChaseSlopSamples && noteOnAbs < trackEndSample && noteOffAbs > trackStartSample;
@@ -236,14 +364,45 @@ void Track::Process(float* buffer, int numFrames, int numChannels,
 						msg.frameIndex = (int)offFrame;
 						mIDIMessages.push_back(msg);
 					}
+				};
+
+				// only the notes that can start or stop in this block. the search windows are in
+				// note beats, padded for the truncations above; emitNote still decides exactly
+				const double kSearchPadSamples = 4.0;
+				double pad = kSearchPadSamples / samplesPerBeat;
+				auto noteBeatAt = [&](int64_t sample) {
+					return (double)(sample - clipStartSample) / samplesPerBeat + offsetBeats;
+				};
+				auto firstAtOrAfter = [](const std::vector<double>& beats, double beat) {
+					return (size_t)(std::lower_bound(beats.begin(), beats.end(), beat) - beats.begin());
+				};
+
+				double onFromBeat = noteBeatAt(trackStartSample - kOnsetChaseSlopSamples) - pad;
+				double onToBeat = noteBeatAt(trackEndSample) + pad;
+				size_t onLast = firstAtOrAfter(schedule.startBeats, onToBeat);
+				for (size_t k = firstAtOrAfter(schedule.startBeats, onFromBeat); k < onLast; ++k)
+					emitNote(schedule.notes[schedule.byStart[k]]);
+
+				// note-offs here, plus every note clamped to a clip end that falls in this block.
+				// a note already visited for its onset is skipped
+				size_t offFirst = firstAtOrAfter(schedule.endBeats, noteBeatAt(trackStartSample) - pad);
+				size_t offLast = firstAtOrAfter(schedule.endBeats, noteBeatAt(trackEndSample) + pad);
+				if (clipEndSample <= trackEndSample) {
+					offFirst = std::min(offFirst, firstAtOrAfter(schedule.endBeats, noteBeatAt(clipEndSample) - pad));
+					offLast = schedule.endBeats.size();
+				}
+				for (size_t k = offFirst; k < offLast; ++k) {
+					const MIDINote& note = schedule.notes[schedule.byEnd[k]];
+					if (note.startBeat < onFromBeat || note.startBeat >= onToBeat)
+						emitNote(note);
 				}
 			}
 
 			// handle AudioClip
-			auto audioClip = std::dynamic_pointer_cast<AudioClip>(clipBase);
-			if (audioClip) {
-				const auto& samples = audioClip->GetSamples();
-				int clipChannels = audioClip->GetNumChannels();
+			// a tag check and a raw pointer: no rtti walk or refcount traffic on the audio thread
+			AudioClip* audioClip = clipBase->As<AudioClip>();
+			if (audioClip && (clipState.audio || clipState.stream)) {
+				int clipChannels = clipState.audio ? clipState.audio->channels : clipState.stream->GetChannels();
 
 				// output window into this block, shared by both playback paths
 				int64_t overlapStart = max(trackStartSample, clipStartSample);
@@ -251,68 +410,111 @@ void Track::Process(float* buffer, int numFrames, int numChannels,
 				int bufferOffset = (int)(overlapStart - trackStartSample);
 				int processCount = (int)(overlapEnd - overlapStart);
 				int64_t outputSamplesSinceClipStart = overlapStart - clipStartSample;
+				if (processCount <= 0 || clipChannels <= 0)
+					continue;
 
 				// clip file offset in output frames (same for both paths)
 				double offsetSeconds = offsetBeats * (60.0 / context.bpm);
 				double offsetOutputFrames = offsetSeconds * context.sampleRate;
 
-				if (audioClip->UsesGranularEngine() && !samples.empty() && clipChannels > 0 && processCount > 0) {
+				// a warped clip with its output rendered ahead of time plays that, when it was made
+				// for the clip as it is now and covers the block. an export renders live, so it
+				// doesn't depend on how far the worker got. a streamed clip still cues its stream,
+				// so an edit that drops the freeze doesn't start on a cold ring
+				if (clipState.freeze && !context.isOffline && audioClip->UsesGranularEngine()) {
+					WarpRenderParams wp = MakeWarpParams(*audioClip, context.sampleRate, context.bpm);
+					if (clipState.freeze->Mix(wp, clipState.freezeStream.get(), outputSamplesSinceClipStart, processCount, numChannels, &buffer[bufferOffset * numChannels])) {
+						if (clipState.stream) {
+							int64_t firstFrame = 0, endFrame = 0;
+							GetAudioSourceSpan(clipState, *audioClip, context, offsetOutputFrames, outputSamplesSinceClipStart, processCount, firstFrame, endFrame);
+							clipState.stream->Cue(firstFrame);
+						}
+						continue;
+					}
+				}
+
+				// source audio for this block: the snapshot's copy of the decoded (or mapped float)
+				// file, so a reload can't free it mid-block, or for a streamed clip just the span
+				// the block reads, gathered out of the disk thread's ring or the mapping
+				const float* samples = nullptr;
+				size_t numSamples = 0;
+				int64_t firstFrame = 0;
+				if (clipState.audio) {
+					samples = clipState.audio->data;
+					numSamples = clipState.audio->numSamples;
+				} else {
+					SampleStream& stream = *clipState.stream;
+					int64_t endFrame = 0;
+					GetAudioSourceSpan(clipState, *audioClip, context, offsetOutputFrames, outputSamplesSinceClipStart, processCount, firstFrame, endFrame);
+					endFrame = std::min(endFrame, firstFrame + SampleStream::kScratchFrames);
+					float* scratch = stream.GetScratch();
+					if (context.isOffline) {
+						stream.ReadDirect(firstFrame, endFrame - firstFrame, scratch);
+					} else {
+						stream.Cue(firstFrame);
+						stream.Read(firstFrame, endFrame - firstFrame, scratch); // a miss plays as silence
+					}
+					samples = scratch;
+					numSamples = (size_t)(endFrame - firstFrame) * clipChannels;
+				}
+				if (numSamples == 0)
+					continue;
+
+				if (audioClip->UsesGranularEngine()) {
 					// warped, non-Re-Pitch: the granular engine decouples time from pitch. it is
 					// position-addressable, so it fills this block straight from transport time
 					// just like the linear path -- seek/loop/offline export stay deterministic
-					WarpRenderParams wp;
-					wp.mode = audioClip->GetWarpMode();
-					wp.sampleRate = context.sampleRate;
-					wp.speed = audioClip->ComputeTimeStretchRate(context.sampleRate, context.bpm);
-					wp.pitchRead = audioClip->ComputePitchReadRate(context.sampleRate);
-					double totalSemis = audioClip->GetTransposeSemitones() + audioClip->GetTransposeCents() / 100.0;
-					wp.pitchRatio = std::pow(2.0, totalSemis / 12.0);
-					wp.offsetOutputFrames = offsetOutputFrames;
-					wp.grainSizeMs = audioClip->GetGrainSizeMs();
-					wp.fluctuation = audioClip->GetFluctuation();
-					wp.transientEnvelope = audioClip->GetTransientEnvelope();
-					wp.formants = audioClip->GetFormants();
-
-					RenderWarpedBlock(samples.data(), samples.size(), clipChannels,
+					// a decoded clip's grain alignment comes out of its table once searched, and
+					// every warped clip's grain window out of its own. Complex/ComplexPro play
+					// through the clip's vocoder, which caches only pure per-frame results
+					WarpRenderParams wp = MakeWarpParams(*audioClip, context.sampleRate, context.bpm);
+					RenderWarpedBlock(samples, numSamples, clipChannels, firstFrame,
 									  outputSamplesSinceClipStart, processCount, numChannels,
-									  &buffer[bufferOffset * numChannels], wp);
+									  &buffer[bufferOffset * numChannels], wp,
+									  clipState.audio ? clipState.alignment.get() : nullptr, clipState.window.get(),
+									  clipState.vocoder.get());
 				} else {
-					// unwarped or Re-Pitch: single-rate resample (also drives the waveform preview)
+					// unwarped or Re-Pitch: single-rate resample at the context's quality (also drives the waveform preview)
 					double playbackRate = audioClip->ComputePlaybackRate(context.sampleRate, context.bpm);
 					double offsetSourceFrames = offsetOutputFrames * playbackRate;
 					double startReadFrame = (double)outputSamplesSinceClipStart * playbackRate + offsetSourceFrames;
 
-					for (int i = 0; i < processCount; ++i) {
-						double framePos = startReadFrame + ((double)i * playbackRate);
-						int frameIndex = (int)framePos;
-
-						// bounds check
-						if (frameIndex < 0)
-							continue;
-						if ((size_t)((frameIndex + 1) * clipChannels) >= samples.size())
-							break; // end of file
-
-						double alpha = framePos - frameIndex;
-
-						for (int c = 0; c < numChannels; ++c) {
-							int srcC = c % clipChannels;
-							int idx1 = frameIndex * clipChannels + srcC;
-							int idx2 = idx1 + clipChannels;
-
-							float val = samples[idx1] + (float)alpha * (samples[idx2] - samples[idx1]);
-							buffer[(bufferOffset + i) * numChannels + c] += val;
-						}
-					}
+					ResampleBlock(samples, numSamples, clipChannels, firstFrame, startReadFrame, playbackRate, processCount,
+								  numChannels, &buffer[bufferOffset * numChannels], context.resampleQuality);
 				}
 			}
 		}
+
+		// streamed clips about to start get their opening cued now, so the disk thread has it
+		// resident by the time the playhead arrives
+		if (state.hasStreams && !context.isOffline) {
+			double lookaheadEndBeat = blockEndBeat + kStreamLookaheadSeconds * (context.bpm / 60.0);
+			auto [firstAhead, lastAhead] = state.clipIndex.Find(blockEndBeat, lookaheadEndBeat);
+			for (size_t k = firstAhead; k < lastAhead; ++k) {
+				const auto& clipState = state.clips[state.clipIndex.order[k]];
+				if (!clipState.stream && !clipState.freezeStream)
+					continue;
+				int64_t clipStartSample = (int64_t)(clipState.clip->GetStartBeat() * samplesPerBeat);
+				if (clipStartSample < trackEndSample)
+					continue; // already playing, cued above
+				if (clipState.freezeStream)
+					clipState.freezeStream->Cue(0); // a spilled freeze plays from the clip start
+				if (!clipState.stream)
+					continue;
+				const AudioClip* audioClip = clipState.clip->As<AudioClip>();
+				double offsetOutputFrames = clipState.clip->GetOffset() * (60.0 / context.bpm) * context.sampleRate;
+				int64_t firstFrame = 0, endFrame = 0;
+				GetAudioSourceSpan(clipState, *audioClip, context, offsetOutputFrames, 0, 1, firstFrame, endFrame);
+				clipState.stream->Cue(firstFrame);
+			}
+		}
 	}
 
 	std::sort(mIDIMessages.begin(), mIDIMessages.end(), [](const MIDIMessage& a, const MIDIMessage& b) {
 		return a.frameIndex < b.frameIndex;
 	});
 
-	for (auto& proc : mProcessors) {
+	for (auto& proc : state.processors) {
 		if (!proc->IsBypassed()) {
 			proc->Process(buffer, numFrames, numChannels, mIDIMessages, context);
 		}
@@ -411,9 +613,9 @@ void Track::ResolveOverlaps(std::shared_ptr<Clip> activeClip) {
 			else if (aStart > bStart && aEnd < bEnd) {
 				// create the "right" side of the split
 				std::shared_ptr<Clip> rightSide = nullptr;
-				if (auto ac = std::dynamic_pointer_cast<AudioClip>(b))
+				if (AudioClip* ac = b->As<AudioClip>())
 					rightSide = std::make_shared<AudioClip>(*ac);
-				else if (auto mc = std::dynamic_pointer_cast<MIDIClip>(b))
+				else if (MIDIClip* mc = b->As<MIDIClip>())
 					rightSide = std::make_shared<MIDIClip>(*mc);
 
 				if (rightSide) {
@@ -575,9 +777,9 @@ void Track::Save(std::ostream& out, int trackIndex) {
 
 	for (auto& clip : mClips) {
 		std::string type = "UNKNOWN";
-		if (std::dynamic_pointer_cast<AudioClip>(clip))
+		if (clip->GetKind() == ClipKind::Audio)
 			type = "AUDIO";
-		else if (std::dynamic_pointer_cast<MIDIClip>(clip))
+		else if (clip->GetKind() == ClipKind::MIDI)
 			type = "MIDI";
 
 		out << "CLIP_GRID_NEXT " << clip->GetGridNumerator() << " " << clip->GetGridDenominator() << "\n";
@@ -599,9 +801,100 @@ void Track::Save(std::ostream& out, int trackIndex) {
 	out << "TRACK_END\n";
 }
 
-void Track::Load(std::istream& in) {
+void Track::Save(ChunkWriter& out, int parentIndex, ProcessorStateCache* cache) {
+	out.Begin(ProjectChunk::TrackHeader);
+	out.WriteString(mName);
+	out.Write<uint32_t>(mColor);
+	out.Write<float>(mVolumeParam->value);
+	out.Write<float>(mPanParam->value);
+	out.Write<uint8_t>(mMute ? 1 : 0);
+	out.Write<uint8_t>(mSolo ? 1 : 0);
+	out.Write<uint8_t>(mIsGroup ? 1 : 0);
+	out.Write<uint8_t>(mIsCollapsed ? 1 : 0);
+	out.Write<int32_t>(parentIndex);
+	out.End();
+
+	// processor state stays whatever the processor's own Save writes (a plugin's is its chunk,
+	// already encoded); the container just carries it as one sized blob
+	for (auto& proc : mProcessors) {
+		out.Begin(ProjectChunk::Processor);
+		out.WriteString(proc->GetProcessorId());
+		out.Write<int32_t>((int32_t)proc->GetEditorScalingMode());
+		if (cache) {
+			out.WriteString(cache->GetState(proc));
+		} else {
+			std::ostringstream state;
+			proc->Save(state);
+			out.WriteString(state.str());
+		}
+		out.End();
+	}
+
+	for (auto& clip : mClips) {
+		out.Begin(ProjectChunk::Clip);
+		clip->Save(out);
+		out.End();
+	}
+
+	for (auto& curve : mAutomationCurves) {
+		if (curve.points.empty())
+			continue;
+		out.Begin(ProjectChunk::Automation);
+		out.WriteString(curve.paramName);
+		out.Write<uint32_t>((uint32_t)curve.points.size());
+		for (auto& p : curve.points) {
+			out.Write<double>(p.beat);
+			out.Write<float>(p.value);
+			out.Write<float>(p.tension);
+		}
+		out.End();
+	}
+}
+
+// one saved processor into a processor. builds nothing the track owns. plugins are created on
+// the ui thread, in an export's copy of the project too (see RenderJob)
+std::shared_ptr<AudioProcessor> Track::LoadProcessor(const SavedProcessor& saved) {
+	const std::string& type = saved.type;
+	std::istringstream in(saved.text);
+	std::shared_ptr<AudioProcessor> proc = ProcessorFactory::Instance().Create(type);
+	// VST is special
+	if (!proc && type == "VST")
+		proc = std::make_shared<VSTProcessor>("");
+	else if (!proc && type == "VST3")
+		proc = std::make_shared<VST3Processor>("", "");
+
+	if (!proc)
+		return nullptr;
+
+	if (saved.scaling >= 0) {
+		proc->SetEditorScalingMode((EditorScalingMode)saved.scaling);
+	} else {
+		// text format: optional per-plugin editor scaling override (written since the
+		// high-DPI work; older projects omit it and rewind untouched)
+		std::streampos posBefore = in.tellg();
+		std::string maybeScaling;
+		if (std::getline(in, maybeScaling)) {
+			std::stringstream ss2(maybeScaling);
+			std::string tk;
+			ss2 >> tk;
+			if (tk == "PROC_SCALING") {
+				int m = 0;
+				ss2 >> m;
+				proc->SetEditorScalingMode((EditorScalingMode)m);
+			} else if (posBefore != std::streampos(-1)) {
+				in.seekg(posBefore); // not ours; let proc->Load consume it
+			}
+		}
+	}
+
+	proc->Load(in);
+	return proc;
+}
+
+void Track::Load(std::istream& in, std::vector<TrackLoadJob>* deferred) {
 	int pendingGridNum = 1;
 	int pendingGridDen = 4;
+	std::vector<SavedProcessor> processors;
 
 	std::string line;
 	while (std::getline(in, line)) {
@@ -642,41 +935,17 @@ void Track::Load(std::istream& in) {
 		} else if (token == "PARENT_IDX") {
 			ss >> mLoadedParentIndex;
 		} else if (token == "PROCESSOR") {
-			std::string type;
-			ss >> type;
-			std::shared_ptr<AudioProcessor> proc = nullptr;
-
-			proc = ProcessorFactory::Instance().Create(type);
-			// VST is special
-			if (!proc && type == "VST")
-				proc = std::make_shared<VSTProcessor>("");
-			else if (!proc && type == "VST3")
-				proc = std::make_shared<VST3Processor>("", "");
-
-			if (proc) {
-				// optional per-plugin editor scaling override (written since the
-				// high-DPI work; older projects omit it and rewind untouched)
-				std::streampos posBefore = in.tellg();
-				std::string maybeScaling;
-				if (std::getline(in, maybeScaling)) {
-					std::stringstream ss2(maybeScaling);
-					std::string tk;
-					ss2 >> tk;
-					if (tk == "PROC_SCALING") {
-						int m = 0;
-						ss2 >> m;
-						proc->SetEditorScalingMode((EditorScalingMode)m);
-					} else if (posBefore != std::streampos(-1)) {
-						in.seekg(posBefore); // not ours; let proc->Load consume it
-					}
-				}
-
-				proc->Load(in);
-				AddProcessor(proc);
-				std::string endTag;
-				if (std::getline(in, endTag)) {
-				}
+			// keep the block's text: plugins may be built later, and the chain in order
+			SavedProcessor saved;
+			ss >> saved.type;
+			std::string procLine;
+			while (std::getline(in, procLine)) {
+				if (procLine == "PROCESSOR_END")
+					break;
+				saved.text += procLine;
+				saved.text += '\n';
 			}
+			processors.push_back(std::move(saved));
 		} else if (token == "CLIP_GRID_NEXT") {
 			ss >> pendingGridNum >> pendingGridDen;
 		} else if (token == "CLIP_BEGIN") {
@@ -694,6 +963,8 @@ void Track::Load(std::istream& in) {
 				clip->SetGrid(pendingGridNum, pendingGridDen);
 				clip->Load(in);
 				AddClip(clip);
+				if (auto audio = ClipCast<AudioClip>(clip); audio && !audio->GetFilePath().empty())
+					LoadAudioFile(audio, deferred);
 			} else {
 				std::string skip;
 				while (std::getline(in, skip)) {
@@ -726,4 +997,118 @@ void Track::Load(std::istream& in) {
 			}
 		}
 	}
+
+	LoadProcessors(std::move(processors), deferred);
+}
+
+void Track::Load(const ChunkReader& in, std::vector<TrackLoadJob>* deferred) {
+	std::vector<SavedProcessor> processors;
+
+	ChunkReader chunks = in;
+	ChunkReader chunk;
+	uint32_t id = 0;
+	while (chunks.Next(id, chunk)) {
+		if (id == ProjectChunk::TrackHeader) {
+			mName = chunk.ReadString(mName);
+			mColor = chunk.Read<uint32_t>(mColor);
+			mVolumeParam->value = chunk.Read<float>(mVolumeParam->value);
+			mPanParam->value = chunk.Read<float>(mPanParam->value);
+			mMute = chunk.Read<uint8_t>(mMute) != 0;
+			mSolo = chunk.Read<uint8_t>(mSolo) != 0;
+			mIsGroup = chunk.Read<uint8_t>(mIsGroup) != 0;
+			mIsCollapsed = chunk.Read<uint8_t>(mIsCollapsed) != 0;
+			mLoadedParentIndex = chunk.Read<int32_t>(-1);
+		} else if (id == ProjectChunk::Processor) {
+			SavedProcessor saved;
+			saved.type = chunk.ReadString();
+			saved.scaling = chunk.Read<int32_t>((int32_t)EditorScalingMode::Default);
+			saved.text = chunk.ReadString();
+			processors.push_back(std::move(saved));
+		} else if (id == ProjectChunk::Clip) {
+			ChunkReader header;
+			if (!chunk.Find(ProjectChunk::ClipHeader, header))
+				continue;
+			std::shared_ptr<Clip> clip = nullptr;
+			ClipKind kind = (ClipKind)header.Read<uint8_t>();
+			if (kind == ClipKind::Audio)
+				clip = std::make_shared<AudioClip>();
+			else if (kind == ClipKind::MIDI)
+				clip = std::make_shared<MIDIClip>();
+			if (!clip)
+				continue; // a kind this build doesn't know
+			clip->Load(chunk);
+			AddClip(clip);
+			if (auto audio = ClipCast<AudioClip>(clip); audio && !audio->GetFilePath().empty())
+				LoadAudioFile(audio, deferred);
+		} else if (id == ProjectChunk::Automation) {
+			AutomationCurve curve;
+			curve.paramName = chunk.ReadString();
+			curve.targetParam = nullptr;
+			uint32_t count = chunk.Read<uint32_t>();
+			constexpr size_t kPointBytes = sizeof(double) + 2 * sizeof(float);
+			curve.points.resize(std::min<size_t>(count, chunk.GetRemaining() / kPointBytes));
+			for (auto& pt : curve.points) {
+				pt.beat = chunk.Read<double>();
+				pt.value = chunk.Read<float>();
+				pt.tension = chunk.Read<float>();
+			}
+			mAutomationCurves.push_back(std::move(curve));
+		}
+	}
+
+	LoadProcessors(std::move(processors), deferred);
+}
+
+void Track::LoadProcessors(std::vector<SavedProcessor> processors, std::vector<TrackLoadJob>* deferred) {
+	// plugins are the slow part of a chain (dll load, state restore), so a chain holding one is
+	// left to the loader and built as a whole when it's applied: the slots keep their order and
+	// the track never plays half its effects. plugins expect to be created on the ui thread, so
+	// unlike a clip's audio file the chain has nothing to do on a loader worker. native
+	// processors build in no time and stay inline
+	bool hasPlugin = std::any_of(processors.begin(), processors.end(), [](const SavedProcessor& p) {
+		return p.type == "VST" || p.type == "VST3";
+	});
+	if (!deferred || !hasPlugin) {
+		for (const auto& saved : processors) {
+			if (auto proc = LoadProcessor(saved))
+				AddProcessor(proc);
+		}
+		return;
+	}
+
+	TrackLoadJob job;
+	job.run = [] {};
+	job.apply = [this, processors = std::move(processors)](double sampleRate, int maxBlockFrames) {
+		std::vector<std::shared_ptr<AudioProcessor>> built;
+		for (const auto& saved : processors) {
+			if (auto proc = LoadProcessor(saved))
+				built.push_back(proc);
+		}
+		for (auto& proc : built) {
+			if (sampleRate > 0)
+				proc->PrepareToPlay(sampleRate, maxBlockFrames);
+			AddProcessor(proc);
+		}
+		RebindAutomation(); // curves on plugin parameters found nothing to bind to until now
+	};
+	deferred->push_back(std::move(job));
+}
+
+void Track::LoadAudioFile(const std::shared_ptr<AudioClip>& clip, std::vector<TrackLoadJob>* deferred) {
+	if (!deferred) {
+		clip->LoadFromFile(clip->GetFilePath());
+		return;
+	}
+
+	auto source = std::make_shared<AudioClipSource>();
+	TrackLoadJob job;
+	job.run = [source, path = clip->GetFilePath()] {
+		AudioClip::OpenSource(path, *source);
+	};
+	// the clip may have been deleted or moved off this track by the time the file is in;
+	// it's installed on the clip either way, and the graph picks it up wherever it lives
+	job.apply = [clip, source](double, int) {
+		clip->SetSource(std::move(*source));
+	};
+	deferred->push_back(std::move(job));
 }
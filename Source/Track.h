@@ -5,11 +5,22 @@
 #include <string>
 #include <atomic>
 #include <iostream>
+#include <functional>
 #include "AudioProcessor.h"
 #include "MIDITypes.h"
 #include "Clip.h"
+#include "Clips/MIDIClip.h"
+#include "Clips/SampleStream.h"
 #include "imgui.h" // for ImU32
 #include "Parameter.h"
+#include "ProjectFile.h"
+
+class AudioClip;
+class ProcessorStateCache;
+class WarpAlignmentTable;
+class WarpFreeze;
+class WarpVocoder;
+class WarpWindowTable;
 
 // automation structures
 struct AutomationPoint {
@@ -28,6 +39,55 @@ struct AutomationCurve {
 	float Evaluate(double beat) const;
 };
 
+// what the audio thread needs from one clip. scalar fields (geometry, warp knobs) are still
+// read live off the clip, like Parameter::value; only the containers an edit can reallocate
+// are copied, so a UI-side push_back can never pull memory out from under the callback
+struct ClipRenderState {
+	std::shared_ptr<Clip> clip;
+	std::shared_ptr<const MIDINoteSchedule> midi; // MIDI clips only
+	std::shared_ptr<const SampleData> audio;	   // audio clips only; a reload swaps the clip's copy
+	std::shared_ptr<SampleStream> stream;		   // streamed audio clips, instead of audio
+	std::shared_ptr<WarpAlignmentTable> alignment; // warped Tones clips (see AudioClip::UpdateWarpTables)
+	std::shared_ptr<const WarpWindowTable> window;  // warped clips
+	std::shared_ptr<WarpVocoder> vocoder;			// warped Complex/ComplexPro clips
+	std::shared_ptr<const WarpFreeze> freeze;		// warped clips, played once it's rendered
+	std::shared_ptr<SampleStream> freezeStream;		// the freeze's scratch file, when it was spilled
+	double startBeat = 0.0; // geometry at capture time, what ClipIntervalIndex was built from
+	double endBeat = 0.0;
+};
+
+// the captured clips sorted by start beat, so a block only visits the clips near it instead of
+// the whole arrangement. kept in beats, so a tempo change leaves it valid
+struct ClipIntervalIndex {
+	std::vector<int> order;			// clip indices, by start beat
+	std::vector<double> startBeat;	// sorted
+	std::vector<double> maxEndBeat; // running max of the clips' end beats, so also sorted
+
+	void Build(const std::vector<ClipRenderState>& clips);
+
+	// positions [first, last) in order that may overlap [beginBeat, endBeat). every clip that
+	// does is inside; a clip inside may still miss when an earlier, longer one spans the range
+	std::pair<size_t, size_t> Find(double beginBeat, double endBeat) const;
+};
+
+// immutable copy of every list Track::Process iterates. captured on the UI thread and
+// published to the audio thread inside a RenderGraph (see Project::PublishGraph)
+struct TrackRenderState {
+	std::vector<ClipRenderState> clips;
+	ClipIntervalIndex clipIndex;
+	bool hasStreams = false; // any clip plays from disk, so Process cues upcoming ones
+	std::vector<std::shared_ptr<AudioProcessor>> processors;
+	std::vector<AutomationCurve> automation;
+};
+
+// an asset Track::Load can leave for later. run() does the slow part that may leave the ui
+// thread (decoding an audio file) on a worker, so it touches nothing the project owns; apply()
+// installs the result on the ui thread, and creates whatever must be made there (plugins)
+struct TrackLoadJob {
+	std::function<void()> run;
+	std::function<void(double sampleRate, int maxBlockFrames)> apply;
+};
+
 class Track {
 public:
 	Track();
@@ -58,26 +118,30 @@ public:
 	float GetPeakR() const { return mPeakR.load(); }
 
 	// initialize all processors in the chain
-	void PrepareToPlay(double sampleRate);
+	void PrepareToPlay(double sampleRate, int maxBlockFrames);
 
 	// reset all processors (silence audio)
 	void Reset();
+	// audio-thread variant: resets the processors of a published snapshot
+	void Reset(const TrackRenderState& state);
 
 	// send note-offs to held instrument notes without disturbing effect DSP state, so it is
 	// safe to call mid-playback (e.g. at a loop wrap) without cutting delay/reverb tails
-	void AllNotesOff();
+	void AllNotesOff(const TrackRenderState& state);
 
-	// clear internal buffer (used for group mixing)
-	void ClearAccumulator();
-	// add audio from a child track into this track
-	void AddToAccumulator(const float* input, int numFrames, int numChannels);
-
-	// process the entire chain for this track
+	// process the entire chain for this track. clips, processors and automation come from
+	// the published snapshot, never from the live lists the UI edits. a group's buffer
+	// arrives already holding the sum of its children
 	void Process(float* buffer, int numFrames, int numChannels,
 				 std::vector<MIDIMessage>& mIDIMessages,
 				 const ProcessContext& context,
+				 const TrackRenderState& state,
 				 bool accumulateToOutput = false);
 
+	// render snapshot support (UI thread): copy the live lists, or check a copy is still current
+	void CaptureRenderState(TrackRenderState& out) const;
+	bool MatchesRenderState(const TrackRenderState& state) const;
+
 	// processor management
 	void AddProcessor(std::shared_ptr<AudioProcessor> processor);
 	void InsertProcessor(int index, std::shared_ptr<AudioProcessor> processor);
@@ -108,6 +172,7 @@ public:
 	void SetAutomationPoints(Parameter* param, const std::vector<AutomationPoint>& points);
 	Parameter* FindParameter(const std::string& name);
 	void EvaluateAutomation(double currentBeat);
+	static void EvaluateAutomation(const TrackRenderState& state, double currentBeat);
 
 	bool HasInstrument() const;
 
@@ -126,12 +191,22 @@ public:
 
 	// serialization
 	void Save(std::ostream& out, int trackIndex);
-	void Load(std::istream& in);
+	// loads audio files and plugins inline, or queues them on `deferred` for the caller to run
+	void Load(std::istream& in, std::vector<TrackLoadJob>* deferred = nullptr);
+	// binary project format: the contents of a TRAK/MAST chunk, which the project opens
+	void Save(ChunkWriter& out, int parentIndex, ProcessorStateCache* cache = nullptr);
+	void Load(const ChunkReader& in, std::vector<TrackLoadJob>* deferred = nullptr);
 	// fixup automation pointers after processors loaded
 	void RebindAutomation();
 
 	// temp storage for parent index during loading
 	int mLoadedParentIndex = -1;
+
+	// deferred load jobs (see ProjectLoader) still outstanding; the track stays silent until
+	// they are all in, rather than playing without its plugins
+	bool IsLoading() const { return mPendingLoads > 0; }
+	void AddPendingLoad() { ++mPendingLoads; }
+	void FinishPendingLoad() { --mPendingLoads; }
 private:
 	std::string mName = "Track";
 	ImU32 mColor = IM_COL32(100, 100, 100, 255);
@@ -145,6 +220,18 @@ private:
 	std::unique_ptr<Parameter> mBpmParam;	 // BPM (Master Track only)
 	bool mMute = false;
 	bool mSolo = false;
+	int mPendingLoads = 0;
+
+	// a processor as saved, not yet built: its type, editor scaling (-1 = in the text, as the
+	// text format writes it) and what its own Save wrote
+	struct SavedProcessor {
+		std::string type;
+		int scaling = -1;
+		std::string text;
+	};
+	static std::shared_ptr<AudioProcessor> LoadProcessor(const SavedProcessor& saved);
+	void LoadProcessors(std::vector<SavedProcessor> processors, std::vector<TrackLoadJob>* deferred);
+	void LoadAudioFile(const std::shared_ptr<AudioClip>& clip, std::vector<TrackLoadJob>* deferred);
 
 	// metering (atomic for thread safety)
 	std::atomic<float> mPeakL{0.0f};
@@ -153,7 +240,6 @@ private:
 	// grouping
 	bool mIsGroup = false;
 	std::weak_ptr<Track> mParent;
-	std::vector<float> mInputAccumulator; // buffer for group inputs
 
 	// automation data
 	std::vector<AutomationCurve> mAutomationCurves;
@@ -222,7 +222,7 @@ private:
 // audio-clip warp/pitch edit (warp toggle, mode, segment bpm, transpose, plus
 // any duration/offset the edit clamped). Snapshots the whole warp state before
 // and after; the retained AudioClip shared_ptr keeps it alive across history.
-// Undo/Redo lock the project mutex because the audio thread reads these fields
+// Undo/Redo lock the project mutex so the edit never lands mid-export
 // ---------------------------------------------------------------------------
 class AudioClipWarpAction : public UndoableAction {
 public:
@@ -278,7 +278,7 @@ private:
 // piano-roll note edit (add / delete / move / resize / nudge / velocity).
 // Snapshots the whole note list before and after; the retained MIDIClip
 // shared_ptr keeps the sequence alive across the history. Undo/Redo lock the
-// project mutex because the audio thread iterates the same note vector
+// project mutex; the audio thread plays a published copy of the notes
 // ---------------------------------------------------------------------------
 class NoteEditAction : public UndoableAction {
 public:
@@ -299,6 +299,7 @@ private:
 			return;
 		std::lock_guard<std::mutex> lock(mProject->GetMutex());
 		mClip->GetNotesEx() = state;
+		mClip->NotesChanged();
 	}
 	Project* mProject;
 	std::shared_ptr<MIDIClip> mClip;
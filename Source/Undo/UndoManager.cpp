@@ -4,6 +4,7 @@
 void UndoManager::Push(std::unique_ptr<UndoableAction> action) {
 	if (!action)
 		return;
+	++mRevision;
 
 	// during a transaction, buffer instead of committing immediately
 	if (mTransactionDepth > 0) {
@@ -32,6 +33,7 @@ void UndoManager::Undo() {
 		return;
 	std::unique_ptr<UndoableAction> action = std::move(mUndoStack.back());
 	mUndoStack.pop_back();
+	++mRevision;
 	action->Undo();
 	mRedoStack.push_back(std::move(action));
 }
@@ -41,6 +43,7 @@ void UndoManager::Redo() {
 		return;
 	std::unique_ptr<UndoableAction> action = std::move(mRedoStack.back());
 	mRedoStack.pop_back();
+	++mRevision;
 	action->Redo();
 	mUndoStack.push_back(std::move(action));
 }
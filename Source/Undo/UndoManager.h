@@ -42,6 +42,9 @@ public:
 	// number of applied (undoable) actions; also the index of the current state
 	// in a list whose row 0 is the base state
 	size_t GetAppliedCount() const { return mUndoStack.size(); }
+
+	// moves on every push, undo and redo: a cheap "has the project been edited" check
+	uint64_t GetRevision() const { return mRevision; }
 private:
 	std::vector<std::unique_ptr<UndoableAction>> mUndoStack;
 	std::vector<std::unique_ptr<UndoableAction>> mRedoStack;
@@ -49,6 +52,7 @@ private:
 	static constexpr size_t kMaxDepth = 200;
 
 	// transaction state
+	uint64_t mRevision = 0;
 	int mTransactionDepth = 0;
 	const char* mTransactionName = "Edit";
 	std::vector<std::unique_ptr<UndoableAction>> mTransactionBuffer;
@@ -40,7 +40,7 @@ void ClipView::Render(const ImVec2& pos, float width, float height) {
 	ImGui::TextDisabled("(%.2f beats)", clip->GetDuration());
 	ImGui::Separator();
 
-	if (auto ac = std::dynamic_pointer_cast<AudioClip>(clip)) {
+	if (auto ac = ClipCast<AudioClip>(clip)) {
 		Project* project = mContext.GetProject();
 		double projectBpm = project ? project->GetTransport().GetBpm() : 120.0;
 
@@ -192,6 +192,13 @@ void ClipView::Render(const ImVec2& pos, float width, float height) {
 					ImGui::TextDisabled("Tempo change shifts pitch (tape)");
 				else
 					ImGui::TextDisabled("Pitch preserved on tempo change");
+				if (mode == WarpMode::Complex || mode == WarpMode::ComplexPro) {
+					ImGui::TextDisabled("Phases restart on seek/loop (?)");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("After a seek or a loop wrap, sustained sounds can play with slightly\n"
+										  "different phasing than an uninterrupted pass, until the next transient.\n"
+										  "A frozen clip always sounds as if played from its start.");
+				}
 			} else {
 				ImGui::TextDisabled("Warping Disabled");
 				ImGui::TextDisabled("Audio plays at native speed");
@@ -266,7 +273,7 @@ void ClipView::Render(const ImVec2& pos, float width, float height) {
 		}
 
 		ImGui::Columns(1);
-	} else if (auto mc = std::dynamic_pointer_cast<MIDIClip>(clip)) {
+	} else if (auto mc = ClipCast<MIDIClip>(clip)) {
 		// MIDI clip controls
 		ImGui::Text("MIDI Properties");
 		ImGui::Separator();
@@ -156,7 +156,7 @@ void DeviceRackView::Render(const ImVec2& pos, float width, float height) {
 						std::lock_guard<std::mutex> lock(project->GetMutex());
 						selectedTrack->InsertProcessor(i, vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 						mContext.undoManager.Push(std::make_unique<ProcessorPresenceAction>(project, selectedTrack, vST, i, true));
 					}
 				}
@@ -172,7 +172,7 @@ void DeviceRackView::Render(const ImVec2& pos, float width, float height) {
 							std::lock_guard<std::mutex> lock(project->GetMutex());
 							selectedTrack->InsertProcessor(i, vST);
 							if (project->GetTransport().GetSampleRate() > 0)
-								vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+								vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 							mContext.undoManager.Push(std::make_unique<ProcessorPresenceAction>(project, selectedTrack, vST, i, true));
 						}
 					}
@@ -186,7 +186,7 @@ void DeviceRackView::Render(const ImVec2& pos, float width, float height) {
 						std::lock_guard<std::mutex> lock(project->GetMutex());
 						selectedTrack->InsertProcessor(i, proc);
 						if (project->GetTransport().GetSampleRate() > 0)
-							proc->PrepareToPlay(project->GetTransport().GetSampleRate());
+							proc->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 						mContext.undoManager.Push(std::make_unique<ProcessorPresenceAction>(project, selectedTrack, proc, i, true));
 					}
 				}
@@ -370,9 +370,9 @@ void DeviceRackView::Render(const ImVec2& pos, float width, float height) {
 
 		// handle actions
 		if (hasAction) {
-			// lock during graph modification
-			// this prevents the audio thread from iterating the processors list
-			// while we are removing an item -> unloading its DLL
+			// lock during graph modification. the audio thread keeps playing the published
+			// snapshot, which holds its own reference, so a removed plugin's DLL is only
+			// unloaded once that snapshot is retired on the UI thread
 			std::lock_guard<std::mutex> lock(project->GetMutex());
 
 			if (action.type == PendingAction::MoveReq) {
@@ -390,7 +390,7 @@ void DeviceRackView::Render(const ImVec2& pos, float width, float height) {
 				auto clone = CloneProcessor(processors[action.srcIdx]);
 				if (clone) {
 					if (project->GetTransport().GetSampleRate() > 0)
-						clone->PrepareToPlay(project->GetTransport().GetSampleRate());
+						clone->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					selectedTrack->InsertProcessor(action.srcIdx + 1, clone);
 					mContext.undoManager.Push(std::make_unique<ProcessorPresenceAction>(project, selectedTrack, clone, action.srcIdx + 1, true));
 				}
@@ -398,7 +398,7 @@ void DeviceRackView::Render(const ImVec2& pos, float width, float height) {
 				auto clone = CloneProcessor(mContext.state.processorClipboard);
 				if (clone) {
 					if (project->GetTransport().GetSampleRate() > 0)
-						clone->PrepareToPlay(project->GetTransport().GetSampleRate());
+						clone->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					selectedTrack->InsertProcessor(action.dstIdx, clone);
 					mContext.undoManager.Push(std::make_unique<ProcessorPresenceAction>(project, selectedTrack, clone, action.dstIdx, true));
 				}
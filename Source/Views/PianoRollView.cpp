@@ -103,7 +103,7 @@ void PianoRollView::EndGesture(MIDIClip* clip) {
 	if (!clip)
 		return;
 
-	auto clipShared = std::dynamic_pointer_cast<MIDIClip>(mContext.state.selectedClip);
+	auto clipShared = ClipCast<MIDIClip>(mContext.state.selectedClip);
 	Project* project = mContext.GetProject();
 	if (!clipShared || clipShared.get() != clip || !project)
 		return;
@@ -117,7 +117,7 @@ void PianoRollView::EndGesture(MIDIClip* clip) {
 }
 
 void PianoRollView::Render() {
-	auto midiClipShared = std::dynamic_pointer_cast<MIDIClip>(mContext.state.selectedClip);
+	auto midiClipShared = ClipCast<MIDIClip>(mContext.state.selectedClip);
 	if (!midiClipShared) {
 		// the piano roll is closed for this frame: make sure a held preview note
 		// does not get stuck sounding forever
@@ -140,8 +140,9 @@ void PianoRollView::Render() {
 		return;
 	}
 
-	// scoped project lock: locks only when a project exists, so mutations never
-	// race the audio thread reading the same note vector in Track::ProcessBlock
+	// scoped project lock: locks only when a project exists, so note edits never
+	// interleave with an export or load. the audio thread plays a published copy
+	// of the notes and picks the edit up on the next Project::PublishGraph
 	auto lockProject = [&]() -> std::unique_lock<std::mutex> {
 		if (project)
 			return std::unique_lock<std::mutex>(project->GetMutex());
@@ -152,7 +153,7 @@ void PianoRollView::Render() {
 	auto pushNoteEdit = [&](const std::vector<MIDINote>& before, const char* name) {
 		if (!project)
 			return;
-		const auto& after = mIDIClip->GetNotesEx();
+		const auto& after = mIDIClip->GetNotes();
 		if (after != before)
 			mContext.undoManager.Push(std::make_unique<NoteEditAction>(project, midiClipShared, before, after, name));
 	};
@@ -217,7 +218,7 @@ void PianoRollView::Render() {
 
 	// ---- content sizing ----
 	double maxDuration = std::max(mIDIClip->GetDuration(), 4.0);
-	for (const auto& n : mIDIClip->GetNotesEx()) {
+	for (const auto& n : mIDIClip->GetNotes()) {
 		if (n.startBeat + n.durationBeats > maxDuration)
 			maxDuration = n.startBeat + n.durationBeats;
 	}
@@ -464,6 +465,7 @@ void PianoRollView::Render() {
 					{
 						auto lk = lockProject();
 						notes.push_back(newNote);
+						mIDIClip->NotesChanged();
 					}
 					mSelectedIndices.clear();
 					mSelectedIndices.push_back((int)notes.size() - 1);
@@ -514,6 +516,7 @@ void PianoRollView::Render() {
 				note.startBeat = newStart;
 				note.noteNumber = std::clamp(pair.second.originalNoteNum + deltaSemis, 0, 127);
 			}
+			mIDIClip->NotesChanged();
 		} else if (isMouseDown && mInteraction == InteractionMode::ResizingNotes) {
 			ImVec2 delta = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left, 0.0f);
 			double deltaBeats = delta.x / PPB;
@@ -529,6 +532,7 @@ void PianoRollView::Render() {
 					newDur = snapGrid;
 				note.durationBeats = newDur;
 			}
+			mIDIClip->NotesChanged();
 		}
 
 		// c. notes
@@ -676,6 +680,7 @@ void PianoRollView::Render() {
 			mContext.state.selectionStart = absoluteBeat;
 			mContext.state.selectionEnd = absoluteBeat;
 			transport->SetLoopRange(0, 0);
+			project->MarkEdited();
 		}
 	}
 	ImGui::EndChild();
@@ -800,6 +805,7 @@ void PianoRollView::Render() {
 					if (i >= 0 && i < (int)notes.size())
 						notes[i].velocity = vel;
 				}
+				mIDIClip->NotesChanged();
 			}
 
 			// draw a thin stem + dot per note (like Ableton) so dense / overlapping
@@ -849,6 +855,7 @@ void PianoRollView::Render() {
 					if (idx >= 0 && idx < (int)notes.size())
 						notes.erase(notes.begin() + idx);
 				}
+				mIDIClip->NotesChanged();
 			}
 			mSelectedIndices.clear();
 			pushNoteEdit(before, "Delete notes");
@@ -879,6 +886,7 @@ void PianoRollView::Render() {
 						if (dSemi != 0)
 							notes[i].noteNumber = std::clamp(notes[i].noteNumber + dSemi, 0, 127);
 					}
+					mIDIClip->NotesChanged();
 				}
 				pushNoteEdit(before, dSemi != 0 ? "Nudge pitch" : "Nudge time");
 			}
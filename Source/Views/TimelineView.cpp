@@ -257,7 +257,7 @@ void TimelineView::Render(const ImVec2& pos, float width, float height, TrackLis
 					if (vST->Load()) {
 						newTrack->AddProcessor(vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					}
 					mContext.state.selectedTrackIndex = (int)allTracks.size() - 1;
 				}
@@ -279,7 +279,7 @@ void TimelineView::Render(const ImVec2& pos, float width, float height, TrackLis
 						if (vST->Load()) {
 							newTrack->AddProcessor(vST);
 							if (project->GetTransport().GetSampleRate() > 0)
-								vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+								vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 						}
 						mContext.state.selectedTrackIndex = (int)allTracks.size() - 1;
 					}
@@ -297,7 +297,7 @@ void TimelineView::Render(const ImVec2& pos, float width, float height, TrackLis
 						newTrack->SetName(type);
 						newTrack->AddProcessor(proc);
 						if (project->GetTransport().GetSampleRate() > 0)
-							proc->PrepareToPlay(project->GetTransport().GetSampleRate());
+							proc->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 						mContext.state.selectedTrackIndex = (int)allTracks.size() - 1;
 					}
 				}
@@ -109,7 +109,7 @@ void TimelineClipRenderer::Render(EditorContext& context, TimelineInteractionSta
 					interaction.triggerRenamePopup = true;
 					ImGui::CloseCurrentPopup();
 				}
-				auto mIDIClip = std::dynamic_pointer_cast<MIDIClip>(clip);
+				auto mIDIClip = ClipCast<MIDIClip>(clip);
 				if (mIDIClip) {
 					if (ImGui::Selectable("Make Unique")) {
 						mIDIClip->MakeUnique();
@@ -200,7 +200,7 @@ void TimelineClipRenderer::Render(EditorContext& context, TimelineInteractionSta
 						newDur = context.state.timelineGrid;
 
 					// check audio limits
-					auto audioClip = std::dynamic_pointer_cast<AudioClip>(clip);
+					auto audioClip = ClipCast<AudioClip>(clip);
 					if (audioClip) {
 						double projectBpm = project ? project->GetTransport().GetBpm() : 120.0;
 						double maxDur = audioClip->GetMaxDurationInBeats(projectBpm);
@@ -341,12 +341,13 @@ void TimelineClipRenderer::DrawClipContent(ImDrawList* drawList,
 	double effectiveOffset = (overrideOffset >= 0.0) ? overrideOffset : clip->GetOffset();
 	double effectiveDuration = (overrideDuration >= 0.0) ? overrideDuration : clip->GetDuration();
 
-	auto audioClip = std::dynamic_pointer_cast<AudioClip>(clip);
-	auto mIDIClip = std::dynamic_pointer_cast<MIDIClip>(clip);
+	auto audioClip = ClipCast<AudioClip>(clip);
+	auto mIDIClip = ClipCast<MIDIClip>(clip);
 
 	if (audioClip) {
-		const auto& samples = audioClip->GetSamples();
-		if (!samples.empty()) {
+		const float* samples = audioClip->GetSamples();
+		auto peaks = audioClip->GetPeaks();
+		if (samples || peaks) {
 			int channels = audioClip->GetNumChannels();
 
 			ImU32 waveColor = customWaveColor != 0
@@ -381,7 +382,7 @@ void TimelineClipRenderer::DrawClipContent(ImDrawList* drawList,
 			double offsetOutputFrames = offsetSeconds * projectSR;
 			double offsetSourceFrames = offsetOutputFrames * playbackRate;
 
-			TimelineUtils::RenderWaveform(drawList, samples, channels, sourceFramesPerPixel, offsetSourceFrames, pMin, pMax, waveColor);
+			TimelineUtils::RenderWaveform(drawList, peaks.get(), samples, audioClip->GetNumSamples(), channels, sourceFramesPerPixel, offsetSourceFrames, pMin, pMax, waveColor);
 		}
 	}
 
@@ -389,7 +390,7 @@ void TimelineClipRenderer::DrawClipContent(ImDrawList* drawList,
 		ImGui::SetCursorScreenPos(ImVec2(pMin.x + 2, pMax.y - 12));
 		ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(Theme::WithAlpha(th.textOnAccent, 128)), "MIDI");
 
-		const auto& notes = mIDIClip->GetNotesEx();
+		const auto& notes = mIDIClip->GetNotes();
 		float clipWidth = pMax.x - pMin.x;
 
 		ImU32 noteColor = customMIDIColor != 0
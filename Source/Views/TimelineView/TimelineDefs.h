@@ -94,10 +94,10 @@ struct TimelineInteractionState {
 inline std::shared_ptr<Clip> CloneClip(std::shared_ptr<Clip> source) {
 	if (!source)
 		return nullptr;
-	if (auto ac = std::dynamic_pointer_cast<AudioClip>(source)) {
+	if (auto ac = source->As<AudioClip>()) {
 		return std::make_shared<AudioClip>(*ac);
 	}
-	if (auto mc = std::dynamic_pointer_cast<MIDIClip>(source)) {
+	if (auto mc = source->As<MIDIClip>()) {
 		return std::make_shared<MIDIClip>(*mc);
 	}
 	return nullptr;
@@ -91,7 +91,7 @@ void TimelineTrackView::RenderTracks(EditorContext& context, TimelineInteraction
 				if (vST->Load()) {
 					t->AddProcessor(vST);
 					if (project->GetTransport().GetSampleRate() > 0)
-						vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+						vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 				}
 			}
 			if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("VST3_PLUGIN")) {
@@ -104,7 +104,7 @@ void TimelineTrackView::RenderTracks(EditorContext& context, TimelineInteraction
 					if (vST->Load()) {
 						t->AddProcessor(vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					}
 				}
 			}
@@ -115,7 +115,7 @@ void TimelineTrackView::RenderTracks(EditorContext& context, TimelineInteraction
 				if (proc) {
 					t->AddProcessor(proc);
 					if (project->GetTransport().GetSampleRate() > 0)
-						proc->PrepareToPlay(project->GetTransport().GetSampleRate());
+						proc->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 				}
 			}
 			ImGui::EndDragDropTarget();
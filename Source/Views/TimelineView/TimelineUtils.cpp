@@ -1,19 +1,32 @@
 #include "PrecompHeader.h"
 #include "TimelineUtils.h"
 #include "Theme.h"
+#include "Clips/WaveformPeaks.h"
 #include <cmath>
 #include <algorithm>
 
 namespace TimelineUtils {
 
-	void RenderWaveform(ImDrawList* drawList, const std::vector<float>& samples, int channels,
+	void RenderWaveform(ImDrawList* drawList, const WaveformPeaks* peaks, const float* samples, size_t numSamples, int channels,
 						double sourceFramesPerPixel, double offsetFrames,
 						const ImVec2& rectMin, const ImVec2& rectMax,
 						ImU32 color, bool forceMono) {
-		if (samples.empty())
+		if (samples && numSamples == 0)
+			samples = nullptr;
+		if (peaks && (peaks->levels.empty() || peaks->channels != channels))
+			peaks = nullptr;
+		if (!samples && !peaks)
 			return;
 
-		size_t totalFileFrames = samples.size() / channels;
+		size_t totalFileFrames = samples ? numSamples / channels : (size_t)peaks->numFrames;
+
+		// the level to draw from, or null to draw the samples themselves
+		const PeakLevel* level = peaks ? peaks->FindLevel(sourceFramesPerPixel) : nullptr;
+		if (peaks && !level && !samples)
+			level = &peaks->levels.front();
+
+		// peaks in a lighter shade of the waveform, the rms body solid inside them
+		ImU32 peakColor = Theme::WithAlpha(color, (int)((color >> IM_COL32_A_SHIFT) & 0xFF) * 3 / 5);
 
 		// viewport culling
 		ImVec2 clipMin = drawList->GetClipRectMin();
@@ -50,7 +63,57 @@ namespace TimelineUtils {
 			if (visStart >= visEnd)
 				return;
 
-			if (sourceFramesPerPixel > 1.0) {
+			auto DrawBar = [&](double frameStart, double frameEnd, float minVal, float maxVal, float rms) {
+				float x0 = FrameToX(frameStart);
+				float x1 = FrameToX(frameEnd);
+				if (x1 < x0 + 1.0f)
+					x1 = x0 + 1.0f;
+
+				float y1 = midY + minVal * halfH;
+				float y2 = midY + maxVal * halfH;
+				if (std::abs(y2 - y1) < 1.0f) {
+					y1 -= 0.5f;
+					y2 += 0.5f;
+				}
+				drawList->AddRectFilled(ImVec2(x0, y1), ImVec2(x1, y2), peakColor);
+
+				// the rms body, kept inside the peaks it came from
+				float r1 = std::max(y1, midY - rms * halfH);
+				float r2 = std::min(y2, midY + rms * halfH);
+				if (r2 > r1)
+					drawList->AddRectFilled(ImVec2(x0, r1), ImVec2(x1, r2), color);
+			};
+
+			if (level) {
+				// whole groups of bins make one bar about a pixel wide. groups sit on an absolute
+				// grid of the level's bins, so like the sample bins below, a bar's extent and
+				// value never change as the clip scrolls
+				uint64_t group = (uint64_t)std::max(1.0, std::round(sourceFramesPerPixel / level->framesPerBin));
+				uint64_t groupFrames = group * level->framesPerBin;
+				uint64_t firstGroup = (uint64_t)visStart / groupFrames;
+				uint64_t lastGroup = ((uint64_t)visEnd + groupFrames - 1) / groupFrames;
+
+				for (uint64_t g = firstGroup; g < lastGroup; ++g) {
+					uint64_t firstBin = g * group;
+					uint64_t lastBin = std::min(firstBin + group, level->numBins);
+					if (firstBin >= lastBin)
+						break;
+
+					int lo = INT16_MAX, hi = INT16_MIN;
+					float sumSquares = 0.0f;
+					for (uint64_t b = firstBin; b < lastBin; ++b) {
+						const int16_t* v = level->GetBin(b, peaks->channels, channelIdx);
+						lo = std::min(lo, (int)v[0]);
+						hi = std::max(hi, (int)v[1]);
+						sumSquares += (float)v[2] * (float)v[2];
+					}
+
+					constexpr float kScale = 1.0f / 32767.0f;
+					double frameEnd = std::min((double)(g * groupFrames + groupFrames), (double)totalFileFrames);
+					DrawBar((double)(g * groupFrames), frameEnd, lo * kScale, hi * kScale,
+							std::sqrt(sumSquares / (float)(lastBin - firstBin)) * kScale);
+				}
+			} else if (sourceFramesPerPixel > 1.0) {
 				// fixed peak bins anchored to an ABSOLUTE sample grid (multiples of
 				// binFrames), NOT to the moving screen columns. each bin covers a constant
 				// source-frame range, so its min/max never changes as the clip scrolls
@@ -69,38 +132,27 @@ namespace TimelineUtils {
 					if (idxEnd > totalFileFrames)
 						idxEnd = totalFileFrames;
 
-					float minVal = 0.0f, maxVal = 0.0f;
-					bool firstSample = true;
+					float minVal = 0.0f, maxVal = 0.0f, sumSquares = 0.0f;
+					int count = 0;
 
 					for (size_t k = idxStart; k < idxEnd; k += scanStep) {
 						float v = samples[k * channels + channelIdx];
-						if (firstSample) {
+						if (count == 0) {
 							minVal = maxVal = v;
-							firstSample = false;
 						} else {
 							if (v < minVal)
 								minVal = v;
 							if (v > maxVal)
 								maxVal = v;
 						}
+						sumSquares += v * v;
+						++count;
 					}
 
-					if (firstSample)
+					if (count == 0)
 						continue;
 
-					float x0 = FrameToX((double)idxStart);
-					float x1 = FrameToX((double)idxEnd);
-					if (x1 < x0 + 1.0f)
-						x1 = x0 + 1.0f;
-
-					float y1 = midY + minVal * halfH;
-					float y2 = midY + maxVal * halfH;
-					if (std::abs(y2 - y1) < 1.0f) {
-						y1 -= 0.5f;
-						y2 += 0.5f;
-					}
-
-					drawList->AddRectFilled(ImVec2(x0, y1), ImVec2(x1, y2), color);
+					DrawBar((double)idxStart, (double)idxEnd, minVal, maxVal, std::sqrt(sumSquares / count));
 				}
 			} else {
 				// one sample spans >= 1px: trace a poly-line through the actual samples,
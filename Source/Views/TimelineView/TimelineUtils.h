@@ -2,12 +2,20 @@
 #include "imgui.h"
 #include <vector>
 
+struct WaveformPeaks;
+
 namespace TimelineUtils {
 	// renders audio waveform into the given drawList within rectMin/rectMax
+	// peaks: the file's pyramid; zoomed out it is drawn from the matching level, so the cost is
+	// per pixel, not per sample. null (still being built) falls back to scanning samples
+	// samples: the raw audio, for zooming in past the finest level. null for a streamed clip,
+	// which then draws level 0 at any zoom
 	// sourceFramesPerPixel: defines density
 	// offsetFrames: how many source frames into the file to start drawing (supports clip offset)
 	void RenderWaveform(ImDrawList* drawList,
-						const std::vector<float>& samples,
+						const WaveformPeaks* peaks,
+						const float* samples,
+						size_t numSamples,
 						int channels,
 						double sourceFramesPerPixel,
 						double offsetFrames,
@@ -184,7 +184,7 @@ void TrackListView::Render(const ImVec2& fixedPos, float width, float height, fl
 					std::lock_guard<std::mutex> lock(project->GetMutex());
 					track->AddProcessor(vST);
 					if (project->GetTransport().GetSampleRate() > 0)
-						vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+						vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 				}
 			}
 			if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("VST3_PLUGIN")) {
@@ -198,7 +198,7 @@ void TrackListView::Render(const ImVec2& fixedPos, float width, float height, fl
 						std::lock_guard<std::mutex> lock(project->GetMutex());
 						track->AddProcessor(vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					}
 				}
 			}
@@ -210,7 +210,7 @@ void TrackListView::Render(const ImVec2& fixedPos, float width, float height, fl
 					std::lock_guard<std::mutex> lock(project->GetMutex());
 					track->AddProcessor(proc);
 					if (project->GetTransport().GetSampleRate() > 0)
-						proc->PrepareToPlay(project->GetTransport().GetSampleRate());
+						proc->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 				}
 			}
 			ImGui::EndDragDropTarget();
@@ -486,7 +486,7 @@ void TrackListView::Render(const ImVec2& fixedPos, float width, float height, fl
 					std::lock_guard<std::mutex> lock(project->GetMutex());
 					master->AddProcessor(vST);
 					if (project->GetTransport().GetSampleRate() > 0)
-						vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+						vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 				}
 			}
 			if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("VST3_PLUGIN")) {
@@ -500,7 +500,7 @@ void TrackListView::Render(const ImVec2& fixedPos, float width, float height, fl
 						std::lock_guard<std::mutex> lock(project->GetMutex());
 						master->AddProcessor(vST);
 						if (project->GetTransport().GetSampleRate() > 0)
-							vST->PrepareToPlay(project->GetTransport().GetSampleRate());
+							vST->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 					}
 				}
 			}
@@ -512,7 +512,7 @@ void TrackListView::Render(const ImVec2& fixedPos, float width, float height, fl
 					std::lock_guard<std::mutex> lock(project->GetMutex());
 					master->AddProcessor(proc);
 					if (project->GetTransport().GetSampleRate() > 0)
-						proc->PrepareToPlay(project->GetTransport().GetSampleRate());
+						proc->PrepareToPlay(project->GetTransport().GetSampleRate(), project->GetMaxBlockFrames());
 				}
 			}
 			ImGui::EndDragDropTarget();
@@ -46,6 +46,7 @@ void TransportView::Render(const ImVec2& pos, float width, float height) {
 		}
 		if (ImGui::Button("Loop", ImVec2(40 * mContext.state.mainScale, 0))) {
 			transport->SetLoopEnabled(!isLooping);
+			project->MarkEdited(); // saved with the project, but not undoable
 		}
 		if (isLooping)
 			ImGui::PopStyleColor(3);
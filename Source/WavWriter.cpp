@@ -0,0 +1,477 @@
+#include "PrecompHeader.h"
+#include "WavWriter.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WAV_SSE2 1
+#endif
+
+namespace {
+
+constexpr size_t kWriteChunkBytes = 1 << 20;
+constexpr size_t kConvertSamples = 4096; // converted per pass through Quantize/Pack
+
+constexpr uint16_t kFormatPCM = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+// KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT: the format tag, then a fixed tail
+constexpr uint8_t kSubFormatTail[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+// RIFF(12) + JUNK/ds64(8+28), then fmt, fact for anything but plain pcm, and the data header
+constexpr std::streamoff kRiffSizeOffset = 4;
+constexpr std::streamoff kDs64Offset = 12;
+constexpr std::streamoff kFmtOffset = 48;
+
+// 3-tap f-weighted error filter (wannamaker). noise goes where hearing is least sensitive
+constexpr double kShapingTaps[3] = {1.623, -0.982, 0.109};
+
+void PutU16(uint8_t* p, uint16_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+void PutU32(uint8_t* p, uint32_t v) {
+	for (int i = 0; i < 4; ++i)
+		p[i] = (uint8_t)(v >> (8 * i));
+}
+
+void PutU64(uint8_t* p, uint64_t v) {
+	for (int i = 0; i < 8; ++i)
+		p[i] = (uint8_t)(v >> (8 * i));
+}
+
+int BytesPerSample(WavSampleFormat format) {
+	switch (format) {
+	case WavSampleFormat::Int16:
+		return 2;
+	case WavSampleFormat::Int24:
+		return 3;
+	case WavSampleFormat::Int32:
+	case WavSampleFormat::Float32:
+		return 4;
+	case WavSampleFormat::Float64:
+		return 8;
+	}
+	return 2;
+}
+
+bool IsFloat(WavSampleFormat format) {
+	return format == WavSampleFormat::Float32 || format == WavSampleFormat::Float64;
+}
+
+// in[i] * scale rounded to the nearest integer, ties to even (nearbyint in the default rounding
+// mode), and clamped to [lo, hi]. both ends are integers, so clamping before rounding is the
+// same and keeps the conversion in range. the vector path does the same double arithmetic
+void QuantizeFloats(const float* in, size_t count, double scale, double lo, double hi, int32_t* out) {
+	size_t i = 0;
+#ifdef WAV_SSE2
+	__m128d vScale = _mm_set1_pd(scale), vLo = _mm_set1_pd(lo), vHi = _mm_set1_pd(hi);
+	for (; i + 4 <= count; i += 4) {
+		__m128 f = _mm_loadu_ps(in + i);
+		__m128d a = _mm_mul_pd(_mm_cvtps_pd(f), vScale);
+		__m128d b = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), vScale);
+		a = _mm_min_pd(_mm_max_pd(a, vLo), vHi);
+		b = _mm_min_pd(_mm_max_pd(b, vLo), vHi);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b)));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = (int32_t)std::nearbyint(std::clamp((double)in[i] * scale, lo, hi));
+}
+
+// the same for values already scaled (and dithered)
+void QuantizeDoubles(const double* in, size_t count, double lo, double hi, int32_t* out) {
+	size_t i = 0;
+#ifdef WAV_SSE2
+	__m128d vLo = _mm_set1_pd(lo), vHi = _mm_set1_pd(hi);
+	for (; i + 4 <= count; i += 4) {
+		__m128d a = _mm_min_pd(_mm_max_pd(_mm_loadu_pd(in + i), vLo), vHi);
+		__m128d b = _mm_min_pd(_mm_max_pd(_mm_loadu_pd(in + i + 2), vLo), vHi);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b)));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = (int32_t)std::nearbyint(std::clamp(in[i], lo, hi));
+}
+
+// 16-bit little endian from samples already in range
+void PackInt16(const int32_t* in, size_t count, uint8_t* out) {
+	size_t i = 0;
+#ifdef WAV_SSE2
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(in + i + 4));
+		_mm_storeu_si128((__m128i*)(out + i * 2), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; i < count; ++i) {
+		int16_t v = (int16_t)in[i];
+		memcpy(out + i * 2, &v, 2);
+	}
+}
+
+void WidenFloats(const float* in, size_t count, uint8_t* out) {
+	size_t i = 0;
+#ifdef WAV_SSE2
+	for (; i + 4 <= count; i += 4) {
+		__m128 f = _mm_loadu_ps(in + i);
+		_mm_storeu_pd((double*)(out + i * 8), _mm_cvtps_pd(f));
+		_mm_storeu_pd((double*)(out + i * 8 + 16), _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+	}
+#endif
+	for (; i < count; ++i) {
+		double v = in[i];
+		memcpy(out + i * 8, &v, 8);
+	}
+}
+
+} // namespace
+
+const char* GetWavSampleFormatName(WavSampleFormat format) {
+	switch (format) {
+	case WavSampleFormat::Int16:
+		return "16-bit";
+	case WavSampleFormat::Int24:
+		return "24-bit";
+	case WavSampleFormat::Int32:
+		return "32-bit";
+	case WavSampleFormat::Float32:
+		return "32-bit float";
+	case WavSampleFormat::Float64:
+		return "64-bit float";
+	}
+	return "";
+}
+
+const char* GetWavDitherName(WavDither dither) {
+	switch (dither) {
+	case WavDither::None:
+		return "None";
+	case WavDither::Triangular:
+		return "TPDF";
+	case WavDither::NoiseShaped:
+		return "Noise shaped";
+	}
+	return "";
+}
+
+WavWriter::~WavWriter() {
+	if (IsOpen())
+		Close();
+}
+
+bool WavWriter::Open(const std::string& path, const WavFormat& format) {
+	if (IsOpen())
+		Close();
+	if (format.channels < 1 || format.sampleRate == 0)
+		return false;
+
+	mFile.open(path, std::ios::binary | std::ios::trunc);
+	if (!mFile.is_open())
+		return false;
+
+	mFormat = format;
+	mBytesPerSample = BytesPerSample(format.sampleFormat);
+	mFramesWritten = 0;
+	mFailed = false;
+	mBuffer.resize(kWriteChunkBytes);
+	mBufferUsed = 0;
+	mScratch.resize(kConvertSamples);
+	mQuantized.resize(kConvertSamples);
+	mShapingError.assign((size_t)format.channels * 3, 0.0);
+
+	WriteHeader();
+	return !mFile.fail();
+}
+
+void WavWriter::WriteHeader() {
+	bool isFloat = IsFloat(mFormat.sampleFormat);
+	uint16_t bits = (uint16_t)(mBytesPerSample * 8);
+	uint16_t blockAlign = (uint16_t)(mFormat.channels * mBytesPerSample);
+
+	// plain pcm only for what every reader takes (16-bit, mono or stereo). deeper pcm and more
+	// channels need WAVE_FORMAT_EXTENSIBLE to be read unambiguously, and anything that isn't
+	// plain pcm carries a cbSize and a fact chunk
+	bool extensible = (!isFloat && bits > 16) || mFormat.channels > 2;
+	uint16_t tag = extensible ? kFormatExtensible : isFloat ? kFormatFloat : kFormatPCM;
+	uint32_t fmtBytes = extensible ? 40 : tag == kFormatPCM ? 16 : 18;
+	bool hasFact = tag != kFormatPCM;
+
+	std::vector<uint8_t> h(kFmtOffset + 8 + fmtBytes + (hasFact ? 12 : 0) + 8, 0);
+	memcpy(h.data(), "RIFF", 4);
+	memcpy(h.data() + 8, "WAVE", 4);
+	// placeholder that becomes ds64 if the file outgrows 32-bit sizes (ebu tech 3306)
+	memcpy(h.data() + kDs64Offset, "JUNK", 4);
+	PutU32(h.data() + kDs64Offset + 4, 28);
+
+	uint8_t* fmt = h.data() + kFmtOffset;
+	memcpy(fmt, "fmt ", 4);
+	PutU32(fmt + 4, fmtBytes);
+	PutU16(fmt + 8, tag);
+	PutU16(fmt + 10, (uint16_t)mFormat.channels);
+	PutU32(fmt + 12, mFormat.sampleRate);
+	PutU32(fmt + 16, mFormat.sampleRate * blockAlign);
+	PutU16(fmt + 20, blockAlign);
+	PutU16(fmt + 22, bits);
+	if (fmtBytes > 16)
+		PutU16(fmt + 24, (uint16_t)(fmtBytes - 18)); // cbSize
+	if (extensible) {
+		PutU16(fmt + 26, bits); // valid bits
+		// front center / front left+right; more channels are left unassigned
+		PutU32(fmt + 28, mFormat.channels == 1 ? 0x4 : mFormat.channels == 2 ? 0x3 : 0);
+		PutU16(fmt + 32, isFloat ? kFormatFloat : kFormatPCM);
+		memcpy(fmt + 34, kSubFormatTail, sizeof(kSubFormatTail));
+	}
+
+	std::streamoff at = kFmtOffset + 8 + fmtBytes;
+	mFactOffset = -1;
+	if (hasFact) {
+		// frames per channel, patched in Close
+		memcpy(h.data() + at, "fact", 4);
+		PutU32(h.data() + at + 4, 4);
+		mFactOffset = at + 8;
+		at += 12;
+	}
+	memcpy(h.data() + at, "data", 4);
+	mDataSizeOffset = at + 4;
+	mHeaderBytes = at + 8;
+
+	mFile.write((const char*)h.data(), (std::streamsize)h.size());
+}
+
+void WavWriter::Quantize(const float* in, size_t numSamples) {
+	int32_t* out = mQuantized.data();
+	int bits = mBytesPerSample * 8;
+	double scale = std::ldexp(1.0, bits - 1);
+	double lo = -scale;
+	double hi = scale - 1.0;
+
+	WavDither dither = bits <= 24 ? mFormat.dither : WavDither::None;
+	if (dither == WavDither::None) {
+		QuantizeFloats(in, numSamples, scale, lo, hi, out);
+		return;
+	}
+
+	// tpdf: the sum of two independent uniform values, each in [-0.5, 0.5) lsb
+	uint32_t r = mRandom;
+	auto uniform = [&r]() {
+		r ^= r << 13;
+		r ^= r >> 17;
+		r ^= r << 5;
+		return (double)r * (1.0 / 4294967296.0) - 0.5;
+	};
+
+	if (dither == WavDither::Triangular) {
+		// the noise is serial; rounding it in is not
+		double* dithered = mScratch.data();
+		for (size_t i = 0; i < numSamples; ++i)
+			dithered[i] = (double)in[i] * scale + uniform() + uniform();
+		QuantizeDoubles(dithered, numSamples, lo, hi, out);
+		mRandom = r;
+		return;
+	}
+
+	// the error feedback runs per channel and can't be vectorized across time
+	int channels = mFormat.channels;
+	for (size_t i = 0; i < numSamples; ++i) {
+		double* e = &mShapingError[(i % channels) * 3];
+		double target = (double)in[i] * scale - (kShapingTaps[0] * e[0] + kShapingTaps[1] * e[1] + kShapingTaps[2] * e[2]);
+		double q = std::clamp(std::nearbyint(target + uniform() + uniform()), lo, hi);
+		e[2] = e[1];
+		e[1] = e[0];
+		// clipped samples would feed back a huge error and make the filter ring
+		e[0] = std::clamp(q - target, -1.0, 1.0);
+		out[i] = (int32_t)q;
+	}
+	mRandom = r;
+}
+
+void WavWriter::Pack(size_t numSamples, uint8_t* out) const {
+	const int32_t* in = mQuantized.data();
+	switch (mFormat.sampleFormat) {
+	case WavSampleFormat::Int16:
+		PackInt16(in, numSamples, out);
+		break;
+	case WavSampleFormat::Int24:
+		for (size_t i = 0; i < numSamples; ++i) {
+			int32_t v = in[i];
+			out[i * 3 + 0] = (uint8_t)v;
+			out[i * 3 + 1] = (uint8_t)(v >> 8);
+			out[i * 3 + 2] = (uint8_t)(v >> 16);
+		}
+		break;
+	case WavSampleFormat::Int32:
+		memcpy(out, in, numSamples * 4); // little endian already
+		break;
+	default:
+		break; // float formats skip Quantize and are packed in Write
+	}
+}
+
+bool WavWriter::Write(const float* interleaved, int64_t numFrames) {
+	if (!IsOpen() || mFailed)
+		return false;
+
+	size_t total = (size_t)numFrames * mFormat.channels;
+	size_t done = 0;
+	while (done < total) {
+		size_t room = (mBuffer.size() - mBufferUsed) / mBytesPerSample;
+		if (room == 0) {
+			if (!FlushBuffer())
+				return false;
+			continue;
+		}
+
+		size_t count = std::min({total - done, room, kConvertSamples});
+		const float* in = interleaved + done;
+		uint8_t* out = mBuffer.data() + mBufferUsed;
+
+		if (mFormat.sampleFormat == WavSampleFormat::Float32) {
+			memcpy(out, in, count * sizeof(float));
+		} else if (mFormat.sampleFormat == WavSampleFormat::Float64) {
+			WidenFloats(in, count, out);
+		} else {
+			Quantize(in, count);
+			Pack(count, out);
+		}
+
+		mBufferUsed += count * mBytesPerSample;
+		done += count;
+	}
+
+	mFramesWritten += numFrames;
+	return true;
+}
+
+bool WavWriter::FlushBuffer() {
+	if (mBufferUsed > 0) {
+		mFile.write((const char*)mBuffer.data(), (std::streamsize)mBufferUsed);
+		mBufferUsed = 0;
+	}
+	if (mFile.fail())
+		mFailed = true;
+	return !mFailed;
+}
+
+bool WavWriter::Close() {
+	if (!IsOpen())
+		return false;
+
+	FlushBuffer();
+
+	uint64_t dataBytes = (uint64_t)mFramesWritten * mFormat.channels * mBytesPerSample;
+	if (dataBytes & 1)
+		mFile.put(0); // chunks are word aligned
+	uint64_t riffBytes = (uint64_t)mHeaderBytes - 8 + dataBytes + (dataBytes & 1);
+
+	uint8_t size[4];
+	if (riffBytes <= 0xFFFFFFFFu) {
+		PutU32(size, (uint32_t)riffBytes);
+		mFile.seekp(kRiffSizeOffset);
+		mFile.write((const char*)size, 4);
+		PutU32(size, (uint32_t)dataBytes);
+		mFile.seekp(mDataSizeOffset);
+		mFile.write((const char*)size, 4);
+		if (mFactOffset >= 0) {
+			PutU32(size, (uint32_t)mFramesWritten);
+			mFile.seekp(mFactOffset);
+			mFile.write((const char*)size, 4);
+		}
+	} else {
+		// rf64: the 32-bit fields are pinned to -1 and the real sizes live in ds64
+		uint8_t ds64[36] = {};
+		memcpy(ds64, "ds64", 4);
+		PutU32(ds64 + 4, 28);
+		PutU64(ds64 + 8, riffBytes);
+		PutU64(ds64 + 16, dataBytes);
+		PutU64(ds64 + 24, (uint64_t)mFramesWritten);
+		PutU32(ds64 + 32, 0); // no table entries
+
+		mFile.seekp(0);
+		mFile.write("RF64", 4);
+		PutU32(size, 0xFFFFFFFFu);
+		mFile.write((const char*)size, 4);
+		mFile.seekp(kDs64Offset);
+		mFile.write((const char*)ds64, sizeof(ds64));
+		mFile.seekp(mDataSizeOffset);
+		mFile.write((const char*)size, 4);
+		if (mFactOffset >= 0) {
+			mFile.seekp(mFactOffset); // the frame count is in ds64
+			mFile.write((const char*)size, 4);
+		}
+	}
+
+	bool ok = !mFailed && !mFile.fail();
+	mFile.close();
+	mBuffer.clear();
+	mBuffer.shrink_to_fit();
+	return ok && !mFile.fail();
+}
+
+AsyncWavWriter::~AsyncWavWriter() {
+	if (mThread.joinable())
+		Close();
+}
+
+bool AsyncWavWriter::Open(const std::string& path, const WavFormat& format) {
+	if (mThread.joinable() || !mWriter.Open(path, format))
+		return false;
+	mChannels = format.channels;
+	mHasPending = false;
+	mClosing = false;
+	mFailed = false;
+	mThread = std::thread(&AsyncWavWriter::Run, this);
+	return true;
+}
+
+bool AsyncWavWriter::Write(const float* interleaved, int64_t numFrames) {
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCondition.wait(lock, [this] { return !mHasPending || mFailed; });
+	if (mFailed || !mThread.joinable())
+		return false;
+	mPending.assign(interleaved, interleaved + numFrames * mChannels);
+	mPendingFrames = numFrames;
+	mHasPending = true;
+	mCondition.notify_all();
+	return true;
+}
+
+void AsyncWavWriter::Run() {
+	std::vector<float> batch;
+	for (;;) {
+		int64_t frames;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mHasPending || mClosing; });
+			if (!mHasPending)
+				return; // closing and drained
+			batch.swap(mPending); // the old batch's storage is reused for the next hand-off
+			frames = mPendingFrames;
+			mHasPending = false;
+			mCondition.notify_all();
+		}
+
+		if (!mWriter.Write(batch.data(), frames)) {
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFailed = true;
+			mCondition.notify_all();
+			return;
+		}
+	}
+}
+
+bool AsyncWavWriter::Close() {
+	if (!mThread.joinable())
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mClosing = true;
+	}
+	mCondition.notify_all();
+	mThread.join();
+	bool ok = mWriter.Close();
+	return ok && !mFailed;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class WavSampleFormat {
+	Int16,
+	Int24,
+	Int32,
+	Float32,
+	Float64
+};
+
+// only applied when quantizing to 16/24-bit; 32-bit int and float keep the render as is
+enum class WavDither {
+	None,
+	Triangular, // tpdf, +-1 lsb
+	NoiseShaped // tpdf with the requantization error pushed above ~10 kHz
+};
+
+struct WavFormat {
+	uint32_t sampleRate = 48000;
+	int channels = 2;
+	WavSampleFormat sampleFormat = WavSampleFormat::Int16;
+	WavDither dither = WavDither::Triangular;
+};
+
+const char* GetWavSampleFormatName(WavSampleFormat format);
+const char* GetWavDitherName(WavDither dither);
+
+// streams interleaved float frames to a wav file. the header reserves room for a ds64 chunk,
+// so a file that grows past 4 GB is promoted to rf64 in place on Close() instead of wrapping
+// its 32-bit sizes. 16-bit stereo/mono is plain pcm; deeper pcm and more channels are written
+// as WAVE_FORMAT_EXTENSIBLE, and float with the cbSize and fact chunk the format asks for.
+// converted samples are gathered into a large buffer and written in chunks
+class WavWriter {
+public:
+	WavWriter() = default;
+	~WavWriter(); // closes (and finalizes) a file still open
+
+	WavWriter(const WavWriter&) = delete;
+	WavWriter& operator=(const WavWriter&) = delete;
+
+	bool Open(const std::string& path, const WavFormat& format);
+	bool Write(const float* interleaved, int64_t numFrames);
+	bool Close(); // patches the chunk sizes; false if any write failed
+
+	bool IsOpen() const { return mFile.is_open(); }
+	int64_t GetFramesWritten() const { return mFramesWritten; }
+private:
+	void WriteHeader();
+	bool FlushBuffer();
+	void Quantize(const float* in, size_t numSamples); // into mQuantized, in lsb units
+	void Pack(size_t numSamples, uint8_t* out) const;
+
+	std::ofstream mFile;
+	WavFormat mFormat;
+	int mBytesPerSample = 2;
+	int64_t mFramesWritten = 0;
+	bool mFailed = false;
+	std::streamoff mFactOffset = -1; // the fact chunk's frame count, if the format has one
+	std::streamoff mDataSizeOffset = 0;
+	std::streamoff mHeaderBytes = 0;
+
+	std::vector<uint8_t> mBuffer; // converted bytes waiting for the next write
+	size_t mBufferUsed = 0;
+	std::vector<double> mScratch; // dithered samples before rounding
+	std::vector<int32_t> mQuantized;
+
+	// dither state
+	uint32_t mRandom = 0x9E3779B9u;
+	std::vector<double> mShapingError; // last 3 errors per channel
+};
+
+// a WavWriter on its own thread. Write() copies the frames into a hand-off buffer and returns
+// once the thread has taken the previous batch, so conversion and disk io overlap the render
+class AsyncWavWriter {
+public:
+	AsyncWavWriter() = default;
+	~AsyncWavWriter();
+
+	AsyncWavWriter(const AsyncWavWriter&) = delete;
+	AsyncWavWriter& operator=(const AsyncWavWriter&) = delete;
+
+	bool Open(const std::string& path, const WavFormat& format);
+	bool Write(const float* interleaved, int64_t numFrames);
+	bool Close(); // drains the pending batch first
+private:
+	void Run();
+
+	WavWriter mWriter;
+	int mChannels = 2;
+	std::thread mThread;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::vector<float> mPending;
+	int64_t mPendingFrames = 0;
+	bool mHasPending = false;
+	bool mClosing = false;
+	bool mFailed = false;
+};
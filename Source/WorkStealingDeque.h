@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// fixed-capacity Chase-Lev work-stealing deque (the C11 formulation by Le et al.). the owning
+// thread pushes and pops at the bottom, any other thread may steal from the top. nothing
+// allocates after construction, so it is safe on the audio thread. T must be trivially
+// copyable (the slots are atomics so a racing steal never reads a torn value)
+template <typename T, size_t Capacity>
+class WorkStealingDeque {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "WorkStealingDeque capacity must be a power of two");
+public:
+	// owner only. returns false when full
+	bool Push(T item) {
+		int64_t bottom = mBottom.load(std::memory_order_relaxed);
+		int64_t top = mTop.load(std::memory_order_acquire);
+		if (bottom - top >= (int64_t)Capacity)
+			return false;
+		mItems[bottom & (Capacity - 1)].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// owner only. newest item first (the one most likely still in cache)
+	bool Pop(T& out) {
+		int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+		mBottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = mTop.load(std::memory_order_relaxed);
+
+		if (top > bottom) { // empty
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		out = mItems[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (top < bottom)
+			return true;
+
+		// last item: race the thieves for it
+		bool won = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return won;
+	}
+
+	// any thread. oldest item first; false when empty or when another thread got there first
+	bool Steal(T& out) {
+		int64_t top = mTop.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = mBottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return false;
+
+		T item = mItems[top & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+		out = item;
+		return true;
+	}
+private:
+	// thieves hammer mTop, the owner mBottom: keep them on separate cache lines
+	alignas(64) std::atomic<int64_t> mTop{0};
+	alignas(64) std::atomic<int64_t> mBottom{0};
+	std::array<std::atomic<T>, Capacity> mItems{};
+};